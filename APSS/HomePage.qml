@@ -27,17 +27,30 @@ Page {
                 Layout.fillHeight: true
 
                 metricsList: Constants.isPreviewMode
-                             || !showMetrics ? [] : [["Process FPS", model.processfps], ["Detection FPS", model.detectionfps]]
+                             || !showMetrics ? [] : [["Process FPS", model.processfps], ["Detection FPS", model.detectionfps], ["Escalation %", model.escalationrate], ["Plate Cache %", model.platecachehitrate]]
                 name: Constants.isPreviewMode ? "uknown" : model.name
+                overlayModel: Constants.isPreviewMode ? null : model.overlay
                 visible: true
 
                 Component.onCompleted: function () {
                     // VideoSink must be set, so the engine can forward frames
                     if (!Constants.isPreviewMode) {
                         model.videosink = videoOutput.videoSink
+                        model.previewsize = previewSize
+                        model.previewvisible = previewVisible
                     }
                 }
 
+                onPreviewSizeChanged: function () {
+                    if (!Constants.isPreviewMode)
+                        model.previewsize = previewSize
+                }
+
+                onPreviewVisibleChanged: function () {
+                    if (!Constants.isPreviewMode)
+                        model.previewvisible = previewVisible
+                }
+
                 onShowMetricsChanged: function () {
                     if (liveplaycard.showMetrics)
                         fpsTimer.start()
@@ -55,6 +68,8 @@ Page {
                             // metrics[0][1] = model.camerafps
                             metrics[0][1] = model.processfps
                             metrics[1][1] = model.detectionfps
+                            metrics[2][1] = model.escalationrate
+                            metrics[3][1] = model.platecachehitrate
                         }
 
                         liveplaycard.metricsList = metrics
@@ -64,6 +79,15 @@ Page {
         }
     }
 
+    footer: Label {
+        visible: !Constants.isPreviewMode
+        padding: 4
+        text: Constants.isPreviewMode ? "" : qsTr("Image writer: %1 queued, %2 ms, %3 dropped")
+                                               .arg(apssEngine.engineMetrics.imageWriterQueueDepth)
+                                               .arg(apssEngine.engineMetrics.imageWriterLatency.toFixed(1))
+                                               .arg(apssEngine.engineMetrics.imageWriterDropped)
+    }
+
     Timer {
         id: fpsTimer
 
@@ -17,6 +17,13 @@ Pane {
     property alias videoOutput: videoOutput
     property alias metricsList: metricsPane.metrics
     property bool showMetrics: false
+    property var overlayModel: null
+    // What the engine should render the live frames at, in device pixels, and whether to at all
+    readonly property size previewSize: Qt.size(Math.round(videoOutput.width * Screen.devicePixelRatio),
+                                                 Math.round(videoOutput.height * Screen.devicePixelRatio))
+    readonly property bool previewVisible: visible && width > 0 && height > 0
+                                           && Window.visibility !== Window.Minimized
+                                           && Window.visibility !== Window.Hidden
 
     width: 400
     height: 300
@@ -35,6 +42,36 @@ Pane {
             fillMode: VideoOutput.PreserveAspectFit // Adjust to fit, preserving aspect ratio
         }
 
+        // Predictions of the latest frame, normalized to it. Drawn over the video instead of into it.
+        Item {
+            x: videoOutput.contentRect.x
+            y: videoOutput.contentRect.y
+            width: videoOutput.contentRect.width
+            height: videoOutput.contentRect.height
+
+            Repeater {
+                model: cameraCard.overlayModel
+
+                delegate: Rectangle {
+                    x: model.boxx * parent.width
+                    y: model.boxy * parent.height
+                    width: model.boxwidth * parent.width
+                    height: model.boxheight * parent.height
+                    color: "transparent"
+                    border.color: model.issubprediction ? "yellow" : "red"
+                    border.width: 2
+
+                    Text {
+                        anchors.bottom: parent.top
+                        anchors.left: parent.left
+                        text: model.label
+                        color: parent.border.color
+                        font.pixelSize: 11
+                    }
+                }
+            }
+        }
+
         ColumnLayout {
             anchors {
                 left: parent.left
@@ -31,8 +31,11 @@ constexpr float OCR_MIN_CONF = 0.4f;
 constexpr float OCR_MIN_IOU_THRESH = 0.4f;
 constexpr float DET_RECONSIDER_AREA_INCREASE = 0.30f;   // Percentage, Reconsider sending a seen object to go through the pipeline again, if area is increase by the %.
 constexpr int   TRACKER_DELTA_OBJECT_LIMIT = 40 * 24;   // 40 secs * 24 FPS, 960 ids at the moment
+constexpr float TRACKER_MIN_MATCH_IOU = 0.1f;           // A track is only mapped back to a detection it overlaps at least this much
 constexpr int   TRACK_MAX_EVENTS = 30;                // upto 30 frames
 constexpr int   LPR_MAX_RETRIES = 5;
+constexpr float LPR_SINGLE_LINE_MIN_ASPECT = 2.0f;      // Rectified plates narrower than w/h 2:1 are treated as multi-line
+constexpr float LPR_MIN_QUALITY_GAIN = 0.10f;           // Percentage, a track's next plate is only read if its quality is higher by the %.
 
 const QDir APSS_DIR(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/APSSData");
 const QDir CONFIG_DIR =         APSS_DIR.filePath("config");
@@ -43,6 +46,7 @@ const QDir EXPORT_DIR =         APSS_DIR.filePath("exports");
 const QDir RECORD_DIR =         APSS_DIR.filePath("recordings");
 const QDir CLIPS_DIR =          APSS_DIR.filePath("clips");
 const QDir CLIPS_CACHE_DIR =    CLIPS_DIR.filePath("cache");
+const QDir PREVIEW_DIR =        CLIPS_DIR.filePath("previews");
 const QDir FACE_DIR =           CLIPS_DIR.filePath("faces");
 const QDir THUMB_DIR =          CLIPS_DIR.filePath("thumbs");
 const QDir CACHE_DIR =          APSS_DIR.filePath("tmp/cache");
@@ -20,6 +20,13 @@ extern "C" {
 
 Q_STATIC_LOGGING_CATEGORY(logger, "apss.camera.capture")
 
+namespace {
+
+// Packets a consumer of the capture can fall behind by, before it starts losing them
+constexpr size_t DISTRIBUTION_RING_SIZE = 512;
+
+}
+
 // Just an RAII for AVPacket unref
 struct AVPacketUnrefRAII {
     AVPacket *packet = nullptr;
@@ -50,6 +57,8 @@ CameraCapture::CameraCapture(const QString &name,
     , m_config(config)
 {
     setObjectName(name);
+
+    m_packetDistributor = QSharedPointer<PacketDistributor>::create(DISTRIBUTION_RING_SIZE);
 }
 
 QString CameraCapture::name() const
@@ -62,6 +71,11 @@ AVStream *CameraCapture::inStream()
     return m_videoStream;
 }
 
+QSharedPointer<PacketDistributor> CameraCapture::packetDistributor() const
+{
+    return m_packetDistributor;
+}
+
 void CameraCapture::run()
 {
     QSharedPointer<SharedFrameBoundedQueue> frame_queue = m_metrics->frameQueue();
@@ -107,6 +121,7 @@ void CameraCapture::run()
                 video_stream_index = i;
                 video_stream = fmt_ctx->streams[i];
                 m_videoStream = video_stream;
+                m_packetDistributor->setCodecParameters(video_stream->codecpar);
                 break;
             }
         }
@@ -205,11 +220,22 @@ void CameraCapture::run()
 
             if (packet->stream_index != video_stream_index) {
                 // stream index isn't the same
+                av_packet_unref(packet);
+                continue;
+            }
+
+            // Every packet once, in decode order. The read buffer is moved into a shared packet, not
+            // copied, and every consumer references that same buffer.
+            SharedPacket pkt(av_packet_alloc(), [](AVPacket *p) { av_packet_free(&p); });
+            if (!pkt) {
+                av_packet_unref(packet);
                 continue;
             }
+            av_packet_move_ref(pkt.get(), packet);
+            m_packetDistributor->publish(pkt, video_stream->time_base);
 
             // send packet to the decoder
-            int send_result = avcodec_send_packet(video_codec_ctx, packet);
+            int send_result = avcodec_send_packet(video_codec_ctx, pkt.get());
             if (send_result < 0 && send_result != AVERROR(EAGAIN)) {
                 av_strerror(send_result, errbuf, sizeof(errbuf));
                 qCWarning(logger) << "Decoder error:" << errbuf;
@@ -228,7 +254,7 @@ void CameraCapture::run()
                     // decoding buffer just emptied
                     if (send_result == AVERROR(EAGAIN)) {
                         // and a packet is still waiting, to be pushed
-                        avcodec_send_packet(video_codec_ctx, packet);
+                        avcodec_send_packet(video_codec_ctx, pkt.get());
                         continue;
                     } else {
                         // break to acquire another packet
@@ -268,9 +294,6 @@ void CameraCapture::run()
                 cv::Mat cv_frame(video_codec_ctx->height, video_codec_ctx->width, CV_8UC3, bgr_frame->data[0], bgr_frame->linesize[0]);
                 SharedFrame final_frame(new Frame(m_name, frame_index, cv_frame.clone()));
 
-                QSharedPointer<AVPacket> pkt(av_packet_clone(packet), [](AVPacket *p) { av_packet_free(&p); });
-                emit packetChanged(pkt, video_stream->time_base);
-
                 try {
                     if (!m_metrics->isPullBased()) {
                         frame_queue->emplace(final_frame);
@@ -310,6 +333,8 @@ void CameraCapture::run()
     if (video_codec_ctx) {
         avcodec_free_context(&video_codec_ctx);
     }
+    // Frees the stream, the readers still draining keep their own copy of its parameters
+    m_videoStream = nullptr;
     if (fmt_ctx) {
         avformat_close_input(&fmt_ctx);
     }
@@ -8,6 +8,7 @@ extern "C" {
 
 #include <config/cameraconfig.h>
 #include <camera/camerametrics.h>
+#include <output/packetdistributor.h>
 
 class CameraCapture : public QThread
 {
@@ -18,10 +19,10 @@ public:
                            CameraConfig config,
                            QObject *parent = nullptr);
     QString name() const;
+    // Only valid on the capture's own thread, while its input is open
     AVStream *inStream();
-
-signals:
-    void packetChanged(QSharedPointer<AVPacket> pkt, AVRational inTimeBase);
+    // Every packet read, once, for whoever wants them. Lives as long as the capture.
+    QSharedPointer<PacketDistributor> packetDistributor() const;
 
     // QThread interface
 protected:
@@ -31,6 +32,7 @@ private:
     QString m_name;
     CameraConfig m_config;
     QSharedPointer<CameraMetrics> m_metrics;
+    QSharedPointer<PacketDistributor> m_packetDistributor;
 
-    AVStream *m_videoStream;
+    AVStream *m_videoStream = nullptr;
 };
@@ -2,6 +2,7 @@
 
 CameraMetrics::CameraMetrics(const QString &name, bool isPullBased, QObject *parent)
     : QObject(parent)
+    , m_overlayModel(new DetectionOverlayModel())
     , m_frameQueue(new SharedFrameBoundedQueue())
     , m_name(name)
     , m_isPullBased(isPullBased)
@@ -34,6 +35,16 @@ double CameraMetrics::skippedFPS() const
     return m_skippedFPS.load(std::memory_order_acquire);
 }
 
+double CameraMetrics::escalationRate() const
+{
+    return m_escalationRate.load(std::memory_order_acquire);
+}
+
+double CameraMetrics::plateCacheHitRate() const
+{
+    return m_plateCacheHitRate.load(std::memory_order_acquire);
+}
+
 int CameraMetrics::detectionFrame() const
 {
     return m_detectionFrame.load(std::memory_order_acquire);
@@ -49,9 +60,19 @@ QVideoSink *CameraMetrics::videoSink() const
     return m_videoSink.load(std::memory_order_acquire);
 }
 
-QSharedPointer<PacketRingBuffer> CameraMetrics::packetRingBuffer() const
+QSize CameraMetrics::previewSize() const
 {
-    return m_packetRingBuffer;
+    return m_previewSize.load(std::memory_order_acquire);
+}
+
+bool CameraMetrics::previewVisible() const
+{
+    return m_previewVisible.load(std::memory_order_acquire);
+}
+
+DetectionOverlayModel *CameraMetrics::overlayModel() const
+{
+    return m_overlayModel.get();
 }
 
 QSharedPointer<SharedFrameBoundedQueue> CameraMetrics::frameQueue() const
@@ -157,6 +178,44 @@ void CameraMetrics::setSkippedFPS(double newSkippedFPS)
     Q_EMIT skippedFPSChanged(newSkippedFPS);
 }
 
+void CameraMetrics::setEscalationRate(double newEscalationRate)
+{
+    double current = m_escalationRate.load(std::memory_order_relaxed);
+    if (current == newEscalationRate)
+        return;
+
+    while (!m_escalationRate.compare_exchange_weak(
+        current, newEscalationRate,
+        std::memory_order_release,
+        std::memory_order_relaxed
+        )) {
+
+        if (current == newEscalationRate)
+            return;
+    }
+
+    Q_EMIT escalationRateChanged(newEscalationRate);
+}
+
+void CameraMetrics::setPlateCacheHitRate(double newPlateCacheHitRate)
+{
+    double current = m_plateCacheHitRate.load(std::memory_order_relaxed);
+    if (current == newPlateCacheHitRate)
+        return;
+
+    while (!m_plateCacheHitRate.compare_exchange_weak(
+        current, newPlateCacheHitRate,
+        std::memory_order_release,
+        std::memory_order_relaxed
+        )) {
+
+        if (current == newPlateCacheHitRate)
+            return;
+    }
+
+    Q_EMIT plateCacheHitRateChanged(newPlateCacheHitRate);
+}
+
 void CameraMetrics::setDetectionFrame(int newDetectionFrame)
 {
     int current = m_detectionFrame.load(std::memory_order_relaxed);
@@ -214,9 +273,42 @@ void CameraMetrics::setVideoSink(QVideoSink *newVideoSink)
     emit videoSinkChanged(newVideoSink);
 }
 
-void CameraMetrics::setPacketRingBuffer(QSharedPointer<PacketRingBuffer> newPacketRingBuffer)
+void CameraMetrics::setPreviewSize(QSize newPreviewSize)
+{
+    QSize current = m_previewSize.load(std::memory_order_relaxed);
+    if (current == newPreviewSize)
+        return;
+
+    while (!m_previewSize.compare_exchange_weak(
+        current, newPreviewSize,
+        std::memory_order_release,
+        std::memory_order_relaxed
+        )) {
+
+        if (current == newPreviewSize)
+            return;
+    }
+
+    emit previewSizeChanged(newPreviewSize);
+}
+
+void CameraMetrics::setPreviewVisible(bool newPreviewVisible)
 {
-    m_packetRingBuffer = newPacketRingBuffer;
+    bool current = m_previewVisible.load(std::memory_order_relaxed);
+    if (current == newPreviewVisible)
+        return;
+
+    while (!m_previewVisible.compare_exchange_weak(
+        current, newPreviewVisible,
+        std::memory_order_release,
+        std::memory_order_relaxed
+        )) {
+
+        if (current == newPreviewVisible)
+            return;
+    }
+
+    emit previewVisibleChanged(newPreviewVisible);
 }
 
 void CameraMetrics::setFrameQueue(QSharedPointer<SharedFrameBoundedQueue> newFrameQueue)
@@ -1,13 +1,14 @@
 #pragma once
 
 #include <QObject>
+#include <QSize>
 #include <QVideoSink>
 
 #include <atomic>
 
 #include <tbb_patched.h>
+#include <models/detectionoverlaymodel.h>
 #include <utils/frame.h>
-#include <output/packetringbuffer.h>
 
 class CameraMetrics : QObject
 {
@@ -18,11 +19,15 @@ class CameraMetrics : QObject
     Q_PROPERTY(int detectionFrame READ detectionFrame WRITE setDetectionFrame NOTIFY detectionFrameChanged FINAL)
     Q_PROPERTY(double processFPS READ processFPS WRITE setProcessFPS NOTIFY processFPSChanged FINAL)
     Q_PROPERTY(double skippedFPS READ skippedFPS WRITE setSkippedFPS NOTIFY skippedFPSChanged FINAL)
+    Q_PROPERTY(double escalationRate READ escalationRate WRITE setEscalationRate NOTIFY escalationRateChanged FINAL)
+    Q_PROPERTY(double plateCacheHitRate READ plateCacheHitRate WRITE setPlateCacheHitRate NOTIFY plateCacheHitRateChanged FINAL)
     Q_PROPERTY(int readStart READ readStart WRITE setReadStart NOTIFY readStartChanged FINAL)
     // Q_PROPERTY(std::atomic_int audioRMS READ audioRMS WRITE setAudioRMS NOTIFY audioRMSChanged FINAL)
     // Q_PROPERTY(std::atomic_int audiodBFS READ audiodBFS WRITE setAudiodBFS NOTIFY audiodBFSChanged FINAL)
 
     Q_PROPERTY(QVideoSink* videoSink READ videoSink WRITE setVideoSink NOTIFY videoSinkChanged FINAL)
+    Q_PROPERTY(QSize previewSize READ previewSize WRITE setPreviewSize NOTIFY previewSizeChanged FINAL)
+    Q_PROPERTY(bool previewVisible READ previewVisible WRITE setPreviewVisible NOTIFY previewVisibleChanged FINAL)
     Q_PROPERTY(QSharedPointer<SharedFrameBoundedQueue> frameQueue READ frameQueue WRITE setFrameQueue NOTIFY frameQueueChanged FINAL)
     Q_PROPERTY(QSharedPointer<QThread> thread READ thread WRITE setThread NOTIFY threadChanged FINAL)
     Q_PROPERTY(QSharedPointer<QThread> captureThread READ captureThread WRITE setCaptureThread NOTIFY captureThreadChanged FINAL)
@@ -35,10 +40,15 @@ public:
     double detectionFPS() const;
     double processFPS() const;
     double skippedFPS() const;
+    double escalationRate() const;
+    double plateCacheHitRate() const;
     int detectionFrame() const;
     int readStart() const;
     QVideoSink *videoSink() const;
-    QSharedPointer<PacketRingBuffer> packetRingBuffer() const;
+    QSize previewSize() const;
+    bool previewVisible() const;
+    // Lives in the GUI thread, only to be updated from there
+    DetectionOverlayModel *overlayModel() const;
     QSharedPointer<SharedFrameBoundedQueue> frameQueue() const;
     QSharedPointer<QThread> thread() const;
     QSharedPointer<QThread> captureThread() const;
@@ -49,10 +59,13 @@ public slots:
     void setDetectionFPS(double newDetectionFPS);
     void setProcessFPS(double newProcessFPS);
     void setSkippedFPS(double newSkippedFPS);
+    void setEscalationRate(double newEscalationRate);
+    void setPlateCacheHitRate(double newPlateCacheHitRate);
     void setDetectionFrame(int newDetectionFrame);
     void setReadStart(int newReadStart);
     void setVideoSink(QVideoSink *newVideoSink);
-    void setPacketRingBuffer(QSharedPointer<PacketRingBuffer> newPacketRingBuffer);
+    void setPreviewSize(QSize newPreviewSize);
+    void setPreviewVisible(bool newPreviewVisible);
     void setFrameQueue(QSharedPointer<SharedFrameBoundedQueue> newFrameQueue);
     void setThread(QSharedPointer<QThread> newThread);
     void setCaptureThread(QSharedPointer<QThread> newCaptureThread);
@@ -62,9 +75,13 @@ signals:
     void detectionFPSChanged(double);
     void processFPSChanged(double);
     void skippedFPSChanged(double);
+    void escalationRateChanged(double);
+    void plateCacheHitRateChanged(double);
     void detectionFrameChanged(int detectionFrame);
     void readStartChanged(int readStart);
     void videoSinkChanged(QVideoSink *videoSink);
+    void previewSizeChanged(QSize previewSize);
+    void previewVisibleChanged(bool previewVisible);
     void frameQueueChanged(QSharedPointer<SharedFrameBoundedQueue> frameQueue);
     void threadChanged(QSharedPointer<QThread> thread);
     void captureThreadChanged(QSharedPointer<QThread> captureThread);
@@ -75,10 +92,14 @@ private:
     std::atomic<double> m_detectionFPS;
     std::atomic<double> m_processFPS;
     std::atomic<double> m_skippedFPS;
+    std::atomic<double> m_escalationRate;   // Moving average of the frames with a detection sent to the cascade's larger model
+    std::atomic<double> m_plateCacheHitRate;    // Fraction of plates answered by the recent-plate cache
     std::atomic_int m_detectionFrame;
     std::atomic_int m_readStart;
     std::atomic<QVideoSink *> m_videoSink = nullptr;
-    QSharedPointer<PacketRingBuffer> m_packetRingBuffer = nullptr;
+    std::atomic<QSize> m_previewSize;       // On-screen size of the tile in device pixels, invalid if unknown
+    std::atomic_bool m_previewVisible = true;
+    QSharedPointer<DetectionOverlayModel> m_overlayModel;
     QSharedPointer<SharedFrameBoundedQueue> m_frameQueue;
     QSharedPointer<QThread> m_thread;
     QSharedPointer<QThread> m_captureThread;
@@ -9,6 +9,9 @@
 #include "objectconfig.h"
 #include "recordconfig.h"
 #include "predictorconfig.h"
+#include "reidconfig.h"
+#include "snapshotsconfig.h"
+#include "storageconfig.h"
 #include "cameraconfig.h"
 
 inline std::string DEFAULT_APSS_CONFIG = R"(
@@ -43,6 +46,13 @@ struct APSSConfig
     std::optional<DatabaseConfig> database;
     std::optional<ModelConfig> model = std::make_optional<ModelConfig>();
     std::optional<LicensePlateConfig> lpr = std::make_optional<LicensePlateConfig>();
+    std::optional<ReIdConfig> reid;
+    std::optional<SnapshotsConfig> snapshots = std::make_optional<SnapshotsConfig>();
+    std::optional<StorageConfig> storage = std::make_optional<StorageConfig>();
+    // Threads tracking objects, each owns a subset of the cameras. Unset is one per 4 cores, at most one per camera.
+    std::optional<int> object_processors;
+    // Threads muxing the recordings of all the cameras
+    std::optional<int> recording_workers = 2;
 };
 
 
@@ -1,6 +1,22 @@
 #pragma once
 
+#include <optional>
+#include <string>
+
 struct DatabaseConfig
 {
     std::string path;
+    // Group commit of the event writer, whichever comes first: milliseconds since the first
+    // pending mutation, or pending rows.
+    std::optional<int> commit_interval = 50;
+    std::optional<int> commit_rows = 512;
+    std::optional<int> queue_size = 1024;
+    // Predictions of a track are stored as compact binary chunks of this many samples.
+    std::optional<int> track_chunk_size = 256;
+    // Also write every prediction as a JSON row, for debugging.
+    std::optional<bool> prediction_rows = false;
+    // Downsampling of stationary objects: while a box moves less than stationary_threshold
+    // (of its size), only one prediction every stationary_interval ms is kept. 0 keeps them all.
+    std::optional<int> stationary_interval = 0;
+    std::optional<float> stationary_threshold = 0.02f;
 };
@@ -6,15 +6,37 @@
 #include <map>
 #include <optional>
 
+enum class LPRModeEnum {
+    Full,               // Text detection, orientation classification and recognition
+    RecognitionOnly     // Recognize the rectified plate directly, fall back to Full on low confidence
+};
+
 struct LicensePlateConfig {
     bool enabled = false;
+    std::optional<LPRModeEnum> mode = LPRModeEnum::RecognitionOnly;
     float detection_threshold = 0.7;
     int min_area = 1000;
     float recognition_threshold = 0.9;
     int min_plate_length = 4;
     int match_distance = 1;
     std::optional<std::string> format;
+    // label -> plates, matched within match_distance and attached to the event as its sub label
     std::optional<std::map<std::string, std::vector<std::string>>> known_plates;
+    // Large watchlists, one "plate,label" per line. Reloaded whenever the file changes.
+    std::optional<std::string> known_plates_file;
+    // Best crops of a track (by sharpness, keypoint geometry and size) that get read while it's alive.
+    // Their readings are fused and reading stops early once the result passes recognition_threshold.
+    std::optional<int> plate_candidates = 3;
+    // Seconds a recognized plate is remembered per camera. A look-alike crop at the same spot within
+    // that time reuses the reading instead of going through OCR again. 0 disables the cache.
+    std::optional<int> recent_plate_ttl = 30;
+    // Also write the best plate crop of each event to THUMB_DIR, in the background.
+    std::optional<bool> save_plates = true;
+    // Recognizer pool, plates of different events are recognized together up to batch_size.
+    std::optional<int> workers = 2;
+    std::optional<int> batch_size = 4;
+    // Plates from these cameras skip ahead of the rest, i.e. cameras watching for known plates.
+    std::optional<std::set<std::string>> priority_cameras;
     // vehicles-of-interest
     std::optional<std::set<std::string>> voi = std::set<std::string>({ "bicycle", "car", "motorcycle", "bus", "truck" });
 };
@@ -9,10 +9,29 @@ enum SupportedEP {
     CUDA
 };
 
+enum class CascadeModeEnum {
+    Frame,  // Re-run the larger model on the whole frame
+    Crops   // Re-run the larger model on padded crops around uncertain detections
+};
+
+struct CascadeConfig {
+    // Name of the (larger) predictor to escalate to. It must be declared under `predictors`.
+    std::string escalate_to;
+    std::optional<CascadeModeEnum> mode = CascadeModeEnum::Frame;
+    // Detections with confidence in [min_confidence, max_confidence) are considered uncertain.
+    std::optional<float> min_confidence = 0.4f;
+    std::optional<float> max_confidence = 0.6f;
+    // Detections of these classes always escalate, regardless of their confidence.
+    std::optional<std::vector<std::string>> classes;
+    // Relative padding added around each crop, in Crops mode.
+    std::optional<float> crop_padding = 0.25f;
+};
+
 struct PredictorConfig {
     std::optional<ModelConfig> model = ModelConfig{};
     std::optional<int> batch_size = 1;
     std::optional<std::vector<int>> kpt_shape = std::vector<int>{4, 3}; // for pose model
+    std::optional<CascadeConfig> cascade;
 };
 
 // struct ONNXInferenceConfig {
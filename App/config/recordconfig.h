@@ -34,6 +34,8 @@ struct RecordConfig {
     std::optional<bool> sync_recordings = false;
     std::optional<int> expire_interval = 60;
     std::optional<int> max_record_limit = 60; // mins
+    std::optional<int> segment_duration = 10;  // secs, continuous recordings are split at the first keyframe after it
+    std::optional<int> fragment_duration = 1000; // ms, the segment being written is flushed to disk at least this often
     std::optional<RecordRetainConfig> retain = RecordRetainConfig{};
     std::optional<EventsConfig> detections = EventsConfig{};
     std::optional<EventsConfig> alerts = EventsConfig{};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <optional>
+
+#include "predictorconfig.h"
+
+enum class VectorIndexEnum {
+    Flat,   // Exact, scans every embedding
+    IVF     // Approximate, scans the buckets of the closest k-means centroids
+};
+
+struct ReIdConfig {
+    bool enabled = false;
+    // Small re-ID model, [N, 3, H, W] crops in, [N, D] embeddings out.
+    std::optional<PredictorConfig> predictor;
+    std::optional<int> batch_size = 8;
+    std::optional<VectorIndexEnum> index = VectorIndexEnum::Flat;
+    // IVF only. Trained once there are ivf_train_size embeddings, and again every time the count doubles.
+    std::optional<int> ivf_lists = 256;
+    std::optional<int> ivf_probes = 8;
+    std::optional<int> ivf_train_size = 20000;
+    // Seconds between saves of the index next to the database
+    std::optional<int> save_interval = 60;
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <optional>
+
+enum class ImageFormatEnum { JPEG, WebP };
+
+struct SnapshotsConfig {
+    std::optional<ImageFormatEnum> format = ImageFormatEnum::JPEG;
+    // 1-100, for both formats
+    std::optional<int> quality = 90;
+    // Writer threads, and how many images may be waiting for them
+    std::optional<int> writers = 2;
+    std::optional<int> queue_size = 64;
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <optional>
+
+struct StorageConfig {
+    // Percent of the recordings disk in use. Past high_water the oldest files are deleted,
+    // whatever their retention, until it's back under low_water.
+    std::optional<float> high_water = 90.0f;
+    std::optional<float> low_water = 85.0f;
+    // Seconds between checks of the disk and the retention of the recordings
+    std::optional<int> check_interval = 60;
+    // Files deleted a pass, with delete_interval ms between them, so the deletes never
+    // compete with the recordings being written.
+    std::optional<int> delete_batch = 16;
+    std::optional<int> delete_interval = 50;
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QtCore/QDateTime>
+
+// ODB's Qt profile stores a QDateTime as text without its time spec, every time we store is UTC
+// but it's read back as local time.
+inline QDateTime forceToUTC(const QDateTime &dateTime)
+{
+    QDateTime utc = dateTime;
+    utc.setTimeSpec(Qt::UTC);
+    return utc;
+}
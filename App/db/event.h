@@ -9,7 +9,7 @@
 
 #include <odb/forward.hxx>
 
-#pragma db model version(1, 2)
+#pragma db model version(1, 3)
 
 namespace APSS::ODB {
 
@@ -65,7 +65,7 @@ namespace odb
                       "  \"migration\" INTEGER NOT NULL)");
           db.execute ("INSERT OR IGNORE INTO \"schema_version\" (\n"
                       "  \"name\", \"version\", \"migration\")\n"
-                      "  VALUES ('', 2, 0)");
+                      "  VALUES ('', 3, 0)");
           return false;
         }
       }
@@ -140,6 +140,58 @@ namespace odb
     "",
     2ULL,
     &migrate_schema_2);
+
+  static bool
+  migrate_schema_3 (database& db, unsigned short pass, bool pre)
+  {
+    ODB_POTENTIALLY_UNUSED (db);
+    ODB_POTENTIALLY_UNUSED (pass);
+    ODB_POTENTIALLY_UNUSED (pre);
+
+    if (pre)
+    {
+      switch (pass)
+      {
+        case 1:
+        {
+          return true;
+        }
+        case 2:
+        {
+          db.execute ("UPDATE \"schema_version\"\n"
+                      "  SET \"version\" = 3, \"migration\" = 1\n"
+                      "  WHERE \"name\" = ''");
+          return false;
+        }
+      }
+    }
+    else
+    {
+      switch (pass)
+      {
+        case 1:
+        {
+          return true;
+        }
+        case 2:
+        {
+          db.execute ("UPDATE \"schema_version\"\n"
+                      "  SET \"migration\" = 0\n"
+                      "  WHERE \"name\" = ''");
+          return false;
+        }
+      }
+    }
+
+    return false;
+  }
+
+  static const schema_catalog_migrate_entry
+  migrate_schema_entry_3_ (
+    id_sqlite,
+    "",
+    3ULL,
+    &migrate_schema_3);
 }
 
 #include <odb/post.hxx>
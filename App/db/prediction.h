@@ -7,7 +7,7 @@
 #include <QtCore/QDateTime>
 #endif
 
-#pragma db model version(1, 2)
+#pragma db model version(1, 3)
 
 namespace APSS::ODB {
     
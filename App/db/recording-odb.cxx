@@ -0,0 +1,1184 @@
+// -*- C++ -*-
+//
+// This file was generated by ODB, object-relational mapping (ORM)
+// compiler for C++.
+//
+
+#include <odb/pre.hxx>
+
+#include "recording-odb.hxx"
+
+#include <cassert>
+#include <cstring>  // std::memcpy
+
+
+#include <odb/sqlite/traits.hxx>
+#include <odb/sqlite/database.hxx>
+#include <odb/sqlite/transaction.hxx>
+#include <odb/sqlite/connection.hxx>
+#include <odb/sqlite/statement.hxx>
+#include <odb/sqlite/statement-cache.hxx>
+#include <odb/sqlite/simple-object-statements.hxx>
+#include <odb/sqlite/container-statements.hxx>
+#include <odb/sqlite/exceptions.hxx>
+#include <odb/sqlite/simple-object-result.hxx>
+
+namespace odb
+{
+  // Recording
+  //
+
+  struct access::object_traits_impl< ::Recording, id_sqlite >::extra_statement_cache_type
+  {
+    extra_statement_cache_type (
+      sqlite::connection&,
+      image_type&,
+      id_image_type&,
+      sqlite::binding&,
+      sqlite::binding&)
+    {
+    }
+  };
+
+  access::object_traits_impl< ::Recording, id_sqlite >::id_type
+  access::object_traits_impl< ::Recording, id_sqlite >::
+  id (const id_image_type& i)
+  {
+    sqlite::database* db (0);
+    ODB_POTENTIALLY_UNUSED (db);
+
+    id_type id;
+    {
+      sqlite::value_traits<
+          ::QString,
+          sqlite::id_text >::set_value (
+        id,
+        i.id_value,
+        i.id_size,
+        i.id_null);
+    }
+
+    return id;
+  }
+
+  access::object_traits_impl< ::Recording, id_sqlite >::id_type
+  access::object_traits_impl< ::Recording, id_sqlite >::
+  id (const image_type& i)
+  {
+    sqlite::database* db (0);
+    ODB_POTENTIALLY_UNUSED (db);
+
+    id_type id;
+    {
+      sqlite::value_traits<
+          ::QString,
+          sqlite::id_text >::set_value (
+        id,
+        i.id_value,
+        i.id_size,
+        i.id_null);
+    }
+
+    return id;
+  }
+
+  bool access::object_traits_impl< ::Recording, id_sqlite >::
+  grow (image_type& i,
+        bool* t)
+  {
+    ODB_POTENTIALLY_UNUSED (i);
+    ODB_POTENTIALLY_UNUSED (t);
+
+    bool grew (false);
+
+    // m_id
+    //
+    if (t[0UL])
+    {
+      i.id_value.capacity (i.id_size);
+      grew = true;
+    }
+
+    // m_camera
+    //
+    if (t[1UL])
+    {
+      i.camera_value.capacity (i.camera_size);
+      grew = true;
+    }
+
+    // m_path
+    //
+    if (t[2UL])
+    {
+      i.path_value.capacity (i.path_size);
+      grew = true;
+    }
+
+    // m_startTime
+    //
+    if (t[3UL])
+    {
+      i.startTime_value.capacity (i.startTime_size);
+      grew = true;
+    }
+
+    // m_endTime
+    //
+    if (t[4UL])
+    {
+      i.endTime_value.capacity (i.endTime_size);
+      grew = true;
+    }
+
+    // m_duration
+    //
+    t[5UL] = false;
+
+    // m_motion
+    //
+    t[6UL] = false;
+
+    // m_objects
+    //
+    t[7UL] = false;
+
+    // m_dBFS
+    //
+    t[8UL] = false;
+
+    // m_segmentSize
+    //
+    t[9UL] = false;
+
+    // m_regions
+    //
+    t[10UL] = false;
+
+    // m_keyframes
+    //
+    if (t[11UL])
+    {
+      i.keyframes_value.capacity (i.keyframes_size);
+      grew = true;
+    }
+
+    return grew;
+  }
+
+  void access::object_traits_impl< ::Recording, id_sqlite >::
+  bind (sqlite::bind* b,
+        image_type& i,
+        sqlite::statement_kind sk)
+  {
+    ODB_POTENTIALLY_UNUSED (sk);
+
+    using namespace sqlite;
+
+    std::size_t n (0);
+
+    // m_id
+    //
+    if (sk != statement_update)
+    {
+      b[n].type = sqlite::image_traits<
+        ::QString,
+        sqlite::id_text>::bind_value;
+      b[n].buffer = i.id_value.data ();
+      b[n].size = &i.id_size;
+      b[n].capacity = i.id_value.capacity ();
+      b[n].is_null = &i.id_null;
+      n++;
+    }
+
+    // m_camera
+    //
+    b[n].type = sqlite::image_traits<
+      ::QString,
+      sqlite::id_text>::bind_value;
+    b[n].buffer = i.camera_value.data ();
+    b[n].size = &i.camera_size;
+    b[n].capacity = i.camera_value.capacity ();
+    b[n].is_null = &i.camera_null;
+    n++;
+
+    // m_path
+    //
+    b[n].type = sqlite::image_traits<
+      ::QString,
+      sqlite::id_text>::bind_value;
+    b[n].buffer = i.path_value.data ();
+    b[n].size = &i.path_size;
+    b[n].capacity = i.path_value.capacity ();
+    b[n].is_null = &i.path_null;
+    n++;
+
+    // m_startTime
+    //
+    b[n].type = sqlite::image_traits<
+      ::QDateTime,
+      sqlite::id_text>::bind_value;
+    b[n].buffer = i.startTime_value.data ();
+    b[n].size = &i.startTime_size;
+    b[n].capacity = i.startTime_value.capacity ();
+    b[n].is_null = &i.startTime_null;
+    n++;
+
+    // m_endTime
+    //
+    b[n].type = sqlite::image_traits<
+      ::QDateTime,
+      sqlite::id_text>::bind_value;
+    b[n].buffer = i.endTime_value.data ();
+    b[n].size = &i.endTime_size;
+    b[n].capacity = i.endTime_value.capacity ();
+    b[n].is_null = &i.endTime_null;
+    n++;
+
+    // m_duration
+    //
+    b[n].type = sqlite::bind::real;
+    b[n].buffer = &i.duration_value;
+    b[n].is_null = &i.duration_null;
+    n++;
+
+    // m_motion
+    //
+    b[n].type = sqlite::bind::integer;
+    b[n].buffer = &i.motion_value;
+    b[n].is_null = &i.motion_null;
+    n++;
+
+    // m_objects
+    //
+    b[n].type = sqlite::bind::integer;
+    b[n].buffer = &i.objects_value;
+    b[n].is_null = &i.objects_null;
+    n++;
+
+    // m_dBFS
+    //
+    b[n].type = sqlite::bind::integer;
+    b[n].buffer = &i.dBFS_value;
+    b[n].is_null = &i.dBFS_null;
+    n++;
+
+    // m_segmentSize
+    //
+    b[n].type = sqlite::bind::real;
+    b[n].buffer = &i.segmentSize_value;
+    b[n].is_null = &i.segmentSize_null;
+    n++;
+
+    // m_regions
+    //
+    b[n].type = sqlite::bind::integer;
+    b[n].buffer = &i.regions_value;
+    b[n].is_null = &i.regions_null;
+    n++;
+
+    // m_keyframes
+    //
+    b[n].type = sqlite::image_traits<
+      ::QByteArray,
+      sqlite::id_blob>::bind_value;
+    b[n].buffer = i.keyframes_value.data ();
+    b[n].size = &i.keyframes_size;
+    b[n].capacity = i.keyframes_value.capacity ();
+    b[n].is_null = &i.keyframes_null;
+    n++;
+
+  }
+
+  void access::object_traits_impl< ::Recording, id_sqlite >::
+  bind (sqlite::bind* b, id_image_type& i)
+  {
+    std::size_t n (0);
+    b[n].type = sqlite::image_traits<
+      ::QString,
+      sqlite::id_text>::bind_value;
+    b[n].buffer = i.id_value.data ();
+    b[n].size = &i.id_size;
+    b[n].capacity = i.id_value.capacity ();
+    b[n].is_null = &i.id_null;
+  }
+
+  bool access::object_traits_impl< ::Recording, id_sqlite >::
+  init (image_type& i,
+        const object_type& o,
+        sqlite::statement_kind sk)
+  {
+    ODB_POTENTIALLY_UNUSED (i);
+    ODB_POTENTIALLY_UNUSED (o);
+    ODB_POTENTIALLY_UNUSED (sk);
+
+    using namespace sqlite;
+
+    bool grew (false);
+
+    // m_id
+    //
+    if (sk == statement_insert)
+    {
+      ::QString const& v =
+        o.m_id;
+
+      bool is_null (true);
+      std::size_t cap (i.id_value.capacity ());
+      sqlite::value_traits<
+          ::QString,
+          sqlite::id_text >::set_image (
+        i.id_value,
+        i.id_size,
+        is_null,
+        v);
+      i.id_null = is_null;
+      grew = grew || (cap != i.id_value.capacity ());
+    }
+
+    // m_camera
+    //
+    {
+      ::QString const& v =
+        o.m_camera;
+
+      bool is_null (true);
+      std::size_t cap (i.camera_value.capacity ());
+      sqlite::value_traits<
+          ::QString,
+          sqlite::id_text >::set_image (
+        i.camera_value,
+        i.camera_size,
+        is_null,
+        v);
+      i.camera_null = is_null;
+      grew = grew || (cap != i.camera_value.capacity ());
+    }
+
+    // m_path
+    //
+    {
+      ::QString const& v =
+        o.m_path;
+
+      bool is_null (true);
+      std::size_t cap (i.path_value.capacity ());
+      sqlite::value_traits<
+          ::QString,
+          sqlite::id_text >::set_image (
+        i.path_value,
+        i.path_size,
+        is_null,
+        v);
+      i.path_null = is_null;
+      grew = grew || (cap != i.path_value.capacity ());
+    }
+
+    // m_startTime
+    //
+    {
+      ::QDateTime const& v =
+        o.m_startTime;
+
+      bool is_null (true);
+      std::size_t cap (i.startTime_value.capacity ());
+      sqlite::value_traits<
+          ::QDateTime,
+          sqlite::id_text >::set_image (
+        i.startTime_value,
+        i.startTime_size,
+        is_null,
+        v);
+      i.startTime_null = is_null;
+      grew = grew || (cap != i.startTime_value.capacity ());
+    }
+
+    // m_endTime
+    //
+    {
+      ::QDateTime const& v =
+        o.m_endTime;
+
+      bool is_null (true);
+      std::size_t cap (i.endTime_value.capacity ());
+      sqlite::value_traits<
+          ::QDateTime,
+          sqlite::id_text >::set_image (
+        i.endTime_value,
+        i.endTime_size,
+        is_null,
+        v);
+      i.endTime_null = is_null;
+      grew = grew || (cap != i.endTime_value.capacity ());
+    }
+
+    // m_duration
+    //
+    {
+      float const& v =
+        o.m_duration;
+
+      bool is_null (true);
+      sqlite::value_traits<
+          float,
+          sqlite::id_real >::set_image (
+        i.duration_value,
+        is_null,
+        v);
+      i.duration_null = is_null;
+    }
+
+    // m_motion
+    //
+    {
+      int const& v =
+        o.m_motion;
+
+      bool is_null (false);
+      sqlite::value_traits<
+          int,
+          sqlite::id_integer >::set_image (
+        i.motion_value,
+        is_null,
+        v);
+      i.motion_null = is_null;
+    }
+
+    // m_objects
+    //
+    {
+      int const& v =
+        o.m_objects;
+
+      bool is_null (false);
+      sqlite::value_traits<
+          int,
+          sqlite::id_integer >::set_image (
+        i.objects_value,
+        is_null,
+        v);
+      i.objects_null = is_null;
+    }
+
+    // m_dBFS
+    //
+    {
+      int const& v =
+        o.m_dBFS;
+
+      bool is_null (false);
+      sqlite::value_traits<
+          int,
+          sqlite::id_integer >::set_image (
+        i.dBFS_value,
+        is_null,
+        v);
+      i.dBFS_null = is_null;
+    }
+
+    // m_segmentSize
+    //
+    {
+      float const& v =
+        o.m_segmentSize;
+
+      bool is_null (true);
+      sqlite::value_traits<
+          float,
+          sqlite::id_real >::set_image (
+        i.segmentSize_value,
+        is_null,
+        v);
+      i.segmentSize_null = is_null;
+    }
+
+    // m_regions
+    //
+    {
+      int const& v =
+        o.m_regions;
+
+      bool is_null (false);
+      sqlite::value_traits<
+          int,
+          sqlite::id_integer >::set_image (
+        i.regions_value,
+        is_null,
+        v);
+      i.regions_null = is_null;
+    }
+
+    // m_keyframes
+    //
+    {
+      ::QByteArray const& v =
+        o.m_keyframes;
+
+      bool is_null (true);
+      std::size_t cap (i.keyframes_value.capacity ());
+      sqlite::value_traits<
+          ::QByteArray,
+          sqlite::id_blob >::set_image (
+        i.keyframes_value,
+        i.keyframes_size,
+        is_null,
+        v);
+      i.keyframes_null = is_null;
+      grew = grew || (cap != i.keyframes_value.capacity ());
+    }
+
+    return grew;
+  }
+
+  void access::object_traits_impl< ::Recording, id_sqlite >::
+  init (object_type& o,
+        const image_type& i,
+        database* db)
+  {
+    ODB_POTENTIALLY_UNUSED (o);
+    ODB_POTENTIALLY_UNUSED (i);
+    ODB_POTENTIALLY_UNUSED (db);
+
+    // m_id
+    //
+    {
+      ::QString& v =
+        o.m_id;
+
+      sqlite::value_traits<
+          ::QString,
+          sqlite::id_text >::set_value (
+        v,
+        i.id_value,
+        i.id_size,
+        i.id_null);
+    }
+
+    // m_camera
+    //
+    {
+      ::QString& v =
+        o.m_camera;
+
+      sqlite::value_traits<
+          ::QString,
+          sqlite::id_text >::set_value (
+        v,
+        i.camera_value,
+        i.camera_size,
+        i.camera_null);
+    }
+
+    // m_path
+    //
+    {
+      ::QString& v =
+        o.m_path;
+
+      sqlite::value_traits<
+          ::QString,
+          sqlite::id_text >::set_value (
+        v,
+        i.path_value,
+        i.path_size,
+        i.path_null);
+    }
+
+    // m_startTime
+    //
+    {
+      ::QDateTime& v =
+        o.m_startTime;
+
+      sqlite::value_traits<
+          ::QDateTime,
+          sqlite::id_text >::set_value (
+        v,
+        i.startTime_value,
+        i.startTime_size,
+        i.startTime_null);
+    }
+
+    // m_endTime
+    //
+    {
+      ::QDateTime& v =
+        o.m_endTime;
+
+      sqlite::value_traits<
+          ::QDateTime,
+          sqlite::id_text >::set_value (
+        v,
+        i.endTime_value,
+        i.endTime_size,
+        i.endTime_null);
+    }
+
+    // m_duration
+    //
+    {
+      float& v =
+        o.m_duration;
+
+      sqlite::value_traits<
+          float,
+          sqlite::id_real >::set_value (
+        v,
+        i.duration_value,
+        i.duration_null);
+    }
+
+    // m_motion
+    //
+    {
+      int& v =
+        o.m_motion;
+
+      sqlite::value_traits<
+          int,
+          sqlite::id_integer >::set_value (
+        v,
+        i.motion_value,
+        i.motion_null);
+    }
+
+    // m_objects
+    //
+    {
+      int& v =
+        o.m_objects;
+
+      sqlite::value_traits<
+          int,
+          sqlite::id_integer >::set_value (
+        v,
+        i.objects_value,
+        i.objects_null);
+    }
+
+    // m_dBFS
+    //
+    {
+      int& v =
+        o.m_dBFS;
+
+      sqlite::value_traits<
+          int,
+          sqlite::id_integer >::set_value (
+        v,
+        i.dBFS_value,
+        i.dBFS_null);
+    }
+
+    // m_segmentSize
+    //
+    {
+      float& v =
+        o.m_segmentSize;
+
+      sqlite::value_traits<
+          float,
+          sqlite::id_real >::set_value (
+        v,
+        i.segmentSize_value,
+        i.segmentSize_null);
+    }
+
+    // m_regions
+    //
+    {
+      int& v =
+        o.m_regions;
+
+      sqlite::value_traits<
+          int,
+          sqlite::id_integer >::set_value (
+        v,
+        i.regions_value,
+        i.regions_null);
+    }
+
+    // m_keyframes
+    //
+    {
+      ::QByteArray& v =
+        o.m_keyframes;
+
+      sqlite::value_traits<
+          ::QByteArray,
+          sqlite::id_blob >::set_value (
+        v,
+        i.keyframes_value,
+        i.keyframes_size,
+        i.keyframes_null);
+    }
+  }
+
+  void access::object_traits_impl< ::Recording, id_sqlite >::
+  init (id_image_type& i, const id_type& id)
+  {
+    bool grew (false);
+    {
+      bool is_null (true);
+      std::size_t cap (i.id_value.capacity ());
+      sqlite::value_traits<
+          ::QString,
+          sqlite::id_text >::set_image (
+        i.id_value,
+        i.id_size,
+        is_null,
+        id);
+      i.id_null = is_null;
+      grew = grew || (cap != i.id_value.capacity ());
+    }
+
+    if (grew)
+      i.version++;
+  }
+
+  const char access::object_traits_impl< ::Recording, id_sqlite >::persist_statement[] =
+  "INSERT INTO \"Recording\"\n"
+  "(\"id\",\n"
+  "\"camera\",\n"
+  "\"path\",\n"
+  "\"startTime\",\n"
+  "\"endTime\",\n"
+  "\"duration\",\n"
+  "\"motion\",\n"
+  "\"objects\",\n"
+  "\"dBFS\",\n"
+  "\"segmentSize\",\n"
+  "\"regions\",\n"
+  "\"keyframes\")\n"
+  "VALUES\n"
+  "(?,\n?,\n?,\n?,\n?,\n?,\n?,\n?,\n?,\n?,\n?,\n?)";
+
+  const char access::object_traits_impl< ::Recording, id_sqlite >::find_statement[] =
+  "SELECT\n"
+  "\"Recording\".\"id\",\n"
+  "\"Recording\".\"camera\",\n"
+  "\"Recording\".\"path\",\n"
+  "\"Recording\".\"startTime\",\n"
+  "\"Recording\".\"endTime\",\n"
+  "\"Recording\".\"duration\",\n"
+  "\"Recording\".\"motion\",\n"
+  "\"Recording\".\"objects\",\n"
+  "\"Recording\".\"dBFS\",\n"
+  "\"Recording\".\"segmentSize\",\n"
+  "\"Recording\".\"regions\",\n"
+  "\"Recording\".\"keyframes\"\n"
+  "FROM \"Recording\"\n"
+  "WHERE \"Recording\".\"id\"=?";
+
+  const char access::object_traits_impl< ::Recording, id_sqlite >::update_statement[] =
+  "UPDATE \"Recording\"\n"
+  "SET\n"
+  "\"camera\"=?,\n"
+  "\"path\"=?,\n"
+  "\"startTime\"=?,\n"
+  "\"endTime\"=?,\n"
+  "\"duration\"=?,\n"
+  "\"motion\"=?,\n"
+  "\"objects\"=?,\n"
+  "\"dBFS\"=?,\n"
+  "\"segmentSize\"=?,\n"
+  "\"regions\"=?,\n"
+  "\"keyframes\"=?\n"
+  "WHERE \"id\"=?";
+
+  const char access::object_traits_impl< ::Recording, id_sqlite >::erase_statement[] =
+  "DELETE FROM \"Recording\" "
+  "WHERE \"id\"=?";
+
+  const char access::object_traits_impl< ::Recording, id_sqlite >::query_statement[] =
+  "SELECT\n"
+  "\"Recording\".\"id\",\n"
+  "\"Recording\".\"camera\",\n"
+  "\"Recording\".\"path\",\n"
+  "\"Recording\".\"startTime\",\n"
+  "\"Recording\".\"endTime\",\n"
+  "\"Recording\".\"duration\",\n"
+  "\"Recording\".\"motion\",\n"
+  "\"Recording\".\"objects\",\n"
+  "\"Recording\".\"dBFS\",\n"
+  "\"Recording\".\"segmentSize\",\n"
+  "\"Recording\".\"regions\",\n"
+  "\"Recording\".\"keyframes\"\n"
+  "FROM \"Recording\"";
+
+  const char access::object_traits_impl< ::Recording, id_sqlite >::erase_query_statement[] =
+  "DELETE FROM \"Recording\"";
+
+  const char access::object_traits_impl< ::Recording, id_sqlite >::table_name[] =
+  "\"Recording\"";
+
+  void access::object_traits_impl< ::Recording, id_sqlite >::
+  persist (database& db, const object_type& obj)
+  {
+    using namespace sqlite;
+
+    sqlite::connection& conn (
+      sqlite::transaction::current ().connection (db));
+    statements_type& sts (
+      conn.statement_cache ().find_object<object_type> ());
+
+    callback (db,
+              obj,
+              callback_event::pre_persist);
+
+    image_type& im (sts.image ());
+    binding& imb (sts.insert_image_binding ());
+
+    if (init (im, obj, statement_insert))
+      im.version++;
+
+    if (im.version != sts.insert_image_version () ||
+        imb.version == 0)
+    {
+      bind (imb.bind, im, statement_insert);
+      sts.insert_image_version (im.version);
+      imb.version++;
+    }
+
+    insert_statement& st (sts.persist_statement ());
+    if (!st.execute ())
+      throw object_already_persistent ();
+
+    callback (db,
+              obj,
+              callback_event::post_persist);
+  }
+
+  void access::object_traits_impl< ::Recording, id_sqlite >::
+  update (database& db, const object_type& obj)
+  {
+    ODB_POTENTIALLY_UNUSED (db);
+
+    using namespace sqlite;
+    using sqlite::update_statement;
+
+    callback (db, obj, callback_event::pre_update);
+
+    sqlite::transaction& tr (sqlite::transaction::current ());
+    sqlite::connection& conn (tr.connection (db));
+    statements_type& sts (
+      conn.statement_cache ().find_object<object_type> ());
+
+    id_image_type& idi (sts.id_image ());
+    init (idi, id (obj));
+
+    image_type& im (sts.image ());
+    if (init (im, obj, statement_update))
+      im.version++;
+
+    bool u (false);
+    binding& imb (sts.update_image_binding ());
+    if (im.version != sts.update_image_version () ||
+        imb.version == 0)
+    {
+      bind (imb.bind, im, statement_update);
+      sts.update_image_version (im.version);
+      imb.version++;
+      u = true;
+    }
+
+    binding& idb (sts.id_image_binding ());
+    if (idi.version != sts.update_id_image_version () ||
+        idb.version == 0)
+    {
+      if (idi.version != sts.id_image_version () ||
+          idb.version == 0)
+      {
+        bind (idb.bind, idi);
+        sts.id_image_version (idi.version);
+        idb.version++;
+      }
+
+      sts.update_id_image_version (idi.version);
+
+      if (!u)
+        imb.version++;
+    }
+
+    update_statement& st (sts.update_statement ());
+    if (!st.empty () && st.execute () == 0)
+      throw object_not_persistent ();
+
+    callback (db, obj, callback_event::post_update);
+    pointer_cache_traits::update (db, obj);
+  }
+
+  void access::object_traits_impl< ::Recording, id_sqlite >::
+  erase (database& db, const id_type& id)
+  {
+    using namespace sqlite;
+
+    sqlite::connection& conn (
+      sqlite::transaction::current ().connection (db));
+    statements_type& sts (
+      conn.statement_cache ().find_object<object_type> ());
+
+    id_image_type& i (sts.id_image ());
+    init (i, id);
+
+    binding& idb (sts.id_image_binding ());
+    if (i.version != sts.id_image_version () || idb.version == 0)
+    {
+      bind (idb.bind, i);
+      sts.id_image_version (i.version);
+      idb.version++;
+    }
+
+    if (sts.erase_statement ().execute () != 1)
+      throw object_not_persistent ();
+
+    pointer_cache_traits::erase (db, id);
+  }
+
+  access::object_traits_impl< ::Recording, id_sqlite >::pointer_type
+  access::object_traits_impl< ::Recording, id_sqlite >::
+  find (database& db, const id_type& id)
+  {
+    using namespace sqlite;
+
+    {
+      pointer_type p (pointer_cache_traits::find (db, id));
+
+      if (!pointer_traits::null_ptr (p))
+        return p;
+    }
+
+    sqlite::connection& conn (
+      sqlite::transaction::current ().connection (db));
+    statements_type& sts (
+      conn.statement_cache ().find_object<object_type> ());
+
+    statements_type::auto_lock l (sts);
+
+    if (l.locked ())
+    {
+      if (!find_ (sts, &id))
+        return pointer_type ();
+    }
+
+    pointer_type p (
+      access::object_factory<object_type, pointer_type>::create ());
+    pointer_traits::guard pg (p);
+
+    pointer_cache_traits::insert_guard ig (
+      pointer_cache_traits::insert (db, id, p));
+
+    object_type& obj (pointer_traits::get_ref (p));
+
+    if (l.locked ())
+    {
+      select_statement& st (sts.find_statement ());
+      ODB_POTENTIALLY_UNUSED (st);
+
+      callback (db, obj, callback_event::pre_load);
+      init (obj, sts.image (), &db);
+      load_ (sts, obj, false);
+      sts.load_delayed (0);
+      l.unlock ();
+      callback (db, obj, callback_event::post_load);
+      pointer_cache_traits::load (ig.position ());
+    }
+    else
+      sts.delay_load (id, obj, ig.position ());
+
+    ig.release ();
+    pg.release ();
+    return p;
+  }
+
+  bool access::object_traits_impl< ::Recording, id_sqlite >::
+  find (database& db, const id_type& id, object_type& obj)
+  {
+    using namespace sqlite;
+
+    sqlite::connection& conn (
+      sqlite::transaction::current ().connection (db));
+    statements_type& sts (
+      conn.statement_cache ().find_object<object_type> ());
+
+    statements_type::auto_lock l (sts);
+    assert (l.locked ()) /* Must be a top-level call. */;
+
+    if (!find_ (sts, &id))
+      return false;
+
+    select_statement& st (sts.find_statement ());
+    ODB_POTENTIALLY_UNUSED (st);
+
+    reference_cache_traits::position_type pos (
+      reference_cache_traits::insert (db, id, obj));
+    reference_cache_traits::insert_guard ig (pos);
+
+    callback (db, obj, callback_event::pre_load);
+    init (obj, sts.image (), &db);
+    load_ (sts, obj, false);
+    sts.load_delayed (0);
+    l.unlock ();
+    callback (db, obj, callback_event::post_load);
+    reference_cache_traits::load (pos);
+    ig.release ();
+    return true;
+  }
+
+  bool access::object_traits_impl< ::Recording, id_sqlite >::
+  reload (database& db, object_type& obj)
+  {
+    using namespace sqlite;
+
+    sqlite::connection& conn (
+      sqlite::transaction::current ().connection (db));
+    statements_type& sts (
+      conn.statement_cache ().find_object<object_type> ());
+
+    statements_type::auto_lock l (sts);
+    assert (l.locked ()) /* Must be a top-level call. */;
+
+    const id_type& id (object_traits_impl::id (obj));
+    if (!find_ (sts, &id))
+      return false;
+
+    select_statement& st (sts.find_statement ());
+    ODB_POTENTIALLY_UNUSED (st);
+
+    callback (db, obj, callback_event::pre_load);
+    init (obj, sts.image (), &db);
+    load_ (sts, obj, true);
+    sts.load_delayed (0);
+    l.unlock ();
+    callback (db, obj, callback_event::post_load);
+    return true;
+  }
+
+  bool access::object_traits_impl< ::Recording, id_sqlite >::
+  find_ (statements_type& sts,
+         const id_type* id)
+  {
+    using namespace sqlite;
+
+    id_image_type& i (sts.id_image ());
+    init (i, *id);
+
+    binding& idb (sts.id_image_binding ());
+    if (i.version != sts.id_image_version () || idb.version == 0)
+    {
+      bind (idb.bind, i);
+      sts.id_image_version (i.version);
+      idb.version++;
+    }
+
+    image_type& im (sts.image ());
+    binding& imb (sts.select_image_binding ());
+
+    if (im.version != sts.select_image_version () ||
+        imb.version == 0)
+    {
+      bind (imb.bind, im, statement_select);
+      sts.select_image_version (im.version);
+      imb.version++;
+    }
+
+    select_statement& st (sts.find_statement ());
+
+    st.execute ();
+    auto_result ar (st);
+    select_statement::result r (st.fetch ());
+
+    if (r == select_statement::truncated)
+    {
+      if (grow (im, sts.select_image_truncated ()))
+        im.version++;
+
+      if (im.version != sts.select_image_version ())
+      {
+        bind (imb.bind, im, statement_select);
+        sts.select_image_version (im.version);
+        imb.version++;
+        st.refetch ();
+      }
+    }
+
+    return r != select_statement::no_data;
+  }
+
+  result< access::object_traits_impl< ::Recording, id_sqlite >::object_type >
+  access::object_traits_impl< ::Recording, id_sqlite >::
+  query (database& db, const query_base_type& q)
+  {
+    using namespace sqlite;
+    using odb::details::shared;
+    using odb::details::shared_ptr;
+
+    sqlite::connection& conn (
+      sqlite::transaction::current ().connection (db));
+
+    statements_type& sts (
+      conn.statement_cache ().find_object<object_type> ());
+
+    image_type& im (sts.image ());
+    binding& imb (sts.select_image_binding ());
+
+    if (im.version != sts.select_image_version () ||
+        imb.version == 0)
+    {
+      bind (imb.bind, im, statement_select);
+      sts.select_image_version (im.version);
+      imb.version++;
+    }
+
+    std::string text (query_statement);
+    if (!q.empty ())
+    {
+      text += "\n";
+      text += q.clause ();
+    }
+
+    q.init_parameters ();
+    shared_ptr<select_statement> st (
+      new (shared) select_statement (
+        conn,
+        text,
+        true,
+        true,
+        q.parameters_binding (),
+        imb));
+
+    st->execute ();
+
+    shared_ptr< odb::object_result_impl<object_type> > r (
+      new (shared) sqlite::object_result_impl<object_type> (
+        q, st, sts, 0));
+
+    return result<object_type> (r);
+  }
+
+  unsigned long long access::object_traits_impl< ::Recording, id_sqlite >::
+  erase_query (database& db, const query_base_type& q)
+  {
+    using namespace sqlite;
+
+    sqlite::connection& conn (
+      sqlite::transaction::current ().connection (db));
+
+    std::string text (erase_query_statement);
+    if (!q.empty ())
+    {
+      text += ' ';
+      text += q.clause ();
+    }
+
+    q.init_parameters ();
+    delete_statement st (
+      conn,
+      text,
+      q.parameters_binding ());
+
+    return st.execute ();
+  }
+}
+
+#include <odb/post.hxx>
\ No newline at end of file
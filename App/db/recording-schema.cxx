@@ -0,0 +1,221 @@
+// -*- C++ -*-
+//
+// This file was generated by ODB, object-relational mapping (ORM)
+// compiler for C++.
+//
+
+#include <odb/pre.hxx>
+
+#include <odb/database.hxx>
+#include <odb/schema-catalog-impl.hxx>
+
+#include <odb/details/unused.hxx>
+
+namespace odb
+{
+  static bool
+  create_schema (database& db, unsigned short pass, bool drop)
+  {
+    ODB_POTENTIALLY_UNUSED (db);
+    ODB_POTENTIALLY_UNUSED (pass);
+    ODB_POTENTIALLY_UNUSED (drop);
+
+    if (drop)
+    {
+      switch (pass)
+      {
+        case 1:
+        {
+          return true;
+        }
+        case 2:
+        {
+          db.execute ("DROP TABLE IF EXISTS \"Recording\"");
+          db.execute ("CREATE TABLE IF NOT EXISTS \"schema_version\" (\n"
+                      "  \"name\" TEXT NOT NULL PRIMARY KEY,\n"
+                      "  \"version\" INTEGER NOT NULL,\n"
+                      "  \"migration\" INTEGER NOT NULL)");
+          db.execute ("DELETE FROM \"schema_version\"\n"
+                      "  WHERE \"name\" = ''");
+          return false;
+        }
+      }
+    }
+    else
+    {
+      switch (pass)
+      {
+        case 1:
+        {
+          db.execute ("CREATE TABLE \"Recording\" (\n"
+                      "  \"id\" TEXT NOT NULL PRIMARY KEY,\n"
+                      "  \"camera\" TEXT NULL,\n"
+                      "  \"path\" TEXT NULL,\n"
+                      "  \"startTime\" TEXT NULL,\n"
+                      "  \"endTime\" TEXT NULL,\n"
+                      "  \"duration\" REAL NULL,\n"
+                      "  \"motion\" INTEGER NOT NULL,\n"
+                      "  \"objects\" INTEGER NOT NULL,\n"
+                      "  \"dBFS\" INTEGER NOT NULL,\n"
+                      "  \"segmentSize\" REAL NULL,\n"
+                      "  \"regions\" INTEGER NOT NULL,\n"
+                      "  \"keyframes\" BLOB NULL)");
+          db.execute ("CREATE INDEX \"Recording_camera_startTime_i\"\n"
+                      "  ON \"Recording\" (\n"
+                      "    \"camera\",\n"
+                      "    \"startTime\")");
+          return true;
+        }
+        case 2:
+        {
+          db.execute ("CREATE TABLE IF NOT EXISTS \"schema_version\" (\n"
+                      "  \"name\" TEXT NOT NULL PRIMARY KEY,\n"
+                      "  \"version\" INTEGER NOT NULL,\n"
+                      "  \"migration\" INTEGER NOT NULL)");
+          db.execute ("INSERT OR IGNORE INTO \"schema_version\" (\n"
+                      "  \"name\", \"version\", \"migration\")\n"
+                      "  VALUES ('', 3, 0)");
+          return false;
+        }
+      }
+    }
+
+    return false;
+  }
+
+  static const schema_catalog_create_entry
+  create_schema_entry_ (
+    id_sqlite,
+    "",
+    &create_schema);
+
+  static const schema_catalog_migrate_entry
+  migrate_schema_entry_1_ (
+    id_sqlite,
+    "",
+    1ULL,
+    0);
+
+  static bool
+  migrate_schema_2 (database& db, unsigned short pass, bool pre)
+  {
+    ODB_POTENTIALLY_UNUSED (db);
+    ODB_POTENTIALLY_UNUSED (pass);
+    ODB_POTENTIALLY_UNUSED (pre);
+
+    if (pre)
+    {
+      switch (pass)
+      {
+        case 1:
+        {
+          return true;
+        }
+        case 2:
+        {
+          db.execute ("UPDATE \"schema_version\"\n"
+                      "  SET \"version\" = 2, \"migration\" = 1\n"
+                      "  WHERE \"name\" = ''");
+          return false;
+        }
+      }
+    }
+    else
+    {
+      switch (pass)
+      {
+        case 1:
+        {
+          return true;
+        }
+        case 2:
+        {
+          db.execute ("UPDATE \"schema_version\"\n"
+                      "  SET \"migration\" = 0\n"
+                      "  WHERE \"name\" = ''");
+          return false;
+        }
+      }
+    }
+
+    return false;
+  }
+
+  static const schema_catalog_migrate_entry
+  migrate_schema_entry_2_ (
+    id_sqlite,
+    "",
+    2ULL,
+    &migrate_schema_2);
+
+  static bool
+  migrate_schema_3 (database& db, unsigned short pass, bool pre)
+  {
+    ODB_POTENTIALLY_UNUSED (db);
+    ODB_POTENTIALLY_UNUSED (pass);
+    ODB_POTENTIALLY_UNUSED (pre);
+
+    if (pre)
+    {
+      switch (pass)
+      {
+        case 1:
+        {
+          db.execute ("CREATE TABLE \"Recording\" (\n"
+                      "  \"id\" TEXT NOT NULL PRIMARY KEY,\n"
+                      "  \"camera\" TEXT NULL,\n"
+                      "  \"path\" TEXT NULL,\n"
+                      "  \"startTime\" TEXT NULL,\n"
+                      "  \"endTime\" TEXT NULL,\n"
+                      "  \"duration\" REAL NULL,\n"
+                      "  \"motion\" INTEGER NOT NULL,\n"
+                      "  \"objects\" INTEGER NOT NULL,\n"
+                      "  \"dBFS\" INTEGER NOT NULL,\n"
+                      "  \"segmentSize\" REAL NULL,\n"
+                      "  \"regions\" INTEGER NOT NULL,\n"
+                      "  \"keyframes\" BLOB NULL)");
+          db.execute ("CREATE INDEX \"Recording_camera_startTime_i\"\n"
+                      "  ON \"Recording\" (\n"
+                      "    \"camera\",\n"
+                      "    \"startTime\")");
+          return true;
+        }
+        case 2:
+        {
+          db.execute ("UPDATE \"schema_version\"\n"
+                      "  SET \"version\" = 3, \"migration\" = 1\n"
+                      "  WHERE \"name\" = ''");
+          return false;
+        }
+      }
+    }
+    else
+    {
+      switch (pass)
+      {
+        case 1:
+        {
+          return true;
+        }
+        case 2:
+        {
+          db.execute ("UPDATE \"schema_version\"\n"
+                      "  SET \"migration\" = 0\n"
+                      "  WHERE \"name\" = ''");
+          return false;
+        }
+      }
+    }
+
+    return false;
+  }
+
+  static const schema_catalog_migrate_entry
+  migrate_schema_entry_3_ (
+    id_sqlite,
+    "",
+    3ULL,
+    &migrate_schema_3);
+}
+
+#include <odb/post.hxx>
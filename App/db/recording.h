@@ -0,0 +1,184 @@
+#pragma once
+
+// Hide includes from ODB_COMPILER
+#ifndef ODB_COMPILER
+#include <QtCore/QByteArray>
+#include <QtCore/QDateTime>
+#include <QtCore/QString>
+#endif
+
+#include <odb/forward.hxx>
+
+#pragma db model version(1, 3)
+
+// A closed segment of a camera's continuous recording. Its keyframes are indexed, so a timestamp
+// is found by binary search in the rows and then in the index, without opening the file.
+#pragma db object
+class Recording {
+public:
+    Recording() = default;
+
+    QString id() const;
+    void setId(const QString &newId);
+    QString camera() const;
+    void setCamera(const QString &newCamera);
+    QString path() const;
+    void setPath(const QString &newPath);
+    QDateTime startTime() const;
+    void setStartTime(const QDateTime &newStartTime);
+    QDateTime endTime() const;
+    void setEndTime(const QDateTime &newEndTime);
+    float duration() const;
+    void setDuration(float newDuration);
+    int motion() const;
+    void setMotion(int newMotion);
+    int objects() const;
+    void setObjects(int newObjects);
+    int dBFS() const;
+    void setDBFS(int newDBFS);
+    float segmentSize() const;
+    void setSegmentSize(float newSegmentSize);
+    int regions() const;
+    void setRegions(int newRegions);
+    QByteArray keyframes() const;
+    void setKeyframes(const QByteArray &newKeyframes);
+
+private:
+    friend class odb::access;
+
+    #pragma db id
+    QString m_id;
+    QString m_camera;
+    QString m_path;
+    QDateTime m_startTime;
+    QDateTime m_endTime;
+    float m_duration = 0.0f;        // Seconds
+    int m_motion = 0;
+    int m_objects = 0;
+    int m_dBFS = 0;
+    float m_segmentSize = 0.0f;     // MB
+    int m_regions = 0;
+    QByteArray m_keyframes;         // KeyframeIndex::toByteArray()
+
+    #pragma db index("Recording_camera_startTime_i") members(m_camera, m_startTime)
+};
+
+inline QString Recording::id() const
+{
+    return m_id;
+}
+
+inline void Recording::setId(const QString &newId)
+{
+    m_id = newId;
+}
+
+inline QString Recording::camera() const
+{
+    return m_camera;
+}
+
+inline void Recording::setCamera(const QString &newCamera)
+{
+    m_camera = newCamera;
+}
+
+inline QString Recording::path() const
+{
+    return m_path;
+}
+
+inline void Recording::setPath(const QString &newPath)
+{
+    m_path = newPath;
+}
+
+inline QDateTime Recording::startTime() const
+{
+    return m_startTime;
+}
+
+inline void Recording::setStartTime(const QDateTime &newStartTime)
+{
+    m_startTime = newStartTime;
+}
+
+inline QDateTime Recording::endTime() const
+{
+    return m_endTime;
+}
+
+inline void Recording::setEndTime(const QDateTime &newEndTime)
+{
+    m_endTime = newEndTime;
+}
+
+inline float Recording::duration() const
+{
+    return m_duration;
+}
+
+inline void Recording::setDuration(float newDuration)
+{
+    m_duration = newDuration;
+}
+
+inline int Recording::motion() const
+{
+    return m_motion;
+}
+
+inline void Recording::setMotion(int newMotion)
+{
+    m_motion = newMotion;
+}
+
+inline int Recording::objects() const
+{
+    return m_objects;
+}
+
+inline void Recording::setObjects(int newObjects)
+{
+    m_objects = newObjects;
+}
+
+inline int Recording::dBFS() const
+{
+    return m_dBFS;
+}
+
+inline void Recording::setDBFS(int newDBFS)
+{
+    m_dBFS = newDBFS;
+}
+
+inline float Recording::segmentSize() const
+{
+    return m_segmentSize;
+}
+
+inline void Recording::setSegmentSize(float newSegmentSize)
+{
+    m_segmentSize = newSegmentSize;
+}
+
+inline int Recording::regions() const
+{
+    return m_regions;
+}
+
+inline void Recording::setRegions(int newRegions)
+{
+    m_regions = newRegions;
+}
+
+inline QByteArray Recording::keyframes() const
+{
+    return m_keyframes;
+}
+
+inline void Recording::setKeyframes(const QByteArray &newKeyframes)
+{
+    m_keyframes = newKeyframes;
+}
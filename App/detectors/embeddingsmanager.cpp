@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QLoggingCategory>
+
+#include <detectors/onnxinference.h>
+#include "embeddingsmanager.h"
+
+Q_STATIC_LOGGING_CATEGORY(logger, "apss.sessions.embeddings")
+
+namespace {
+
+constexpr int TRAIN_ITERATIONS = 8;
+constexpr size_t TRAIN_SAMPLES_PER_LIST = 32;
+
+}
+
+EmbeddingsManager::EmbeddingsManager(EmbeddingRequestQueue &inRequestQueue,
+                                     std::shared_ptr<VectorIndex> index,
+                                     const ReIdConfig &config,
+                                     std::shared_ptr<Ort::Env> env,
+                                     const QString &indexPath,
+                                     QObject *parent)
+    : QThread(parent)
+    , m_inRequestQueue(inRequestQueue)
+    , m_index(index)
+    , m_config(config)
+    , m_env(env)
+    , m_indexPath(indexPath)
+{
+    setObjectName("embeddings_manager");
+    m_maxBatchSize = std::max(1, m_config.batch_size.value_or(8));
+}
+
+void EmbeddingsManager::stop()
+{
+    try {
+        if (isRunning()) {
+            requestInterruption();
+
+            qCDebug(logger) << "Waiting for" << objectName() << "to exit gracefully...";
+            if (!wait(3000)) {
+                qCDebug(logger) << objectName() << "didn't exit. Applying force killing...";
+                terminate();
+                wait();
+            }
+            qCDebug(logger) << objectName() << "thread has exited...";
+        }
+    } catch (const std::exception &e) {
+        qCDebug(logger) << e.what();
+    } catch (...) {
+        qCCritical(logger) << "Uknown/Uncaught exception occurred!";
+    }
+}
+
+uint32_t EmbeddingsManager::cameraGroup(const QString &camera)
+{
+    return static_cast<uint32_t>(qHash(camera));
+}
+
+void EmbeddingsManager::run()
+{
+    qCInfo(logger) << "Starting" << objectName() << "thread";
+
+    try {
+        m_embedder = createEmbedder();
+        load();
+
+        std::vector<EmbeddingRequest> batch;
+        batch.reserve(m_maxBatchSize);
+
+        QElapsedTimer save_timer;
+        save_timer.start();
+        const qint64 save_interval = std::max(1, m_config.save_interval.value_or(60)) * 1000LL;
+
+        while (!isInterruptionRequested()) {
+            batch.clear();
+
+            EmbeddingRequest request;
+            m_inRequestQueue.pop(request);
+            batch.emplace_back(std::move(request));
+            while (batch.size() < m_maxBatchSize && m_inRequestQueue.try_pop(request))
+                batch.emplace_back(std::move(request));
+
+            process(batch);
+
+            if (m_isDirty && save_timer.hasExpired(save_interval)) {
+                save();
+                save_timer.restart();
+            }
+        }
+    }
+    catch(const tbb::user_abort &) {}
+    catch(const std::exception &e) {
+        qCCritical(logger) << e.what();
+    }
+    catch(...) {
+        qCCritical(logger) << "Uknown/Uncaught exception occurred.";
+    }
+
+    if (m_isDirty)
+        save();
+
+    qCInfo(logger) << "Stopping" << objectName() << "thread";
+}
+
+std::unique_ptr<ReIdEmbedder> EmbeddingsManager::createEmbedder()
+{
+    const PredictorConfig config = m_config.predictor.value_or(PredictorConfig());
+
+    std::unordered_map<std::string, std::string> ov_options;
+    ov_options["device_type"] = "CPU";
+    ov_options["precision"] = "ACCURACY";
+    ov_options["num_of_threads"] = "1";
+    ov_options["disable_dynamic_shapes"] = "false";
+
+    std::shared_ptr<Ort::SessionOptions> session_options = std::make_shared<Ort::SessionOptions>();
+    session_options->DisablePerSessionThreads();
+    session_options->AppendExecutionProvider_OpenVINO_V2(ov_options);
+
+    std::unique_ptr<ONNXInference> infer = std::make_unique<ONNXInference>(config, m_env, session_options, nullptr, nullptr);
+    return std::make_unique<ReIdEmbedder>(config, std::move(infer));
+}
+
+void EmbeddingsManager::process(std::vector<EmbeddingRequest> &batch)
+{
+    std::erase_if(batch, [](const EmbeddingRequest &request) {
+        return request.crop.empty();
+    });
+    if (batch.empty())
+        return;
+
+    MatList crops;
+    crops.reserve(batch.size());
+    for (const auto &request : batch)
+        crops.emplace_back(request.crop);
+
+    const std::vector<std::vector<float>> embeddings = m_embedder->embed(crops);
+    for (size_t i = 0; i < std::min(batch.size(), embeddings.size()); ++i) {
+        const auto &embedding = embeddings[i];
+        if (embedding.empty())
+            continue;
+
+        // A model with a dynamic output only tells with its first embedding
+        if (m_index->dims() == 0)
+            m_index->reset(static_cast<int>(embedding.size()));
+        if (m_index->dims() != static_cast<int>(embedding.size())) {
+            qCWarning(logger) << "Embedding size" << embedding.size() << "doesn't match the index," << m_index->dims()
+                              << ", was the re-ID model changed? Skipping event" << batch[i].eventId;
+            continue;
+        }
+
+        m_index->add(batch[i].eventId, cameraGroup(batch[i].camera), embedding.data());
+        m_isDirty = true;
+        emit embedded(batch[i].eventId);
+    }
+
+    maybeTrain();
+}
+
+void EmbeddingsManager::maybeTrain()
+{
+    if (m_config.index.value_or(VectorIndexEnum::Flat) != VectorIndexEnum::IVF || m_index->size() < m_nextTrainSize)
+        return;
+
+    const int lists = std::max(1, m_config.ivf_lists.value_or(256));
+    QElapsedTimer timer;
+    timer.start();
+    m_index->train(lists, TRAIN_ITERATIONS, lists * TRAIN_SAMPLES_PER_LIST);
+    qCInfo(logger) << "Trained the re-ID index with" << lists << "lists over" << m_index->size()
+                   << "vectors in" << timer.elapsed() << "ms";
+
+    // Re-train as the distribution drifts, each time it doubles
+    m_nextTrainSize = m_index->size() * 2;
+    m_isDirty = true;
+}
+
+void EmbeddingsManager::load()
+{
+    // Of the model's size, or whatever the file has if the model doesn't tell
+    const int dims = m_embedder->dims();
+    if (!m_indexPath.isEmpty() && QFile::exists(m_indexPath)) {
+        if (m_index->load(m_indexPath.toStdString(), dims))
+            qCInfo(logger) << "Loaded" << m_index->size() << "embeddings from" << m_indexPath;
+        else
+            qCWarning(logger) << "Failed loading the re-ID index" << m_indexPath << ", starting with an empty one";
+    }
+    if (m_index->size() == 0)
+        m_index->reset(dims);
+
+    const size_t train_size = std::max(1, m_config.ivf_train_size.value_or(20000));
+    m_nextTrainSize = m_index->isTrained() ? std::max(train_size, m_index->size() * 2) : train_size;
+}
+
+void EmbeddingsManager::save()
+{
+    if (m_indexPath.isEmpty())
+        return;
+
+    if (m_index->save(m_indexPath.toStdString()))
+        m_isDirty = false;
+    else
+        qCWarning(logger) << "Failed saving the re-ID index to" << m_indexPath;
+}
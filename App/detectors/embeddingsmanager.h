@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <QString>
+#include <QThread>
+#include <onnxruntime_cxx_api.h>
+#include <opencv2/core/mat.hpp>
+
+#include <tbb_patched.h>
+#include <config/reidconfig.h>
+#include <detectors/reidembedder.h>
+#include <utils/vectorindex.h>
+
+/**
+ * @brief The best crop of a completed event, handed over to be embedded.
+ */
+struct EmbeddingRequest {
+    size_t eventId = 0;
+    QString camera;
+    cv::Mat crop;               // Owned by the request
+};
+
+using EmbeddingRequestQueue = tbb::concurrent_bounded_queue<EmbeddingRequest>;
+
+/**
+ * @brief Embeds the crops of completed events and adds them to the re-ID VectorIndex.
+ *
+ * Runs off the tracking path, requests are batched up to the configured batch size. The index
+ * is saved periodically and on exit. In IVF mode it is trained once enough vectors are in, and
+ * re-trained every time it doubles.
+ */
+class EmbeddingsManager : public QThread
+{
+    Q_OBJECT
+public:
+    explicit EmbeddingsManager(EmbeddingRequestQueue &inRequestQueue,
+                               std::shared_ptr<VectorIndex> index,
+                               const ReIdConfig &config,
+                               std::shared_ptr<Ort::Env> env,
+                               const QString &indexPath,
+                               QObject *parent = nullptr);
+    void stop();
+    // The group events of a camera are indexed under.
+    static uint32_t cameraGroup(const QString &camera);
+
+signals:
+    void embedded(size_t eventId);
+
+protected:
+    // QThread interface
+    void run() override;
+
+private:
+    std::unique_ptr<ReIdEmbedder> createEmbedder();
+    void process(std::vector<EmbeddingRequest> &batch);
+    void maybeTrain();
+    // The one saved before, if it was of the same model
+    void load();
+    void save();
+
+private:
+    EmbeddingRequestQueue &m_inRequestQueue;
+    std::shared_ptr<VectorIndex> m_index;
+    ReIdConfig m_config;
+    std::shared_ptr<Ort::Env> m_env;
+    QString m_indexPath;
+    std::unique_ptr<ReIdEmbedder> m_embedder;
+    size_t m_maxBatchSize = 8;
+    size_t m_nextTrainSize = 0;
+    bool m_isDirty = false;
+};
@@ -82,6 +82,45 @@ void Utils::letterBox(const cv::Mat &image, cv::Mat &outImage, const cv::Size &n
     cv::copyMakeBorder(outImage, outImage, pad_top, pad_bottom, pad_left, pad_right, cv::BORDER_CONSTANT, color);
 }
 
+void Utils::letterBoxToTensor(const cv::Mat &image, float *tensorData, const cv::Size &newShape, cv::Mat &canvas, MatList &planes, const cv::Scalar &color) {
+    if (image.empty() || !tensorData)
+        return;
+
+    float ratio = std::min(static_cast<float>(newShape.height) / image.rows,
+                           static_cast<float>(newShape.width) / image.cols);
+    cv::Size size_unpdd(std::round(image.cols * ratio), std::round(image.rows * ratio));
+    size_unpdd.width = clamp(size_unpdd.width, 1, newShape.width);
+    size_unpdd.height = clamp(size_unpdd.height, 1, newShape.height);
+
+    int pad_left = (newShape.width - size_unpdd.width) / 2;
+    int pad_top = (newShape.height - size_unpdd.height) / 2;
+
+    // Only the padding has to be reset, the content area is overwritten by the resize.
+    canvas.create(newShape, CV_8UC3);
+    const int pad_right = newShape.width - size_unpdd.width - pad_left;
+    const int pad_bottom = newShape.height - size_unpdd.height - pad_top;
+    for (const cv::Rect &strip : { cv::Rect(0, 0, newShape.width, pad_top),
+                                   cv::Rect(0, pad_top + size_unpdd.height, newShape.width, pad_bottom),
+                                   cv::Rect(0, pad_top, pad_left, size_unpdd.height),
+                                   cv::Rect(pad_left + size_unpdd.width, pad_top, pad_right, size_unpdd.height) }) {
+        if (!strip.empty())
+            canvas(strip).setTo(color);
+    }
+
+    // Resizing into a correctly sized ROI header writes in-place into the canvas.
+    cv::Mat content = canvas(cv::Rect(pad_left, pad_top, size_unpdd.width, size_unpdd.height));
+    cv::resize(image, content, size_unpdd);
+
+    planes.resize(3);
+    cv::split(canvas, planes);
+
+    const int area = newShape.area();
+    for (int c = 0; c < 3; ++c) {
+        cv::Mat plane(newShape, CV_32FC1, tensorData + c * area);
+        planes[c].convertTo(plane, CV_32FC1, 1 / 255.0f);
+    }
+}
+
 cv::Rect Utils::scaleCoords(const cv::Size &resizedImageShape, cv::Rect coords, const cv::Size &originalImageShape, bool p_Clip) {
     cv::Rect result;
     float gain = std::min(static_cast<float>(resizedImageShape.height) / static_cast<float>(originalImageShape.height),
@@ -82,6 +82,25 @@ public:
                           const cv::Scalar& color = cv::Scalar(114, 114, 114),
                           bool scale = true);
 
+    /**
+     * @brief Letterboxes an image (or an ROI view of a parent frame) straight into a planar float tensor.
+     *
+     * The image is resized into a reusable 8-bit canvas and each channel is normalized to [0, 1] directly
+     * into its CHW plane, so neither a cropped copy nor an intermediate float image is created.
+     *
+     * @param image Input image, may be a non-continuous ROI view.
+     * @param tensorData Destination of 3 * newShape.area() floats, in CHW order.
+     * @param newShape Desired output size.
+     * @param canvas Reusable letterbox canvas, (re)allocated only when newShape changes.
+     * @param planes Reusable per-channel buffers.
+     * @param color Padding color (default is gray).
+     */
+    static void letterBoxToTensor(const cv::Mat &image, float *tensorData,
+                                  const cv::Size &newShape,
+                                  cv::Mat &canvas,
+                                  MatList &planes,
+                                  const cv::Scalar &color = cv::Scalar(114, 114, 114));
+
     /**
      * @brief Scales detection coordinates back to the original image size.
      *
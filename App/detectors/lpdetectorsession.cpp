@@ -57,76 +57,94 @@ void LPDetectorSession::run() {
 
         m_eps.start();
 
+        struct PendingFrame {
+            SharedFrame frame;
+            cv::Mat data;
+            PredictionList predictions;
+        };
+
+        std::vector<PendingFrame> pending;
+        std::vector<std::pair<size_t, size_t>> vehicles;    // <pending frame, prediction>
+        MatList batch;
+
         while (!QThread::currentThread()->isInterruptionRequested()) {
+            pending.clear();
+            vehicles.clear();
+
+            // Block for one frame, then drain whatever else is already queued (from any camera)
+            // until we have enough vehicles for a full batch.
             SharedFrame frame;
             m_inFrameQueue.pop(frame);
-            if (!frame || frame->hasExpired())
-                continue;
-
-            // Detect LPs for a single frame.
-            // We only need no-copy Mats from each frame that that are one of the filtered classes
-            PredictionList object_predictions = frame->predictions();
-            // std::vector<Prediction*> filtered_vehicle_predictions;
-
-            // for (const auto& prediction : object_predictions) {
-            //     if (voi.contains(prediction.className) && prediction.hasDeltas)
-            //         filtered_vehicle_predictions.emplace_back(&prediction);
-            // }
-
-            MatList batch;
-            // PredictionList lp_predictions;
-            std::vector<int> vehicle_indxs;
-            for (size_t p = 0; p < object_predictions.size(); ++p) {
-                const auto &prediction = object_predictions.at(p);
-                if (!(voi.contains(prediction.className) && prediction.hasDeltas))
+            do {
+                if (!frame || frame->hasExpired())
                     continue;
-                
-                // Is vehicle
-                cv::Mat vehicle;
-                Utils::crop(frame->data(), vehicle, prediction.box);
-                batch.emplace_back(vehicle);
-                vehicle_indxs.emplace_back(p);
-
-                // Model doesn't support dynamic batch || Max batch size reached || No more predictions to complete the batch.
-                if (!m_keyPointDetector->hasDynamicBatch() || batch.size() >= max_batch_size || p + 1 >= object_predictions.size()) {
-                    // Detect LP
-                    std::vector<PredictionList> results_list = m_keyPointDetector->predict(batch);
-
-                    for (size_t b = 0; b < batch.size(); ++b) {
-                        const auto &vehicle_pred = object_predictions[vehicle_indxs.at(b)];
-
-                        // Go through each plate result, displace coordinates to the vehicle's location.
-                        for (auto &plate : results_list.at(b)) {
-                            // Displace LP box coordinates
-                            plate.box.x += vehicle_pred.box.x;
-                            plate.box.y += vehicle_pred.box.y;
-
-                            // Displace LP keypoint coordinates
-                            for (auto& point : plate.points) {
-                                point.x += vehicle_pred.box.x;
-                                point.y += vehicle_pred.box.y;
-                            }
-                        }
 
-                        if (!results_list.at(b).empty())
-                            object_predictions[vehicle_indxs.at(b)].subPredictions = filterLicensePlates(results_list.at(b));
+                // A single Mat header per frame, vehicles are ROI views into it.
+                PendingFrame &entry = pending.emplace_back(PendingFrame{ frame, frame->data(), frame->predictions() });
+                const cv::Rect frame_rect(0, 0, entry.data.cols, entry.data.rows);
+
+                for (size_t p = 0; p < entry.predictions.size(); ++p) {
+                    auto &prediction = entry.predictions[p];
+                    if (!(voi.contains(prediction.className) && prediction.hasDeltas))
+                        continue;
+
+                    prediction.box &= frame_rect;
+                    if (prediction.box.empty())
+                        continue;
+
+                    vehicles.emplace_back(pending.size() - 1, p);
+                }
+            } while (vehicles.size() < static_cast<size_t>(max_batch_size)
+                     && m_inFrameQueue.try_pop(frame));
+
+            // Model doesn't support dynamic batch, so feed the vehicles one by one.
+            const size_t chunk_size = m_keyPointDetector->hasDynamicBatch() ? std::max(max_batch_size, 1) : 1;
+            for (size_t offset = 0; offset < vehicles.size(); offset += chunk_size) {
+                const size_t end = std::min(vehicles.size(), offset + chunk_size);
+
+                batch.clear();
+                for (size_t v = offset; v < end; ++v) {
+                    const auto &[f, p] = vehicles[v];
+                    batch.emplace_back(pending[f].data(pending[f].predictions[p].box));
+                }
+
+                // Detect LP
+                std::vector<PredictionList> results_list = m_keyPointDetector->predict(batch);
+
+                for (size_t b = 0; b < results_list.size() && offset + b < end; ++b) {
+                    const auto &[f, p] = vehicles[offset + b];
+                    Prediction &vehicle_pred = pending[f].predictions[p];
+
+                    // Go through each plate result, displace coordinates to the vehicle's location.
+                    for (auto &plate : results_list[b]) {
+                        // Displace LP box coordinates
+                        plate.box.x += vehicle_pred.box.x;
+                        plate.box.y += vehicle_pred.box.y;
+
+                        // Displace LP keypoint coordinates
+                        for (auto& point : plate.points) {
+                            point.x += vehicle_pred.box.x;
+                            point.y += vehicle_pred.box.y;
+                        }
                     }
 
-                    batch.clear();
-                    vehicle_indxs.clear();
+                    if (!results_list[b].empty())
+                        vehicle_pred.subPredictions = filterLicensePlates(results_list[b]);
                 }
             }
 
-            if (!frame || frame->hasExpired())
-                continue;
+            for (auto &entry : pending) {
+                if (!entry.frame || entry.frame->hasExpired())
+                    continue;
 
-            frame->setPredictions(std::move(object_predictions));
-            frame->setHasBeenProcessed(true);   // NOTE: This is very necessary to prevent CameraProcessor's prediction blocking, if finished very early.
-            QString camera_name = frame->camera();
-            Q_ASSERT(m_cameraWaitConditions.contains(camera_name));
-            m_cameraWaitConditions.value(camera_name)->notify_all();    // Notify waiting camera processors.
+                entry.frame->setPredictions(std::move(entry.predictions));
+                entry.frame->setHasBeenProcessed(true);   // NOTE: This is very necessary to prevent CameraProcessor's prediction blocking, if finished very early.
+                QString camera_name = entry.frame->camera();
+                Q_ASSERT(m_cameraWaitConditions.contains(camera_name));
+                m_cameraWaitConditions.value(camera_name)->notify_all();    // Notify waiting camera processors.
 
-            m_eps.update();
+                m_eps.update();
+            }
         }
     }
     catch(const tbb::user_abort &) {}
@@ -0,0 +1,74 @@
+#include "lprrequestqueue.h"
+
+LPRRequestQueue::LPRRequestQueue(int capacity)
+{
+    setCapacity(capacity);
+}
+
+void LPRRequestQueue::setCapacity(int capacity)
+{
+    m_priority.set_capacity(capacity);
+    m_normal.set_capacity(capacity);
+}
+
+bool LPRRequestQueue::tryPush(LPRRequest request, bool priority)
+{
+    if (m_aborted.load(std::memory_order_acquire))
+        return false;
+
+    auto &lane = priority ? m_priority : m_normal;
+    if (!lane.try_push(std::move(request)))
+        return false;
+
+    m_available.release();
+    return true;
+}
+
+size_t LPRRequestQueue::popBatch(std::vector<LPRRequest> &batch, size_t maxBatchSize, int timeoutMs)
+{
+    const size_t start = batch.size();
+    if (maxBatchSize == 0 || !m_available.tryAcquire(1, timeoutMs))
+        return 0;
+
+    if (m_aborted.load(std::memory_order_acquire)) {
+        // Passes the wake up on to the next worker waiting
+        m_available.release();
+        return 0;
+    }
+
+    do {
+        LPRRequest request;
+        if (popOne(request))
+            batch.emplace_back(std::move(request));
+    } while (batch.size() - start < maxBatchSize && m_available.tryAcquire(1));
+
+    return batch.size() - start;
+}
+
+void LPRRequestQueue::abort()
+{
+    m_aborted.store(true, std::memory_order_release);
+
+    // clear() isn't safe while the workers pop, drained one at a time instead
+    LPRRequest request;
+    while (popOne(request)) {}
+
+    // Wakes the workers waiting for a request, each one wakes the next
+    m_available.release();
+}
+
+bool LPRRequestQueue::isAborted() const
+{
+    return m_aborted.load(std::memory_order_acquire);
+}
+
+size_t LPRRequestQueue::size() const
+{
+    return std::max<std::ptrdiff_t>(0, m_priority.size()) + std::max<std::ptrdiff_t>(0, m_normal.size());
+}
+
+bool LPRRequestQueue::popOne(LPRRequest &request)
+{
+    // A permit was acquired, so one of the lanes holds a request for us.
+    return m_priority.try_pop(request) || m_normal.try_pop(request);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include <QSemaphore>
+#include <QString>
+#include <opencv2/core/mat.hpp>
+
+#include <tbb_patched.h>
+
+/**
+ * @brief A plate handed over, in memory, from the TrackedObjectProcessor to the recognizer.
+ * A track may hand over several plates while it is alive, their readings are fused.
+ */
+struct LPRRequest {
+    size_t eventId = 0;
+    QString camera;
+    int trackerId = -1;
+    cv::Mat plate;              // Rectified plate crop, owned by the request
+    cv::Rect plateBox;          // Where the plate was in the frame
+    float quality = 0.0f;       // See PlateFusion::quality()
+};
+
+/**
+ * @brief Bounded, two-lane queue of LPRRequests shared by the LPR worker pool.
+ *
+ * Requests of priority cameras (i.e. the ones watching for known plates) are always
+ * handed out before the rest.
+ */
+class LPRRequestQueue
+{
+public:
+    explicit LPRRequestQueue(int capacity = 32);
+    void setCapacity(int capacity);
+    // Never blocks, returns false if the lane is full.
+    bool tryPush(LPRRequest request, bool priority = false);
+    // Waits up to timeoutMs for a request, then takes whatever else is queued, up to maxBatchSize.
+    size_t popBatch(std::vector<LPRRequest> &batch, size_t maxBatchSize, int timeoutMs = 100);
+    // Drops what's queued and wakes the workers, safe while they pop.
+    void abort();
+    bool isAborted() const;
+    size_t size() const;
+
+private:
+    bool popOne(LPRRequest &request);
+
+private:
+    tbb::concurrent_bounded_queue<LPRRequest> m_priority;
+    tbb::concurrent_bounded_queue<LPRRequest> m_normal;
+    QSemaphore m_available;
+    std::atomic_bool m_aborted = false;
+};
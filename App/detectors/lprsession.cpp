@@ -1,5 +1,6 @@
 
 #include <array>
+#include <numeric>
 #include <cstdint>
 #include <qobject.h>
 #include <string>
@@ -7,11 +8,11 @@
 #include <cstddef>
 #include <filesystem>
 
+#include <QDateTime>
+#include <QFileInfo>
 #include <QUrl>
 #include <QLoggingCategory>
 
-#include <odb/sqlite/database.hxx>
-#include <odb/transaction.hxx>
 #include <onnxruntime_cxx_api.h>
 #include <opencv2/core/mat.hpp>
 #include <opencv2/imgcodecs.hpp>
@@ -24,7 +25,6 @@
 #include <fmr/paddle/ocr/detector.hpp>
 
 #include <apss.h>
-#include <db/event-odb.hxx>
 #include <utils/rfl_opencv.hpp>
 #include "lprsession.h"
 
@@ -32,18 +32,37 @@ Q_STATIC_LOGGING_CATEGORY(logger, "apss.sessions.lpr")
 
 namespace pocr = fmr::paddle::ocr;
 
-LPRSessionWorker::LPRSessionWorker(std::shared_ptr<Ort::Env> env, std::shared_ptr<odb::database> db, const LicensePlateConfig &config, QObject *parent)
-    : QObject(parent)
-    , m_env(env)
-    , m_db(db)
+LPRSession::LPRSession(const QString &name,
+                       LPRRequestQueue &inRequestQueue,
+                       PlateFusionStore &plateFusion,
+                       const KnownPlates *knownPlates,
+                       RecentPlateCache *recentPlates,
+                       const QHash<QString, SharedCameraMetrics> &cameraMetrics,
+                       const LPRModels &models,
+                       EventWriter &eventWriter,
+                       const LicensePlateConfig &config,
+                       QObject *parent)
+    : QThread(parent)
+    , m_inRequestQueue(inRequestQueue)
+    , m_plateFusion(plateFusion)
+    , m_knownPlates(knownPlates)
+    , m_recentPlates(recentPlates)
+    , m_cameraMetrics(cameraMetrics)
+    , m_eventWriter(eventWriter)
     , m_lpConfig(config)
 {
-    setObjectName("apss.sessions.lpr");
+    setObjectName(name);
+
+    m_det.ac = models.det;
+    m_cls.ac = models.cls;
+    m_rec.ac = models.rec;
+    m_maxBatchSize = std::max(1, m_lpConfig.batch_size.value_or(1));
 }
 
-void LPRSessionWorker::init()
+LPRModels LPRSession::loadModels(std::shared_ptr<Ort::Env> env)
 {
-    // In a new thread, probably.
+    LPRModels models;
+
     // Detector session
     fmr::predictor_config det_pconfig;
     det_pconfig.model_path = "models/PP-OCRv5_mobile_det_infer_slim_onnx/inference.onnx";
@@ -57,14 +76,7 @@ void LPRSessionWorker::init()
     std::shared_ptr<Ort::SessionOptions> det_options = std::make_shared<Ort::SessionOptions>();
     det_options->DisablePerSessionThreads();
     det_options->AppendExecutionProvider_OpenVINO_V2(det_ov_options);
-
-// #ifdef APSS_USE_PADDLEOCR_YML
-//     fmr::paddleocr_config det_config = readPaddleOCRDetYaml(det_pconfig.model_path.value());
-// #else
-    fmr::paddleocr_config det_config;
-// #endif
-    m_det.ac = QSharedPointer<fmr::onnxruntime>::create(det_pconfig, m_env, det_options);
-    m_det.p = QSharedPointer<pocr::detector>::create(m_det.ac.get(), det_config);
+    models.det = QSharedPointer<fmr::onnxruntime>::create(det_pconfig, env, det_options);
 
     // Classifier session
     fmr::predictor_config cls_pconfig;
@@ -79,14 +91,7 @@ void LPRSessionWorker::init()
     std::shared_ptr<Ort::SessionOptions> cls_options = std::make_shared<Ort::SessionOptions>();
     cls_options->DisablePerSessionThreads();
     cls_options->AppendExecutionProvider_OpenVINO_V2(cls_ov_options);
-
-// #ifdef APSS_USE_PADDLEOCR_YML
-//     fmr::paddleocr_config cls_config = readPaddleOCRClsYaml(cls_pconfig.model_path.value());
-// #else
-    fmr::paddleocr_config cls_config;
-// #endif
-    m_cls.ac = QSharedPointer<fmr::onnxruntime>::create(cls_pconfig, m_env, cls_options);
-    m_cls.p = QSharedPointer<pocr::classifier>::create(m_cls.ac.get(), cls_config);
+    models.cls = QSharedPointer<fmr::onnxruntime>::create(cls_pconfig, env, cls_options);
 
     // Recognizer session
     fmr::predictor_config rec_pconfig;
@@ -101,49 +106,231 @@ void LPRSessionWorker::init()
     std::shared_ptr<Ort::SessionOptions> rec_options = std::make_shared<Ort::SessionOptions>();
     rec_options->DisablePerSessionThreads();
     rec_options->AppendExecutionProvider_OpenVINO_V2(rec_ov_options);
-    
-// #ifdef APSS_USE_PADDLEOCR_YML 
+    models.rec = QSharedPointer<fmr::onnxruntime>::create(rec_pconfig, env, rec_options);
+
+    return models;
+}
+
+void LPRSession::stop()
+{
+    try {
+        if (isRunning()) {
+            requestInterruption();
+
+            qCDebug(logger) << "Waiting for" << objectName() << "to exit gracefully...";
+            if (!wait(3000)) {
+                qCDebug(logger) << objectName() << "didn't exit. Applying force killing...";
+                terminate();
+                wait();
+            }
+            qCDebug(logger) << objectName() << "thread has exited...";
+        }
+    } catch (const std::exception &e) {
+        qCDebug(logger) << e.what();
+    } catch (...) {
+        qCCritical(logger) << "Uknown/Uncaught exception occurred!";
+    }
+}
+
+void LPRSession::run()
+{
+    qCInfo(logger) << "Starting" << objectName() << "thread";
+
+    try {
+        init();
+
+        std::vector<LPRRequest> batch;
+        batch.reserve(m_maxBatchSize);
+
+        while (!isInterruptionRequested() && !m_inRequestQueue.isAborted()) {
+            batch.clear();
+            if (m_inRequestQueue.popBatch(batch, m_maxBatchSize) == 0)
+                continue;
+
+            process(batch);
+        }
+    }
+    catch(const tbb::user_abort &) {}
+    catch(const std::exception &e) {
+        qCCritical(logger) << e.what();
+    }
+    catch(...) {
+        qCCritical(logger) << "Uknown/Uncaught exception occurred.";
+    }
+
+    qCInfo(logger) << "Stopping" << objectName() << "thread";
+}
+
+void LPRSession::init()
+{
+    // The accelerators (ORT sessions) are shared by the pool, the pre/post-processing wrappers are per worker.
+// #ifdef APSS_USE_PADDLEOCR_YML
+//     fmr::paddleocr_config det_config = readPaddleOCRDetYaml(det_pconfig.model_path.value());
+//     fmr::paddleocr_config cls_config = readPaddleOCRClsYaml(cls_pconfig.model_path.value());
 //     fmr::paddleocr_config rec_config = readPaddleOCRRecYaml(rec_pconfig.model_path.value());
 // #else
+    fmr::paddleocr_config det_config;
+    fmr::paddleocr_config cls_config;
     fmr::paddleocr_config rec_config;
-    // #endif
+// #endif
     // Some other options
     rec_config.thresh = m_lpConfig.recognition_threshold;
-    m_rec.ac = QSharedPointer<fmr::onnxruntime>::create(rec_pconfig, m_env, rec_options);
+
+    m_det.p = QSharedPointer<pocr::detector>::create(m_det.ac.get(), det_config);
+    m_cls.p = QSharedPointer<pocr::classifier>::create(m_cls.ac.get(), cls_config);
     m_rec.p = QSharedPointer<pocr::recognizer>::create(m_rec.ac.get(), rec_config);
 
     m_ocrEngine = QSharedPointer<pocr::pipeline>::create(*m_det.p, *m_cls.p, *m_rec.p);
 }
 
-void LPRSessionWorker::process(size_t eventDbId)
+std::vector<LPRSession::OCRResultList> LPRSession::recognize(const MatList &plates)
 {
-    try {
-        APSS::ODB::Event event;
+    std::vector<OCRResultList> results_list(plates.size());
+    std::vector<size_t> full_indxs;
+
+    if (m_lpConfig.mode.value_or(LPRModeEnum::Full) == LPRModeEnum::RecognitionOnly) {
+        // The plates are already rectified with the keypoints, so a single-line plate can go straight
+        // to the recognizer. Anything taller than a single line still needs text detection.
+        MatList single_line;
+        std::vector<size_t> single_line_indxs;
+        for (size_t i = 0; i < plates.size(); ++i) {
+            const cv::Mat &plate = plates[i];
+            if (plate.rows > 0 && plate.cols >= plate.rows * LPR_SINGLE_LINE_MIN_ASPECT) {
+                single_line.emplace_back(plate);
+                single_line_indxs.emplace_back(i);
+            } else {
+                full_indxs.emplace_back(i);
+            }
+        }
 
-        {
-            odb::transaction t(m_db->begin());
-            m_db->load(eventDbId, event);
-            t.commit();
+        const auto rec_results = single_line.empty() ? decltype(m_rec.p->predict(single_line)){}
+                                                     : m_rec.p->predict(single_line);
+        for (size_t r = 0; r < single_line_indxs.size(); ++r) {
+            const size_t indx = single_line_indxs[r];
+            if (r >= rec_results.size()
+                || rec_results[r].first.empty()
+                || rec_results[r].second < m_lpConfig.recognition_threshold) {
+                full_indxs.emplace_back(indx);
+                continue;
+            }
+
+            OCRResult result;
+            result.text = rec_results[r].first;
+            result.score = rec_results[r].second;
+            results_list[indx] = { result };
         }
+    } else {
+        full_indxs.resize(plates.size());
+        std::iota(full_indxs.begin(), full_indxs.end(), 0);
+    }
+
+    if (full_indxs.empty())
+        return results_list;
+
+    MatList full_plates;
+    full_plates.reserve(full_indxs.size());
+    for (size_t indx : full_indxs)
+        full_plates.emplace_back(plates[indx]);
+
+    auto full_results = m_ocrEngine->predict(full_plates);
+    for (size_t f = 0; f < full_indxs.size() && f < full_results.size(); ++f)
+        results_list[full_indxs[f]] = std::move(full_results[f]);
+
+    return results_list;
+}
 
-        QString plate_path = QString("%1_%2_lp.jpg").arg(event.camera).arg(event.trackerId);
-        plate_path = THUMB_DIR.filePath(plate_path);
-        if (!QFile::exists(plate_path))
+PlateReading LPRSession::toReading(const OCRResultList &results, float quality)
+{
+    // Two-line plates come out as separate lines, top to bottom
+    PlateReading reading;
+    reading.quality = quality;
+    if (results.empty())
+        return reading;
+
+    float score_sum = 0.0f;
+    for (const auto &result : results) {
+        reading.text += result.text;
+        score_sum += result.score;
+    }
+    reading.score = score_sum / results.size();
+
+    return reading;
+}
+
+void LPRSession::process(std::vector<LPRRequest> &batch)
+{
+    try {
+        // Plates queued before their track converged aren't worth reading anymore.
+        std::erase_if(batch, [this](const LPRRequest &request) {
+            if (!m_plateFusion.hasConverged(request.eventId))
+                return false;
+
+            m_plateFusion.skipped(request.eventId);
+            return true;
+        });
+
+        if (batch.empty())
             return;
 
-        cv::Mat plate = cv::imread(plate_path.toStdString());
-        
-        auto results_list = m_ocrEngine->predict({plate});
-        const auto &results = results_list.at(0);
-        event.licensePlateResults = QString::fromStdString(rfl::json::write(results));
+        // A plate seen moments ago at the same spot, i.e. the same vehicle under a new tracker id, reuses that reading.
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        std::vector<uint64_t> hashes(batch.size(), 0);
+        std::vector<std::optional<FusedPlate>> cached(batch.size());
+        if (m_recentPlates) {
+            for (size_t i = 0; i < batch.size(); ++i) {
+                hashes[i] = RecentPlateCache::dHash(batch[i].plate);
+                cached[i] = m_recentPlates->find(batch[i].camera, batch[i].eventId, hashes[i], batch[i].plateBox, now);
+
+                // Shared by the workers, only ever read
+                if (const SharedCameraMetrics metrics = m_cameraMetrics.value(batch[i].camera))
+                    metrics->setPlateCacheHitRate(m_recentPlates->hitRate(batch[i].camera));
+            }
+        }
+
+        // Plates of different events go through the recognizer together.
+        MatList plates;
+        plates.reserve(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (!cached[i])
+                plates.emplace_back(batch[i].plate);
+        }
+
+        std::vector<OCRResultList> results_list = plates.empty() ? std::vector<OCRResultList>() : recognize(plates);
+
+        std::vector<FusedPlate> fused_plates;
+        fused_plates.reserve(batch.size());
+        for (size_t i = 0, r = 0; i < batch.size(); ++i) {
+            PlateReading reading;
+            if (cached[i]) {
+                reading = { cached[i]->text, cached[i]->score, batch[i].quality };
+            } else {
+                const OCRResultList results = r < results_list.size() ? results_list[r] : OCRResultList();
+                reading = toReading(results, batch[i].quality);
+                r++;
+            }
+
+            fused_plates.emplace_back(m_plateFusion.addReading(batch[i].eventId, reading));
+
+            if (m_recentPlates)
+                m_recentPlates->insert(batch[i].camera, batch[i].eventId, hashes[i], batch[i].plateBox, fused_plates.back(), now);
+        }
+
+        // Watchlist, the index may be swapped underneath at any time, so it's held for the whole batch.
+        const std::shared_ptr<const KnownPlatesIndex> known_plates = m_knownPlates ? m_knownPlates->index() : nullptr;
+
+        // The tracks may still be alive, the event writer only touches the plate columns.
+        for (size_t i = 0; i < batch.size(); ++i) {
+            std::optional<QString> sub_label;
+            if (known_plates && known_plates->size() > 0 && !fused_plates[i].text.empty()) {
+                const auto match = known_plates->bestMatch(fused_plates[i].text, m_lpConfig.match_distance);
+                sub_label = match ? QString::fromStdString(match->label) : QString();
+            }
 
-        {
-            odb::transaction t(m_db->begin());
-            m_db->update(event);
-            t.commit();
+            m_eventWriter.updatePlate(batch[i].eventId, QString::fromStdString(rfl::json::write(fused_plates[i])), sub_label);
         }
 
-        emit processed(eventDbId);
+        for (const auto &request : batch)
+            emit processed(request.eventId);
     } catch (const std::exception &e) {
         qCCritical(logger) << e.what();
     }
@@ -182,7 +369,7 @@ void LPRSessionWorker::process(size_t eventDbId)
 //     };
 // }
 
-// fmr::paddleocr_config LPRSessionWorker::readPaddleOCRDetYaml(const std::string &detModelPath)
+// fmr::paddleocr_config LPRSession::readPaddleOCRDetYaml(const std::string &detModelPath)
 // {
 //     std::string file_path = getModelYamlPath(detModelPath);
 //     if (!std::filesystem::exists(file_path)) {
@@ -263,7 +450,7 @@ void LPRSessionWorker::process(size_t eventDbId)
 //     return config;
 // }
 
-// fmr::paddleocr_config LPRSessionWorker::readPaddleOCRClsYaml(const std::string &clsModelPath)
+// fmr::paddleocr_config LPRSession::readPaddleOCRClsYaml(const std::string &clsModelPath)
 // {
 //     std::string file_path = getModelYamlPath(clsModelPath);
 //     if (!std::filesystem::exists(file_path)) {
@@ -343,7 +530,7 @@ void LPRSessionWorker::process(size_t eventDbId)
 //     return config;
 // }
 
-// fmr::paddleocr_config LPRSessionWorker::readPaddleOCRRecYaml(const std::string &recModelPath)
+// fmr::paddleocr_config LPRSession::readPaddleOCRRecYaml(const std::string &recModelPath)
 // {
 //     std::string file_path = getModelYamlPath(recModelPath);
 //     if (!std::filesystem::exists(file_path)) {
@@ -410,7 +597,7 @@ void LPRSessionWorker::process(size_t eventDbId)
 //     return config;
 // }
 
-std::string LPRSessionWorker::getModelYamlPath(const std::string &modelPath)
+std::string LPRSession::getModelYamlPath(const std::string &modelPath)
 {
     const QFileInfo info = QFileInfo(QString::fromStdString(modelPath));
     return QString("%1/%2.yml").arg(info.path(), info.baseName()).toStdString();
@@ -1,41 +1,85 @@
 #pragma once
 
-#include "config/licenseplateconfig.h"
 #include <memory>
 #include <cstddef>
 #include <string>
+#include <type_traits>
+#include <utility>
 
-#include <QObject>
-#include <odb/database.hxx>
+#include <QThread>
 #include <onnxruntime_cxx_api.h>
+#include <opencv2/core/mat.hpp>
 #include <fmr/accelerators/accelerator.hpp>
 #include <fmr/config/paddleocrconfig.hpp>
 #include <fmr/paddle/ocr/detector.hpp>
 #include <fmr/paddle/ocr/pipeline.hpp>
 
-class LPRSessionWorker : public QObject 
+#include <tbb_patched.h>
+#include <apss.h>
+#include <camera/camerametrics.h>
+#include <config/licenseplateconfig.h>
+#include <detectors/lprrequestqueue.h>
+#include <output/eventwriter.h>
+#include <utils/knownplates.h>
+#include <utils/platefusion.h>
+#include <utils/recentplatecache.h>
+
+/**
+ * @brief The det/cls/rec sessions, loaded once and shared by every worker of the pool.
+ */
+struct LPRModels {
+    QSharedPointer<fmr::accelerator> det;
+    QSharedPointer<fmr::accelerator> cls;
+    QSharedPointer<fmr::accelerator> rec;
+};
+
+class LPRSession : public QThread
 {
     Q_OBJECT
 public:
-    explicit LPRSessionWorker(std::shared_ptr<Ort::Env> env, std::shared_ptr<odb::database> db, const LicensePlateConfig &config, QObject *parent = nullptr);
-
-public slots:
-    void init();
-    void process(size_t eventDbId);
+    explicit LPRSession(const QString &name,
+                        LPRRequestQueue &inRequestQueue,
+                        PlateFusionStore &plateFusion,
+                        const KnownPlates *knownPlates,
+                        RecentPlateCache *recentPlates,
+                        const QHash<QString, SharedCameraMetrics> &cameraMetrics,
+                        const LPRModels &models,
+                        EventWriter &eventWriter,
+                        const LicensePlateConfig &config,
+                        QObject *parent = nullptr);
+    static LPRModels loadModels(std::shared_ptr<Ort::Env> env);
+    void stop();
 
 signals:
     void processed(size_t eventDbId);
 
+protected:
+    // QThread interface
+    void run() override;
+
 private:
+    // Per plate results, in the same shape the full pipeline produces them.
+    using OCRResultList = std::decay_t<decltype(std::declval<fmr::paddle::ocr::pipeline &>().predict(std::declval<MatList>()))>::value_type;
+    using OCRResult = OCRResultList::value_type;
+
+    void init();
+    std::vector<OCRResultList> recognize(const MatList &plates);
+    static PlateReading toReading(const OCRResultList &results, float quality);
+    void process(std::vector<LPRRequest> &batch);
     // fmr::paddleocr_config readPaddleOCRDetYaml(const std::string &detModelPath);
     // fmr::paddleocr_config readPaddleOCRClsYaml(const std::string &clsModelPath);
     // fmr::paddleocr_config readPaddleOCRRecYaml(const std::string &recModelPath);
     std::string getModelYamlPath(const std::string &modelPath);
 
 private:
-    std::shared_ptr<Ort::Env> m_env;
-    std::shared_ptr<odb::database> m_db;
+    LPRRequestQueue &m_inRequestQueue;
+    PlateFusionStore &m_plateFusion;
+    const KnownPlates *m_knownPlates = nullptr;
+    RecentPlateCache *m_recentPlates = nullptr;
+    const QHash<QString, SharedCameraMetrics> &m_cameraMetrics;
+    EventWriter &m_eventWriter;
     LicensePlateConfig m_lpConfig;
+    int m_maxBatchSize = 1;
 
     template <typename T>
     struct PredictorPair {
@@ -47,4 +91,4 @@ private:
     PredictorPair<fmr::paddle::ocr::detector> m_det;
     PredictorPair<fmr::paddle::ocr::recognizer> m_rec;
     QSharedPointer<fmr::paddle::ocr::pipeline> m_ocrEngine;
-};
\ No newline at end of file
+};
@@ -9,20 +9,25 @@
 #include <onnxruntime_cxx_api.h>
 
 #include <apss.h>
+#include <detectors/image.h>
 #include <detectors/objectdetectorsession.h>
 #include <detectors/onnxinference.h>
 
 ObjectDetectorSession::ObjectDetectorSession(const QString &name,
                                              SharedFrameBoundedQueue &inFrameQueue,
                                              QHash<QString, QSharedPointer<QWaitCondition>> &cameraWaitConditions,
+                                             QHash<QString, SharedCameraMetrics> &cameraMetrics,
                                              const PredictorConfig &config,
+                                             std::optional<PredictorConfig> escalationConfig,
                                              std::shared_ptr<Ort::Env> env,
                                              QObject *parent)
     : QThread(parent)
     , m_name(name)
     , m_inFrameQueue(inFrameQueue)
     , m_cameraWaitConditions(cameraWaitConditions)
+    , m_cameraMetrics(cameraMetrics)
     , m_config(config)
+    , m_escalationConfig(escalationConfig)
     , m_env(env)
     , m_detector{nullptr}
 {
@@ -30,6 +35,17 @@ ObjectDetectorSession::ObjectDetectorSession(const QString &name,
 
     if (m_config.batch_size)
         m_maxBatchSize = m_config.batch_size.value();
+
+    if (m_escalationConfig) {
+        if (!m_config.cascade)
+            throw std::runtime_error("An escalation predictor was given without a cascade config.");
+
+        m_maxEscalationBatchSize = m_escalationConfig->batch_size.value_or(1);
+        if (m_config.cascade->classes) {
+            const auto &classes = m_config.cascade->classes.value();
+            m_escalationClasses = std::set<std::string>(classes.begin(), classes.end());
+        }
+    }
 }
 
  QSharedPointer<ObjectDetector> ObjectDetectorSession::detector() {
@@ -65,18 +81,11 @@ void ObjectDetectorSession::stop()
 void ObjectDetectorSession::run() {
     qInfo() << "Starting" << objectName() << "thread";
 
-    std::unordered_map<std::string, std::string> ov_options;
-    ov_options["device_type"] = "GPU";
-    ov_options["precision"] = "ACCURACY";
-    ov_options["num_of_threads"] = "1";
-    ov_options["disable_dynamic_shapes"] = "false";
-    
-    std::shared_ptr<Ort::SessionOptions> session_options = std::make_shared<Ort::SessionOptions>();
-    session_options->DisablePerSessionThreads();
-    session_options->AppendExecutionProvider_OpenVINO_V2(ov_options);
-
-    std::unique_ptr<ONNXInference> infer = std::make_unique<ONNXInference>(m_config, m_env, session_options, nullptr, nullptr);
-    m_detector = QSharedPointer<ObjectDetector>(new ObjectDetector(m_config, std::move(infer)));
+    m_detector = createDetector(m_config);
+    if (m_escalationConfig) {
+        m_escalationDetector = createDetector(m_escalationConfig.value());
+        qInfo() << objectName() << "escalates to" << m_config.cascade->escalate_to;
+    }
 
     m_eps.start();
 
@@ -98,6 +107,8 @@ void ObjectDetectorSession::run() {
                 continue;
 
             std::vector<PredictionList> results_list = m_detector->predict(batch);
+            if (m_escalationDetector)
+                escalate(batch, frames, results_list);
 
             // Push the results back to the processed queue, based on tracking results.
             for (size_t l = 0; l < results_list.size(); ++l) {
@@ -128,6 +139,156 @@ void ObjectDetectorSession::run() {
     qInfo() << "Stopping" << objectName() << "thread";
 }
 
+QSharedPointer<ObjectDetector> ObjectDetectorSession::createDetector(const PredictorConfig &config)
+{
+    std::unordered_map<std::string, std::string> ov_options;
+    ov_options["device_type"] = "GPU";
+    ov_options["precision"] = "ACCURACY";
+    ov_options["num_of_threads"] = "1";
+    ov_options["disable_dynamic_shapes"] = "false";
+
+    std::shared_ptr<Ort::SessionOptions> session_options = std::make_shared<Ort::SessionOptions>();
+    session_options->DisablePerSessionThreads();
+    session_options->AppendExecutionProvider_OpenVINO_V2(ov_options);
+
+    std::unique_ptr<ONNXInference> infer = std::make_unique<ONNXInference>(config, m_env, session_options, nullptr, nullptr);
+    return QSharedPointer<ObjectDetector>(new ObjectDetector(config, std::move(infer)));
+}
+
+bool ObjectDetectorSession::isUncertain(const Prediction &prediction) const
+{
+    const CascadeConfig &cascade = m_config.cascade.value();
+    if (m_escalationClasses.contains(prediction.className))
+        return true;
+
+    return prediction.conf >= cascade.min_confidence.value_or(DET_MIN_CONF)
+           && prediction.conf < cascade.max_confidence.value_or(1.0f);
+}
+
+void ObjectDetectorSession::escalate(const MatList &batch,
+                                     const SharedFrameList &frames,
+                                     std::vector<PredictionList> &resultsList)
+{
+    const CascadeConfig &cascade = m_config.cascade.value();
+    const bool crops_mode = cascade.mode.value_or(CascadeModeEnum::Frame) == CascadeModeEnum::Crops;
+    const float padding = cascade.crop_padding.value_or(0.25f);
+
+    // Images to run through the larger model and where they came from, <batch index, region in that frame>
+    MatList escalated_images;
+    std::vector<std::pair<size_t, cv::Rect>> escalated_regions;
+
+    for (size_t i = 0; i < resultsList.size() && i < batch.size(); ++i) {
+        PredictionList &results = resultsList[i];
+        const cv::Rect frame_rect(0, 0, batch[i].cols, batch[i].rows);
+        bool escalated = false;
+
+        for (auto it = results.begin(); it != results.end();) {
+            if (!isUncertain(*it)) {
+                ++it;
+                continue;
+            }
+
+            escalated = true;
+            if (!crops_mode)
+                break;
+
+            // ROI views, the larger model letterboxes from the parent frame.
+            const cv::Rect &box = it->box;
+            const int pad_x = static_cast<int>(box.width * padding);
+            const int pad_y = static_cast<int>(box.height * padding);
+            const cv::Rect roi = cv::Rect(box.x - pad_x, box.y - pad_y,
+                                          box.width + 2 * pad_x, box.height + 2 * pad_y) & frame_rect;
+            if (!roi.empty()) {
+                escalated_images.emplace_back(batch[i](roi));
+                escalated_regions.emplace_back(i, roi);
+            }
+
+            // The larger model's verdict replaces the uncertain one.
+            it = results.erase(it);
+        }
+
+        if (escalated && !crops_mode) {
+            escalated_images.emplace_back(batch[i]);
+            escalated_regions.emplace_back(i, frame_rect);
+        }
+
+        if (i < frames.size() && frames[i])
+            updateEscalationRate(frames[i]->camera(), escalated);
+    }
+
+    if (escalated_images.empty())
+        return;
+
+    std::vector<PredictionList> escalated_results;
+    escalated_results.reserve(escalated_images.size());
+    for (size_t offset = 0; offset < escalated_images.size(); offset += m_maxEscalationBatchSize) {
+        const size_t end = std::min(escalated_images.size(), offset + m_maxEscalationBatchSize);
+        MatList chunk(escalated_images.begin() + offset, escalated_images.begin() + end);
+
+        std::vector<PredictionList> chunk_results = m_escalationDetector->predict(chunk);
+        std::move(chunk_results.begin(), chunk_results.end(), std::back_inserter(escalated_results));
+    }
+
+    if (!crops_mode) {
+        for (size_t r = 0; r < escalated_results.size() && r < escalated_regions.size(); ++r)
+            resultsList[escalated_regions[r].first] = std::move(escalated_results[r]);
+        return;
+    }
+
+    // Crops may overlap each other and the confident detections we kept, so merge them through NMS.
+    std::vector<PredictionList> candidates(resultsList.size());
+    for (size_t r = 0; r < escalated_results.size() && r < escalated_regions.size(); ++r) {
+        const auto &[indx, roi] = escalated_regions[r];
+        for (Prediction &prediction : escalated_results[r]) {
+            prediction.box += roi.tl();
+            for (auto &point : prediction.points) {
+                point.x += roi.x;
+                point.y += roi.y;
+            }
+            candidates[indx].emplace_back(std::move(prediction));
+        }
+    }
+
+    for (size_t i = 0; i < resultsList.size(); ++i) {
+        if (candidates[i].empty())
+            continue;
+
+        PredictionList &results = resultsList[i];
+        const size_t kept = results.size();
+        std::move(candidates[i].begin(), candidates[i].end(), std::back_inserter(results));
+
+        std::vector<cv::Rect> boxes;
+        std::vector<float> confs;
+        boxes.reserve(results.size());
+        confs.reserve(results.size());
+        for (size_t p = 0; p < results.size(); ++p) {
+            boxes.emplace_back(results[p].box);
+            // Prefer the detections we already trusted
+            confs.emplace_back(p < kept ? results[p].conf + 1.0f : results[p].conf);
+        }
+
+        std::vector<int> indices;
+        Utils::NMSBoxes(boxes, confs, DET_MIN_CONF, DET_MIN_IOU_THRESH, indices);
+
+        PredictionList merged;
+        merged.reserve(indices.size());
+        for (int indx : indices)
+            merged.emplace_back(std::move(results[indx]));
+        results = std::move(merged);
+    }
+}
+
+void ObjectDetectorSession::updateEscalationRate(const QString &camera, bool escalated)
+{
+    // Exponential moving average over the frames seen from this camera
+    constexpr double alpha = 0.05;
+    double &rate = m_escalationRates[camera];
+    rate = (1.0 - alpha) * rate + alpha * (escalated ? 1.0 : 0.0);
+
+    if (m_cameraMetrics.contains(camera))
+        m_cameraMetrics.value(camera)->setEscalationRate(rate);
+}
+
 #include "moc_objectdetectorsession.cpp"
 
 // void ObjectDetectorSession::runOld() {
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <memory>
+#include <optional>
+#include <set>
 
 #include <QObject>
 #include <QThread>
 
 #include <tbb_patched.h>
 
+#include <camera/camerametrics.h>
 #include <config/detectorconfig.h>
 #include <config/predictorconfig.h>
 #include <detectors/objectdetector.h>
@@ -20,7 +23,9 @@ public:
     explicit ObjectDetectorSession(const QString &name,
                                    SharedFrameBoundedQueue &inFrameQueue,
                                    QHash<QString, QSharedPointer<QWaitCondition>> &cameraWaitConditions,
+                                   QHash<QString, SharedCameraMetrics> &cameraMetrics,
                                    const PredictorConfig &config,
+                                   std::optional<PredictorConfig> escalationConfig = std::nullopt,
                                    std::shared_ptr<Ort::Env> env = nullptr,
                                    QObject *parent = nullptr);
     QSharedPointer<ObjectDetector> detector();
@@ -32,6 +37,14 @@ protected:
     // QThread interface
     void run() override;
 
+private:
+    QSharedPointer<ObjectDetector> createDetector(const PredictorConfig &config);
+    bool isUncertain(const Prediction &prediction) const;
+    // Re-runs the larger model over the frames/crops holding uncertain detections and
+    // merges its results back into resultsList.
+    void escalate(const MatList &batch, const SharedFrameList &frames, std::vector<PredictionList> &resultsList);
+    void updateEscalationRate(const QString &camera, bool escalated);
+
 private:
     std::shared_ptr<Ort::Env> m_env;
 
@@ -39,11 +52,19 @@ private:
     QString m_name;
     QSharedPointer<ObjectDetector> m_detector;
     QHash<QString, QSharedPointer<QWaitCondition>> &m_cameraWaitConditions;
+    QHash<QString, SharedCameraMetrics> &m_cameraMetrics;
     SharedFrameBoundedQueue &m_inFrameQueue;
     std::atomic_int m_avgInferenceSpeed;
     PredictorConfig m_config;
     EventsPerSecond m_eps;
     int m_maxBatchSize = 1;
+
+    // Cascade
+    std::optional<PredictorConfig> m_escalationConfig;
+    QSharedPointer<ObjectDetector> m_escalationDetector;
+    std::set<std::string> m_escalationClasses;
+    QHash<QString, double> m_escalationRates;     // Per camera, moving average of the frames escalated
+    int m_maxEscalationBatchSize = 1;
 };
 
 using SharedObjectDetectorSession = QSharedPointer<ObjectDetectorSession>;
@@ -131,7 +131,7 @@ ONNXInference::ONNXInference(const PredictorConfig &config,
     }
 }
 
-std::vector<Ort::Value> ONNXInference::predictRaw(std::vector<float> data,
+std::vector<Ort::Value> ONNXInference::predictRaw(std::vector<float> &data,
                                                   std::vector<int64_t> customInputTensorShape)
 {
     if (customInputTensorShape.empty())
@@ -17,7 +17,7 @@ public:
                   const std::shared_ptr<CustomAllocator> &allocator,
                   const std::shared_ptr<Ort::MemoryInfo> &memoryInfo);
 
-    std::vector<Ort::Value> predictRaw(std::vector<float> data,
+    std::vector<Ort::Value> predictRaw(std::vector<float> &data,
                                        std::vector<int64_t> customInputTensorShape = {});
     void printModelMetadata() const;
     void printSessionMetadata() const;
@@ -82,18 +82,15 @@ std::vector<PredictionList> Predictor::predict(const MatList &images)
     }
     cv::Size input_image_shape(input_tensor_shape[3], input_tensor_shape[2]);
 
-    // Pre-Process each image
-    std::vector<float> img_data(Utils::vectorProduct(input_tensor_shape));
-    MatList preprocessed_images;
-    preprocessed_images.reserve(images.size());
-
-    for (int64_t i = 0; i < input_tensor_shape[0]; ++i) {
-        float *offset_ptr = img_data.data() + i * (3 * input_image_shape.area());
-        cv::Mat preprocessed_image = preprocess(images[i], offset_ptr, input_image_shape);
-        preprocessed_images.emplace_back(preprocessed_image);
+    // Pre-Process each image, straight into the (reused) input tensor buffer
+    m_inputBuffer.resize(Utils::vectorProduct(input_tensor_shape));
+    const int64_t num_images = std::min<int64_t>(input_tensor_shape[0], images.size());
+    for (int64_t i = 0; i < num_images; ++i) {
+        float *offset_ptr = m_inputBuffer.data() + i * (3 * input_image_shape.area());
+        preprocess(images[i], offset_ptr, input_image_shape);
     }
 
-    std::vector<Ort::Value> output_tensors = m_inferSession->predictRaw(img_data, input_tensor_shape);
+    std::vector<Ort::Value> output_tensors = m_inferSession->predictRaw(m_inputBuffer, input_tensor_shape);
     std::vector<PredictionList> predictions = postprocess(images, input_image_shape, output_tensors);
 
     return predictions; // Return the vector of detections
@@ -132,21 +129,9 @@ ONNXInference *Predictor::inferSession() const
 
 cv::Mat Predictor::preprocess(const cv::Mat &image, float *&imgData, cv::Size inputImageShape)
 {
-    cv::Mat resizedImage;
-    // Resize and pad the image using letterBox utility
-    Utils::letterBox(image, resizedImage, inputImageShape);
-
-    // Convert image to float and normalize to [0, 1]
-    resizedImage.convertTo(resizedImage, CV_32FC3, 1 / 255.0f);
-
-    // Split the image into separate channels and store in the blob
-    MatList chw(resizedImage.channels());
-    for (int i = 0; i < resizedImage.channels(); ++i) {
-        chw[i] = cv::Mat(resizedImage.rows, resizedImage.cols, CV_32FC1, imgData + i * resizedImage.cols * resizedImage.rows);
-    }
-    cv::split(resizedImage, chw); // Split channels into the blob
-
-    return resizedImage;
+    // Letterbox and normalize to [0, 1] directly into the CHW blob. Works with ROI views as well.
+    Utils::letterBoxToTensor(image, imgData, inputImageShape, m_letterBoxCanvas, m_letterBoxPlanes);
+    return m_letterBoxCanvas;
 }
 
 int Predictor::height() const
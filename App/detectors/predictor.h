@@ -38,6 +38,11 @@ private:
     int m_width = 640;
     int m_height = 640;
 
+    // Reused across calls, guarded by m_mtx
+    std::vector<float> m_inputBuffer;
+    cv::Mat m_letterBoxCanvas;
+    MatList m_letterBoxPlanes;
+
     mutable std::mutex m_mtx;
 };
 
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <cmath>
+
+#include <QDebug>
+
+#include <opencv2/imgproc.hpp>
+
+#include "reidembedder.h"
+
+namespace {
+
+const cv::Scalar IMAGENET_MEAN(0.485, 0.456, 0.406);
+const cv::Scalar IMAGENET_STD(0.229, 0.224, 0.225);
+
+}
+
+ReIdEmbedder::ReIdEmbedder(const PredictorConfig &config,
+                           std::unique_ptr<ONNXInference> infer)
+    : m_inferSession(std::move(infer))
+{
+    if (config.model) {
+        m_width = config.model->width.value_or(m_width);
+        m_height = config.model->height.value_or(m_height);
+    }
+
+    // The model knows better, if it has a fixed input
+    const auto input_shapes = m_inferSession->inputTensorShapes();
+    if (!input_shapes.empty() && input_shapes[0].size() == 4) {
+        const auto &shape = input_shapes[0];
+        m_hasDynamicBatch = shape[0] == -1;
+        if (shape[2] > 0)
+            m_height = static_cast<int>(shape[2]);
+        if (shape[3] > 0)
+            m_width = static_cast<int>(shape[3]);
+    }
+
+    const auto output_shapes = m_inferSession->outputTensorShapes();
+    if (!output_shapes.empty() && output_shapes[0].size() == 2 && output_shapes[0][1] > 0)
+        m_dims = static_cast<int>(output_shapes[0][1]);
+}
+
+std::vector<std::vector<float>> ReIdEmbedder::embed(const MatList &crops)
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    std::vector<std::vector<float>> embeddings;
+    embeddings.reserve(crops.size());
+
+    const size_t plane = static_cast<size_t>(m_width) * m_height;
+    const size_t chunk_size = m_hasDynamicBatch ? crops.size() : 1;
+
+    for (size_t offset = 0; offset < crops.size(); offset += chunk_size) {
+        const size_t n = std::min(chunk_size, crops.size() - offset);
+        m_inputBuffer.resize(n * 3 * plane);
+        for (size_t i = 0; i < n; ++i)
+            preprocess(crops[offset + i], m_inputBuffer.data() + i * 3 * plane);
+
+        const std::vector<Ort::Value> outputs = m_inferSession->predictRaw(m_inputBuffer, { static_cast<int64_t>(n), 3, m_height, m_width });
+        if (outputs.empty()) {
+            embeddings.resize(offset + n);
+            continue;
+        }
+
+        const std::vector<int64_t> shape = outputs[0].GetTensorTypeAndShapeInfo().GetShape();
+        const int dims = shape.size() == 2 ? static_cast<int>(shape[1]) : 0;
+        if (dims <= 0) {
+            qWarning() << "Unexpected re-ID output shape, expected [N, D].";
+            embeddings.resize(offset + n);
+            continue;
+        }
+
+        m_dims = dims;
+        const float *data = outputs[0].GetTensorData<float>();
+        for (size_t i = 0; i < n; ++i) {
+            std::vector<float> embedding(data + i * dims, data + (i + 1) * dims);
+
+            float norm = 0.0f;
+            for (float v : embedding)
+                norm += v * v;
+            norm = std::sqrt(norm);
+            if (norm > 0.0f) {
+                for (float &v : embedding)
+                    v /= norm;
+            }
+
+            embeddings.emplace_back(std::move(embedding));
+        }
+    }
+
+    return embeddings;
+}
+
+int ReIdEmbedder::width() const
+{
+    return m_width;
+}
+
+int ReIdEmbedder::height() const
+{
+    return m_height;
+}
+
+int ReIdEmbedder::dims() const
+{
+    return m_dims;
+}
+
+void ReIdEmbedder::preprocess(const cv::Mat &crop, float *data)
+{
+    // Straight into the CHW planes of the input buffer, no intermediate copies
+    cv::resize(crop, m_resized, cv::Size(m_width, m_height), 0, 0, cv::INTER_LINEAR);
+    cv::cvtColor(m_resized, m_resized, cv::COLOR_BGR2RGB);
+    m_resized.convertTo(m_normalized, CV_32FC3, 1.0 / 255.0);
+    cv::subtract(m_normalized, IMAGENET_MEAN, m_normalized);
+    cv::divide(m_normalized, IMAGENET_STD, m_normalized);
+
+    const size_t plane = static_cast<size_t>(m_width) * m_height;
+    m_planes.resize(3);
+    for (int c = 0; c < 3; ++c)
+        m_planes[c] = cv::Mat(m_height, m_width, CV_32FC1, data + c * plane);
+
+    cv::split(m_normalized, m_planes);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+#include <apss.h>
+#include <config/predictorconfig.h>
+#include <detectors/onnxinference.h>
+
+/**
+ * @brief Appearance embeddings of object crops, for re-identification across cameras.
+ *
+ * Expects the usual re-ID layout, a [N, 3, H, W] RGB input normalized with the ImageNet
+ * mean/std and a [N, D] output. Embeddings come out L2-normalized.
+ */
+class ReIdEmbedder
+{
+public:
+    explicit ReIdEmbedder(const PredictorConfig &config,
+                          std::unique_ptr<ONNXInference> infer);
+    std::vector<std::vector<float>> embed(const MatList &crops);
+    int width() const;
+    int height() const;
+    int dims() const;
+
+private:
+    void preprocess(const cv::Mat &crop, float *data);
+
+private:
+    std::unique_ptr<ONNXInference> m_inferSession;
+    int m_width = 128;
+    int m_height = 256;
+    int m_dims = 0;
+    bool m_hasDynamicBatch = false;
+
+    // Reused across calls, guarded by m_mtx
+    std::vector<float> m_inputBuffer;
+    cv::Mat m_resized;
+    cv::Mat m_normalized;
+    MatList m_planes;
+
+    std::mutex m_mtx;
+};
@@ -1,7 +1,11 @@
+#include <algorithm>
 #include <filesystem>
 #include <memory>
+#include <set>
 
 #include <QDir>
+#include <QGuiApplication>
+#include <QScreen>
 #include <QVideoSink>
 #include <QLoggingCategory>
 #include <QSqlDatabase>
@@ -32,7 +36,9 @@ Q_STATIC_LOGGING_CATEGORY(logger, "apss.engine")
 APSSEngine::APSSEngine(APSSConfig *config, QObject *parent)
     : QObject{parent}
     , m_config(config)
-{}
+{
+    m_clipExports.setMaxThreadCount(1);
+}
 
 APSSEngine::~APSSEngine()
 {}
@@ -42,19 +48,29 @@ SharedCameraMetricsModel APSSEngine::cameraMetricsModel() const
     return m_cameraMetricsModel;
 }
 
+EngineMetrics *APSSEngine::engineMetrics()
+{
+    return &m_engineMetrics;
+}
+
 void APSSEngine::start()
 {
     qCInfo(logger) << "Starting APSSEngine";
 
+    if (const QScreen *screen = QGuiApplication::primaryScreen())
+        m_livePreview.setMaxFps(screen->refreshRate());
+
     m_intraZMQProxy = new ZMQProxyThread(this);
 
     ensureDirs();
     initCameraMetrics();
     initQueues();
     initDatabase();
+    startStorageMaintainer();
+    startEventWriter();
     initRecordingManager();
     startDetectors();
-    // initEmbeddingsManager();
+    initEmbeddingsManager();
     // bindDatabase();
     // initEmbeddingsClient();
     // initIntraProcessComunicator();
@@ -62,7 +78,6 @@ void APSSEngine::start()
     startDetectedFramesProcessor();
     startCameraProcessors();
     startCameraCaptureProcesses();
-    // startStorageMaintainer();
     // startEventProcessor();
     // startCleanupProcesses();
     // startAPSSWatchdog();
@@ -141,39 +156,45 @@ void APSSEngine::stop()
             }
         }
 
-        // Stop License Plate Recognizer
-        auto [lpr_worker, lpr_thread] = m_lprWorkerThread;
-        if (lpr_thread && lpr_worker) {
-            lpr_thread->quit();
-            if (lpr_thread->wait(1000)) {
-                qCWarning(logger) << "Gracefull termination timed-out for" << lpr_thread->objectName() << "thread, forcing termination";
-                lpr_thread->terminate();
-                lpr_thread->wait();
+        // Stop License Plate Recognizers
+        m_lprRequestQueue.abort();
+        for (const auto &lpr_session : std::as_const(m_lprSessions))
+            lpr_session->stop();
+
+        for (int i = 0; i < m_trackedObjectsProcessors.size(); ++i) {
+            const auto &processor = m_trackedObjectsProcessors[i];
+            processor->requestInterruption();
+            m_trackedFramesQueues[i]->abort();
+            if (!processor->wait(500)) {
+                qCWarning(logger) << "Gracefull termination timed-out for tracked object processor thread"
+                                  << processor->objectName() << ", forcing termination";
+                processor->terminate();
+                processor->wait();
             }
         }
 
-        m_trackedObjectsProcessor->requestInterruption();
-        m_trackedFramesQueue.abort();
-        if (m_trackedObjectsProcessor->wait(500)) {
-            qCWarning(logger) << "Gracefull termination timed-out for tracked object processor thread"
-                              << m_trackedObjectsProcessor->objectName() << ", forcing termination";
-            m_trackedObjectsProcessor->terminate();
-            m_trackedObjectsProcessor->wait();
-        }
+        // Flush the events the processors just finalized, and their thumbnails
+        m_eventWriter->stop();
+        m_imageWriter->stop();
 
-        auto [manager, thread] = m_recordingsManager;
-        // Queued call into the worker’s thread
-        QMetaObject::invokeMethod(manager, "stop",
-                                  Qt::QueuedConnection);
-        // manager->stop();
-        thread->quit();
-        if (thread->wait(1000)) {
-            qCWarning(logger) << "Gracefull termination timed-out for recording manager thread"
-                              << thread->objectName() << ", forcing termination";
-            thread->terminate();
-            thread->wait();
+        // Stop the embeddings manager after the processors, so the last events still get queued
+        if (m_embeddingsManager) {
+            m_embeddingRequestQueue.abort();
+            m_embeddingsManager->stop();
         }
 
+        // Exports cut from segments the manager is about to close
+        m_clipExports.clear();
+        m_clipExports.waitForDone();
+
+        // Closes the open segments. The captures are stopped, nothing is coming after it.
+        if (m_recordingsManager)
+            m_recordingsManager->stop();
+
+        // After the recordings, so their last segments are indexed
+        if (m_storageMaintainer)
+            m_storageMaintainer->stop();
+
         m_intraZMQProxy->stop();
     }
     catch (const std::exception &e) {
@@ -192,21 +213,23 @@ void APSSEngine::onFrameChanged(SharedFrame frame)
         return;
     }
 
-    // Forward the output for that camera
+    // Forward the output for that camera. Hidden tiles get nothing, visible ones no faster than the display refreshes.
+    const SharedCameraMetrics &metrics = m_cameraMetrics[camera_name];
+    QVideoSink *output_sink = metrics->videoSink();
+    if (!output_sink || !metrics->previewVisible() || !m_livePreview.isDue(camera_name))
+        return;
+
     cv::Mat mat = frame->data();
     if (mat.type() != CV_8UC3 || mat.empty())
         return;
 
-    cv::Mat rgb = mat;
-    // cv::cvtColor(mat, rgb, cv::COLOR_BGR2RGB);
-    QImage img(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_BGR888);
-    QVideoFrame videoframe(img);
-
-    QVideoSink *output_sink = m_cameraMetrics[camera_name]->videoSink();
-    if (!output_sink)
+    // At the size it's shown at, in a format the scene graph uploads as is
+    const QVideoFrame videoframe = LivePreview::toVideoFrame(mat, metrics->previewSize());
+    if (!videoframe.isValid())
         return;
 
     output_sink->setVideoFrame(videoframe);
+    metrics->overlayModel()->setPredictions(frame->predictions(), mat.size());
 }
 
 void APSSEngine::ensureDirs()
@@ -216,6 +239,7 @@ void APSSEngine::ensureDirs()
         RECORD_DIR,
         THUMB_DIR,
         CLIPS_CACHE_DIR,
+        PREVIEW_DIR,
         CACHE_DIR,
         MODEL_CACHE_DIR,
         EXPORT_DIR
@@ -245,7 +269,32 @@ void APSSEngine::initQueues()
     // TODO: Change this to 2 * number_of_cameras enabled
     m_inUnifiedObjDetectorQ.set_capacity(4);
     m_inUnifiedLPDetectorQ.set_capacity(10);
-    m_trackedFramesQueue.set_capacity(20);
+    m_lprRequestQueue.setCapacity(64);
+    m_embeddingRequestQueue.set_capacity(64);
+
+    // Cameras are dealt to the tracking shards in order, so each camera's tracks live in a single thread
+    const int shards = trackedObjectShards();
+    for (int i = 0; i < shards; ++i) {
+        QSharedPointer<SharedFrameBoundedQueue> queue(new SharedFrameBoundedQueue());
+        queue->set_capacity(20);
+        m_trackedFramesQueues.append(queue);
+    }
+
+    int camera_indx = 0;
+    for (const auto &[name, config] : m_config->cameras) {
+        if (config.enabled)
+            m_cameraShards[QString::fromStdString(name)] = camera_indx++ % shards;
+    }
+}
+
+int APSSEngine::trackedObjectShards() const
+{
+    int cameras = 0;
+    for (const auto &[name, config] : m_config->cameras)
+        cameras += config.enabled ? 1 : 0;
+
+    const int shards = m_config->object_processors.value_or(QThread::idealThreadCount() / 4);
+    return std::clamp(shards, 1, std::max(1, cameras));
 }
 
 void APSSEngine::initDatabase()
@@ -280,6 +329,9 @@ void APSSEngine::initDatabase()
             t.commit();
         }
 
+        EventWriter::createSchema(*m_db);
+        StorageMaintainer::createSchema(*m_db);
+
     } catch (const odb::exception& e) {
         qCCritical(logger) << e.what();
     } catch(...) {
@@ -297,17 +349,26 @@ void APSSEngine::writeDbPragmas(QSqlQuery &query, const std::string &pragmaName,
     }
 }
 
-void APSSEngine::initRecordingManager()
+void APSSEngine::startStorageMaintainer()
 {
-    auto *thread = new QThread(this);
-    auto *worker = new RecordingsManager(*m_config, m_db, m_cameraMetrics);
+    m_storageMaintainer = QSharedPointer<StorageMaintainer>::create(m_db, *m_config);
+    // Housekeeping, it never gets in the way of the recordings
+    m_storageMaintainer->start(QThread::LowestPriority);
+}
 
-    connect(thread, &QThread::started, worker, &RecordingsManager::init);
-    connect(worker, &RecordingsManager::destroyed, thread, &QThread::quit);
-    connect(thread, &QThread::finished, thread, &QThread::deleteLater);
+void APSSEngine::startEventWriter()
+{
+    // The only writer of events, the tracked object processors and the recognizers go through it
+    m_eventWriter = QSharedPointer<EventWriter>::create(m_db, m_config->database.value_or(DatabaseConfig()));
+    m_eventWriter->start();
+}
 
-    m_recordingsManager = { worker, thread };
-    // thread->start();
+void APSSEngine::initRecordingManager()
+{
+    // No thread of its own, the packets go from the capture threads straight to its muxers
+    m_recordingsManager = QSharedPointer<RecordingsManager>::create(*m_config, m_db, m_cameraMetrics, m_storageMaintainer);
+    connect(m_storageMaintainer.get(), &StorageMaintainer::filesDeleted, m_recordingsManager.get(), &RecordingsManager::forgetFiles);
+    m_recordingsManager->init();
 }
 
 // void APSSEngine::bindDatabase()
@@ -324,13 +385,36 @@ void APSSEngine::startDetectors()
     for (const auto&[name, config] : m_config->cameras)
         m_cameraWaitConditions.emplace(QString::fromStdString(name), new QWaitCondition());
 
+    // Predictors that are the second tier of a cascade only run inside the session escalating to them.
+    std::set<std::string> escalation_targets;
+    for (const auto &[name, detector_config] : m_config->predictors) {
+        // Escalating to itself is a misconfiguration, it still runs, without the cascade
+        if (detector_config.cascade && detector_config.cascade->escalate_to != name)
+            escalation_targets.insert(detector_config.cascade->escalate_to);
+    }
+
     // Determine how make the data flow. Because frigate communicates frames through Shared Memory and between processes. How do we do it?
     for (const auto &[name, detector_config] : m_config->predictors) {
+        if (escalation_targets.contains(name))
+            continue;
+
+        std::optional<PredictorConfig> escalation_config;
+        if (detector_config.cascade) {
+            const std::string &target = detector_config.cascade->escalate_to;
+            if (target == name || !m_config->predictors.contains(target)) {
+                qCCritical(logger) << "Predictor" << name << "escalates to an unknown predictor" << target << ", running without cascade";
+            } else {
+                escalation_config = m_config->predictors.at(target);
+            }
+        }
+
         QString _name = QString::fromStdString(name);
         m_detectors[_name] = QSharedPointer<QThread>(new ObjectDetectorSession(_name,
                                                                                m_inUnifiedObjDetectorQ,
                                                                                m_cameraWaitConditions,
-                                                                               detector_config));
+                                                                               m_cameraMetrics,
+                                                                               detector_config,
+                                                                               escalation_config));
         m_detectors[_name]->start();
         qCInfo(logger) << "Detector" << name << "has started:" << m_detectors[_name]->isRunning();
     }
@@ -339,7 +423,7 @@ void APSSEngine::startDetectors()
     PredictorConfig lpdetconfig;
     lpdetconfig.model = ModelConfig();
     lpdetconfig.model->path = "models/yolo11n-pose-1700_320.onnx";
-    lpdetconfig.batch_size = 1;
+    lpdetconfig.batch_size = 4;     // Vehicles are batched across queued frames and cameras
 
     int n = m_config->predictors.size() > 2 ? m_config->predictors.size() / 2 : 1;
     for (int i = 0; i < n; ++i) {
@@ -353,31 +437,139 @@ void APSSEngine::startDetectors()
 
     // License Plate Recognizer
     if (m_config->lpr && m_config->lpr->enabled) {
-        auto *lpr_thread = new QThread(this);
-        auto *lpr_worker = new LPRSessionWorker(m_globalOrtEnv, m_db, m_config->lpr.value());
-    
-        connect(lpr_thread, &QThread::started, lpr_worker, &LPRSessionWorker::init);
-        connect(lpr_worker, &LPRSessionWorker::destroyed, lpr_thread, &QThread::quit);
-        connect(lpr_thread, &QThread::finished, lpr_thread, &QThread::deleteLater);
-    
-        m_lprWorkerThread = {lpr_worker, lpr_thread};
-        lpr_thread->start();
-    } else {
-        m_lprWorkerThread = { nullptr, nullptr };
+        // The models are loaded once and shared by the whole pool
+        const LPRModels lpr_models = LPRSession::loadModels(m_globalOrtEnv);
+        const int workers = std::max(1, m_config->lpr->workers.value_or(2));
+        m_plateFusion.configure(m_config->lpr.value());
+        m_knownPlates.load(m_config->lpr.value());
+
+        const int recent_plate_ttl = m_config->lpr->recent_plate_ttl.value_or(0);
+        if (recent_plate_ttl > 0)
+            m_recentPlates = QSharedPointer<RecentPlateCache>::create(recent_plate_ttl * 1000);
+
+        for (int i = 0; i < workers; ++i) {
+            QSharedPointer<LPRSession> lpr_session(new LPRSession(QString("lpr_%1").arg(i),
+                                                                  m_lprRequestQueue,
+                                                                  m_plateFusion,
+                                                                  &m_knownPlates,
+                                                                  m_recentPlates.get(),
+                                                                  m_cameraMetrics,
+                                                                  lpr_models,
+                                                                  *m_eventWriter,
+                                                                  m_config->lpr.value()));
+            lpr_session->start();
+            m_lprSessions.append(lpr_session);
+        }
     }
 }
 
-void APSSEngine::startDetectedFramesProcessor()
+void APSSEngine::initEmbeddingsManager()
 {
-    QSharedPointer<TrackedObjectProcessor> processor(new TrackedObjectProcessor(m_trackedFramesQueue, m_db));
-    m_trackedObjectsProcessor = processor;
+    if (!m_config->reid || !m_config->reid->enabled)
+        return;
 
-    connect(m_trackedObjectsProcessor.get(), &TrackedObjectProcessor::frameChanged, this, &APSSEngine::onFrameChanged);
-    if (m_lprWorkerThread.first)
-        connect(processor.get(), &TrackedObjectProcessor::eventCompleted, m_lprWorkerThread.first, &LPRSessionWorker::process);
-    // connect(m_trackedObjectsProcessor.get(), &TrackedObjectProcessor::frameChangedWithEvents, m_recordingsManager.first, &RecordingsManager::onRecordFrame);
+    const ReIdConfig &config = m_config->reid.value();
+    if (!config.predictor || !config.predictor->model) {
+        qCCritical(logger) << "Re-ID is enabled without a model, running without it";
+        return;
+    }
 
-    m_trackedObjectsProcessor->start();
+    // Next to the database, the embeddings only make sense with its event ids. Loaded by the
+    // manager, once it knows the model's embedding size.
+    const QString index_path = "apss.reid";
+    m_reidIndex = std::make_shared<VectorIndex>();
+
+    m_embeddingsManager = QSharedPointer<EmbeddingsManager>(new EmbeddingsManager(m_embeddingRequestQueue,
+                                                                                 m_reidIndex,
+                                                                                 config,
+                                                                                 m_globalOrtEnv,
+                                                                                 index_path));
+    m_embeddingsManager->start();
+}
+
+QVariantList APSSEngine::findSimilarEvents(qulonglong eventId, int limit, bool otherCamerasOnly) const
+{
+    QVariantList similar;
+    if (!m_reidIndex || !m_reidIndex->contains(eventId) || limit <= 0)
+        return similar;
+
+    const std::vector<float> query = m_reidIndex->vector(eventId);
+    std::optional<uint32_t> exclude_group;
+    if (otherCamerasOnly)
+        exclude_group = m_reidIndex->group(eventId);
+
+    const int probes = m_config->reid->ivf_probes.value_or(8);
+    // One extra, the event finds itself unless its camera is excluded
+    const std::vector<VectorIndex::Hit> hits = m_reidIndex->search(query.data(), limit + 1, probes, exclude_group);
+    for (const auto &hit : hits) {
+        if (hit.id == eventId)
+            continue;
+
+        QVariantMap entry;
+        entry["id"] = QVariant::fromValue<qulonglong>(hit.id);
+        entry["score"] = hit.score;
+        similar.append(entry);
+        if (similar.size() >= limit)
+            break;
+    }
+
+    return similar;
+}
+
+void APSSEngine::exportEventClip(qulonglong eventId)
+{
+    if (!m_recordingsManager) {
+        emit eventClipExported(eventId, QString());
+        return;
+    }
+
+    // Stream copies every overlapping segment, a long event would freeze the UI
+    m_clipExports.start([this, eventId]() {
+        QString path;
+        try {
+            odb::transaction t(m_db->begin());
+            std::unique_ptr<APSS::ODB::Event> event(m_db->find<APSS::ODB::Event>(static_cast<size_t>(eventId)));
+            t.commit();
+
+            // Cut from the camera's continuous recording
+            if (event)
+                path = m_recordingsManager->exportClip(event->camera, event->startTime, event->endTime, QString::number(eventId));
+        } catch (const std::exception &e) {
+            qCWarning(logger) << "Failed exporting the clip of event" << eventId << e.what();
+        }
+
+        emit eventClipExported(eventId, path);
+    });
+}
+
+void APSSEngine::startDetectedFramesProcessor()
+{
+    const SnapshotsConfig snapshots_config = m_config->snapshots.value_or(SnapshotsConfig());
+    m_imageWriter = QSharedPointer<ImageWriter>::create(snapshots_config, &m_engineMetrics);
+    m_imageWriter->start();
+
+    // The best plates of live tracks are handed over to the recognizer in memory
+    for (int i = 0; i < m_trackedFramesQueues.size(); ++i) {
+        QSharedPointer<TrackedObjectProcessor> processor(new TrackedObjectProcessor(*m_trackedFramesQueues[i],
+                                                                                    *m_eventWriter,
+                                                                                    *m_config,
+                                                                                    *m_imageWriter,
+                                                                                    m_lprSessions.isEmpty() ? nullptr : &m_lprRequestQueue,
+                                                                                    m_lprSessions.isEmpty() ? nullptr : &m_plateFusion,
+                                                                                    m_embeddingsManager ? &m_embeddingRequestQueue : nullptr));
+        processor->setObjectName(QString("tracked_object_processor_%1").arg(i));
+
+        connect(processor.get(), &TrackedObjectProcessor::frameChanged, this, &APSSEngine::onFrameChanged);
+        connect(processor.get(), &TrackedObjectProcessor::eventPersisted, this, &APSSEngine::eventPersisted);
+        connect(processor.get(), &TrackedObjectProcessor::eventUpdated, this, &APSSEngine::eventUpdated);
+        connect(processor.get(), &TrackedObjectProcessor::eventCompleted, this, &APSSEngine::eventCompleted);
+        connect(processor.get(), &TrackedObjectProcessor::frameChangedWithEvents, this, &APSSEngine::frameChangedWithEvents);
+
+        processor->start();
+        m_trackedObjectsProcessors.append(processor);
+    }
+
+    qCInfo(logger) << "Tracking" << m_cameraShards.size() << "cameras on" << m_trackedObjectsProcessors.size() << "processors";
 }
 
 void APSSEngine::startCameraProcessors()
@@ -394,7 +586,7 @@ void APSSEngine::startCameraProcessors()
                                                                           m_inUnifiedObjDetectorQ,
                                                                           m_inUnifiedLPDetectorQ,
                                                                           m_cameraWaitConditions[cam_name],
-                                                                          m_trackedFramesQueue,
+                                                                          *m_trackedFramesQueues[m_cameraShards.value(cam_name)],
                                                                           m_cameraMetrics[cam_name]
                                                                           ));
         m_cameraMetrics[cam_name]->setThread(camera_thread);
@@ -422,8 +614,12 @@ void APSSEngine::startCameraCaptureProcesses()
         SharedCameraMetrics metrics = m_cameraMetrics[camera_name];
         const_cast<CameraConfig&>(config).name = name;
 
-        QSharedPointer<QThread> capture_thread (new CameraCapture(camera_name, metrics, config));
+        QSharedPointer<CameraCapture> capture_thread (new CameraCapture(camera_name, metrics, config));
         metrics->setCaptureThread(capture_thread);
+
+        // Every packet goes into the camera's continuous recording, once
+        if (m_recordingsManager)
+            m_recordingsManager->record(camera_name, capture_thread->packetDistributor());
         // TODO: Launch with a Higher Thread Priority
         capture_thread->start();
 
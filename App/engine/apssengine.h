@@ -3,6 +3,7 @@
 #include <memory>
 
 #include <QThread>
+#include <QThreadPool>
 #include <QHash>
 #include <QQmlEngine>
 #include <QSettings>
@@ -21,26 +22,52 @@
 #include <tbb_patched.h>
 #include <camera/camerametrics.h>
 #include <config/apssconfig.h>
+#include <detectors/embeddingsmanager.h>
+#include <engine/enginemetrics.h>
 #include <detectors/lprsession.h>
 #include <events/zmqproxy.h>
 #include <models/camerametricsmodel.h>
+#include <output/eventwriter.h>
+#include <output/imagewriter.h>
+#include <output/livepreview.h>
 #include <output/recordingsmanager.h>
+#include <output/storagemaintainer.h>
 #include <output/trackedobjectprocessor.h>
 #include <utils/frame.h>
+#include <utils/knownplates.h>
+#include <utils/recentplatecache.h>
+#include <utils/platefusion.h>
+#include <utils/vectorindex.h>
 
 // This class will handle most of the stuff
 class APSSEngine : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(SharedCameraMetricsModel cameraMetricsModel READ cameraMetricsModel FINAL)
+    Q_PROPERTY(EngineMetrics* engineMetrics READ engineMetrics CONSTANT FINAL)
 
 public:
     explicit APSSEngine(APSSConfig *config, QObject *parent = nullptr);
     ~APSSEngine();
     SharedCameraMetricsModel cameraMetricsModel() const;
-    QSharedPointer<TrackedObjectProcessor> trackedObjectProcessor() const {
-        return m_trackedObjectsProcessor;
+    EngineMetrics *engineMetrics();
+    QList<QSharedPointer<TrackedObjectProcessor>> trackedObjectProcessors() const {
+        return m_trackedObjectsProcessors;
     }
+    // Events that look like the given one, best first, as { id, score } maps. Empty if re-ID is disabled.
+    Q_INVOKABLE QVariantList findSimilarEvents(qulonglong eventId, int limit = 20, bool otherCamerasOnly = true) const;
+    // Cuts the event's clip from the recordings, with its pre/post capture, in the background.
+    // Its path comes with eventClipExported, empty if it wasn't recorded.
+    Q_INVOKABLE void exportEventClip(qulonglong eventId);
+
+signals:
+    // Merged from every TrackedObjectProcessor shard
+    void eventPersisted(size_t id);
+    void eventUpdated(size_t id, int updateType);
+    void eventCompleted(size_t id);
+    void frameChangedWithEvents(SharedFrame frame, const QList<int> &activeEvents);
+    // From a clip export thread
+    void eventClipExported(qulonglong eventId, const QString &path);
 
 public slots:
     void start();
@@ -51,12 +78,15 @@ private:
     void ensureDirs();
     void initCameraMetrics();
     void initQueues();
+    int trackedObjectShards() const;
     void initDatabase();
+    void startStorageMaintainer();
+    void startEventWriter();
     void writeDbPragmas(QSqlQuery &query, const std::string &pragmaName, const QString &expectedValue, const QString newValue);
     void initRecordingManager();
     // ...
     void startDetectors();
-    // void initEmbeddingsManager();
+    void initEmbeddingsManager();
     // void bindDatabase();
     // void initEmbeddingsClient();
     // void initIntraProcessComunicator();
@@ -64,7 +94,6 @@ private:
     void startDetectedFramesProcessor();
     void startCameraProcessors();
     void startCameraCaptureProcesses();
-    // void startStorageMaintainer();
     // void startEventProcessor();
     // void startCleanupProcesses();
     // void startAPSSWatchdog();
@@ -73,6 +102,7 @@ private:
     std::shared_ptr<Ort::Env> m_globalOrtEnv;
 
     QHash<QString, QVideoSink*> m_cameraOutputFeeds;
+    LivePreview m_livePreview;
     SharedFrameBoundedQueue m_inUnifiedObjDetectorQ;
     SharedFrameBoundedQueue m_inUnifiedLPDetectorQ;
     QHash<QString, QSharedPointer<QWaitCondition>> m_cameraWaitConditions;
@@ -82,16 +112,29 @@ private:
     std::atomic_bool m_stopEvent;
     QHash<QString, QSharedPointer<QThread>> m_detectors;
     QHash<QString, QSharedPointer<QThread>> m_lpdetectors;
-    QPair<LPRSessionWorker*, QThread*> m_lprWorkerThread;
+    LPRRequestQueue m_lprRequestQueue;
+    PlateFusionStore m_plateFusion;
+    KnownPlates m_knownPlates;
+    QSharedPointer<RecentPlateCache> m_recentPlates;
+    QList<QSharedPointer<LPRSession>> m_lprSessions;
+    EmbeddingRequestQueue m_embeddingRequestQueue;
+    std::shared_ptr<VectorIndex> m_reidIndex;
+    QSharedPointer<EmbeddingsManager> m_embeddingsManager;
     QHash<QString, SharedCameraMetrics> m_cameraMetrics;
     SharedCameraMetricsModel m_cameraMetricsModel;
+    EngineMetrics m_engineMetrics;
+    QSharedPointer<ImageWriter> m_imageWriter;
 
     ZMQProxyThread *m_intraZMQProxy;
     std::shared_ptr<odb::database> m_db;
     std::shared_ptr<odb::connection_factory> m_dbFactory;
-    SharedFrameBoundedQueue m_trackedFramesQueue;
-    QSharedPointer<TrackedObjectProcessor> m_trackedObjectsProcessor;
+    QList<QSharedPointer<SharedFrameBoundedQueue>> m_trackedFramesQueues;   // One per shard
+    QHash<QString, int> m_cameraShards;
+    QSharedPointer<EventWriter> m_eventWriter;
+    QList<QSharedPointer<TrackedObjectProcessor>> m_trackedObjectsProcessors;
     // QSharedPointer<VideoRecorder> m_recorder;
 
-    QPair<RecordingsManager*, QThread*> m_recordingsManager;
+    QSharedPointer<StorageMaintainer> m_storageMaintainer;
+    QSharedPointer<RecordingsManager> m_recordingsManager;
+    QThreadPool m_clipExports;     // One at a time, the cuts are disk bound
 };
@@ -0,0 +1,77 @@
+#include "enginemetrics.h"
+
+EngineMetrics::EngineMetrics(QObject *parent)
+    : QObject(parent)
+{}
+
+int EngineMetrics::imageWriterQueueDepth() const
+{
+    return m_imageWriterQueueDepth.load(std::memory_order_acquire);
+}
+
+double EngineMetrics::imageWriterLatency() const
+{
+    return m_imageWriterLatency.load(std::memory_order_acquire);
+}
+
+int EngineMetrics::imageWriterDropped() const
+{
+    return m_imageWriterDropped.load(std::memory_order_acquire);
+}
+
+void EngineMetrics::setImageWriterQueueDepth(int newImageWriterQueueDepth)
+{
+    int current = m_imageWriterQueueDepth.load(std::memory_order_relaxed);
+    if (current == newImageWriterQueueDepth)
+        return;
+
+    while (!m_imageWriterQueueDepth.compare_exchange_weak(
+        current, newImageWriterQueueDepth,
+        std::memory_order_release,
+        std::memory_order_relaxed
+        )) {
+
+        if (current == newImageWriterQueueDepth)
+            return;
+    }
+
+    Q_EMIT imageWriterQueueDepthChanged(newImageWriterQueueDepth);
+}
+
+void EngineMetrics::setImageWriterLatency(double newImageWriterLatency)
+{
+    double current = m_imageWriterLatency.load(std::memory_order_relaxed);
+    if (current == newImageWriterLatency)
+        return;
+
+    while (!m_imageWriterLatency.compare_exchange_weak(
+        current, newImageWriterLatency,
+        std::memory_order_release,
+        std::memory_order_relaxed
+        )) {
+
+        if (current == newImageWriterLatency)
+            return;
+    }
+
+    Q_EMIT imageWriterLatencyChanged(newImageWriterLatency);
+}
+
+void EngineMetrics::setImageWriterDropped(int newImageWriterDropped)
+{
+    int current = m_imageWriterDropped.load(std::memory_order_relaxed);
+    if (current == newImageWriterDropped)
+        return;
+
+    while (!m_imageWriterDropped.compare_exchange_weak(
+        current, newImageWriterDropped,
+        std::memory_order_release,
+        std::memory_order_relaxed
+        )) {
+
+        if (current == newImageWriterDropped)
+            return;
+    }
+
+    Q_EMIT imageWriterDroppedChanged(newImageWriterDropped);
+}
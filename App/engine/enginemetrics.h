@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+
+#include <QObject>
+
+/**
+ * @brief Metrics of the engine's shared, camera independent parts.
+ */
+class EngineMetrics : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int imageWriterQueueDepth READ imageWriterQueueDepth WRITE setImageWriterQueueDepth NOTIFY imageWriterQueueDepthChanged FINAL)
+    Q_PROPERTY(double imageWriterLatency READ imageWriterLatency WRITE setImageWriterLatency NOTIFY imageWriterLatencyChanged FINAL)
+    Q_PROPERTY(int imageWriterDropped READ imageWriterDropped WRITE setImageWriterDropped NOTIFY imageWriterDroppedChanged FINAL)
+
+public:
+    explicit EngineMetrics(QObject *parent = nullptr);
+
+    int imageWriterQueueDepth() const;
+    double imageWriterLatency() const;
+    int imageWriterDropped() const;
+
+public slots:
+    void setImageWriterQueueDepth(int newImageWriterQueueDepth);
+    void setImageWriterLatency(double newImageWriterLatency);
+    void setImageWriterDropped(int newImageWriterDropped);
+
+signals:
+    void imageWriterQueueDepthChanged(int);
+    void imageWriterLatencyChanged(double);
+    void imageWriterDroppedChanged(int);
+
+private:
+    std::atomic_int m_imageWriterQueueDepth = 0;
+    std::atomic<double> m_imageWriterLatency = 0.0;     // Milliseconds from queueing to written, averaged
+    std::atomic_int m_imageWriterDropped = 0;           // Images not written because the queue was full
+};
@@ -34,6 +34,16 @@ QVariant CameraMetricsModel::data(const QModelIndex &index, int role) const
         return static_cast<int>(m_cameraMetrics[key]->processFPS());
     case SkippedFPS:
         return static_cast<int>(m_cameraMetrics[key]->skippedFPS());
+    case EscalationRate:    // In percent
+        return qRound(m_cameraMetrics[key]->escalationRate() * 100.0);
+    case PlateCacheHitRate: // In percent
+        return qRound(m_cameraMetrics[key]->plateCacheHitRate() * 100.0);
+    case Overlay:
+        return QVariant::fromValue<QObject*>(m_cameraMetrics[key]->overlayModel());
+    case PreviewSize:
+        return m_cameraMetrics[key]->previewSize();
+    case PreviewVisible:
+        return m_cameraMetrics[key]->previewVisible();
     default:
         break;
     }
@@ -48,7 +58,7 @@ bool CameraMetricsModel::setData(const QModelIndex &index, const QVariant &value
         return false;
 
     switch (role) {
-    case VideoSink: {   // Only allow setting up VideoSink
+    case VideoSink: {
         SharedCameraMetrics metrics = m_cameraMetrics[m_cameraMetKeys[index.row()]];
         QVideoSink *sink = value.value<QVideoSink *>();
         Q_ASSERT(metrics);
@@ -56,6 +66,12 @@ bool CameraMetricsModel::setData(const QModelIndex &index, const QVariant &value
         metrics->setVideoSink(sink);
         break;
     }
+    case PreviewSize:   // The tile reports how big, and whether it's shown
+        m_cameraMetrics[m_cameraMetKeys[index.row()]]->setPreviewSize(value.toSize());
+        break;
+    case PreviewVisible:
+        m_cameraMetrics[m_cameraMetKeys[index.row()]]->setPreviewVisible(value.toBool());
+        break;
     default:
         return false;
     };
@@ -71,7 +87,12 @@ QHash<int, QByteArray> CameraMetricsModel::roleNames() const
         { CameraFPS, "camerafps" },
         { DetectionFPS, "detectionfps" },
         { ProcessFPS, "processfps" },
-        { SkippedFPS, "skippedfps" }
+        { SkippedFPS, "skippedfps" },
+        { EscalationRate, "escalationrate" },
+        { PlateCacheHitRate, "platecachehitrate" },
+        { Overlay, "overlay" },
+        { PreviewSize, "previewsize" },
+        { PreviewVisible, "previewvisible" }
     };
 
     return roles;
@@ -14,7 +14,12 @@ public:
         CameraFPS,
         DetectionFPS,
         ProcessFPS,
-        SkippedFPS
+        SkippedFPS,
+        EscalationRate,
+        PlateCacheHitRate,
+        Overlay,
+        PreviewSize,
+        PreviewVisible
     };
 
     explicit CameraMetricsModel(QHash<QString, SharedCameraMetrics> &cameraMetrics,
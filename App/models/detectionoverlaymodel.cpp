@@ -0,0 +1,103 @@
+#include <algorithm>
+
+#include "detectionoverlaymodel.h"
+
+DetectionOverlayModel::DetectionOverlayModel(QObject *parent)
+    : QAbstractListModel{parent}
+{}
+
+int DetectionOverlayModel::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+
+    return m_boxes.size();
+}
+
+QVariant DetectionOverlayModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_boxes.size())
+        return QVariant();
+
+    const Box &box = m_boxes[index.row()];
+
+    switch (role) {
+    case X:
+        return box.rect.x();
+    case Y:
+        return box.rect.y();
+    case Width:
+        return box.rect.width();
+    case Height:
+        return box.rect.height();
+    case Label:
+        return box.label;
+    case IsSubPrediction:
+        return box.isSubPrediction;
+    default:
+        break;
+    }
+
+    return QVariant();
+}
+
+QHash<int, QByteArray> DetectionOverlayModel::roleNames() const
+{
+    static QHash<int, QByteArray> roles = {
+        { X, "boxx" },
+        { Y, "boxy" },
+        { Width, "boxwidth" },
+        { Height, "boxheight" },
+        { Label, "label" },
+        { IsSubPrediction, "issubprediction" }
+    };
+
+    return roles;
+}
+
+void DetectionOverlayModel::setPredictions(const PredictionList &predictions, const cv::Size &frameSize)
+{
+    if (frameSize.empty())
+        return;
+
+    QList<Box> boxes;
+    boxes.reserve(predictions.size());
+    for (const auto &prediction : predictions) {
+        boxes.append(toBox(prediction, frameSize, false));
+        if (prediction.subPredictions) {
+            for (const auto &sub_prediction : prediction.subPredictions.value())
+                boxes.append(toBox(sub_prediction, frameSize, true));
+        }
+    }
+
+    // Reuse the rows both lists have, then grow or shrink
+    const qsizetype common = std::min(boxes.size(), m_boxes.size());
+    for (qsizetype i = 0; i < common; ++i)
+        m_boxes[i] = boxes[i];
+
+    if (common > 0)
+        emit dataChanged(index(0), index(common - 1));
+
+    if (boxes.size() > m_boxes.size()) {
+        beginInsertRows(QModelIndex(), m_boxes.size(), boxes.size() - 1);
+        m_boxes.append(boxes.mid(m_boxes.size()));
+        endInsertRows();
+    } else if (boxes.size() < m_boxes.size()) {
+        beginRemoveRows(QModelIndex(), boxes.size(), m_boxes.size() - 1);
+        m_boxes.resize(boxes.size());
+        endRemoveRows();
+    }
+}
+
+DetectionOverlayModel::Box DetectionOverlayModel::toBox(const Prediction &prediction, const cv::Size &frameSize, bool isSubPrediction)
+{
+    Box box;
+    box.rect = QRectF(static_cast<qreal>(prediction.box.x) / frameSize.width,
+                      static_cast<qreal>(prediction.box.y) / frameSize.height,
+                      static_cast<qreal>(prediction.box.width) / frameSize.width,
+                      static_cast<qreal>(prediction.box.height) / frameSize.height);
+    box.label = QString("%1 (%2%)").arg(prediction.trackerId).arg(static_cast<int>(prediction.conf * 100));
+    box.isSubPrediction = isSubPrediction;
+    return box;
+}
+
+#include "moc_detectionoverlaymodel.cpp"
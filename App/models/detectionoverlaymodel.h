@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QList>
+#include <QRectF>
+#include <QString>
+#include <opencv2/core/types.hpp>
+
+#include <utils/prediction.h>
+
+/**
+ * @brief The boxes of a camera's latest processed frame, drawn by LivePlaybackCard on top
+ * of the video, so nothing has to be drawn into the frame itself.
+ *
+ * Boxes are normalized to the frame, rows are updated in place so the delegates are reused.
+ */
+class DetectionOverlayModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum DetectionOverlayRole {
+        X = Qt::UserRole + 1,
+        Y,
+        Width,
+        Height,
+        Label,
+        IsSubPrediction
+    };
+
+    explicit DetectionOverlayModel(QObject *parent = nullptr);
+
+    // QAbstractItemModel interface
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    void setPredictions(const PredictionList &predictions, const cv::Size &frameSize);
+
+private:
+    struct Box {
+        QRectF rect;
+        QString label;
+        bool isSubPrediction = false;
+    };
+
+    static Box toBox(const Prediction &prediction, const cv::Size &frameSize, bool isSubPrediction);
+
+private:
+    QList<Box> m_boxes;
+};
@@ -4,7 +4,10 @@
 #include <QtSql/QSqlTableModel>
 #include <QtSql/QSqlDatabase>
 #include <QtSql/QSqlError>
+#include <QtSql/QSqlQuery>
 #include <QLoggingCategory>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QUrl>
 #include <cstddef>
 #include <cstdint>
@@ -14,6 +17,8 @@
 #include <qnamespace.h>
 #include <qtpreprocessorsupport.h>
 
+#include <utils/trackcodec.h>
+
 Q_STATIC_LOGGING_CATEGORY(logger, "apss.models.event")
 
 EventsModel::EventsModel(const QSqlDatabase &db, QObject *parent)
@@ -36,6 +41,8 @@ QVariant EventsModel::data(const QModelIndex &index, int role) const
         return QSqlTableModel::data(createIndex(index.row(), 0));
     case Label:     // 1
         return QSqlTableModel::data(createIndex(index.row(), 1));
+    case SubLabel:  // 2
+        return QSqlTableModel::data(createIndex(index.row(), 2));
     case Camera:    // 3
         return QSqlTableModel::data(createIndex(index.row(), 3));
     case StartTime: { // 4
@@ -72,14 +79,22 @@ QVariant EventsModel::data(const QModelIndex &index, int role) const
     case LicensePlatePath: {
         QString path = QSqlTableModel::data(createIndex(index.row(), 9)).toString();
         QFileInfo file(path);
-        QString file_name = QString("%1_lp.jpg").arg(file.baseName());
+        // Written next to the thumbnail, in the same format
+        QString file_name = QString("%1_lp.%2").arg(file.baseName(), file.suffix());
         path = file.dir().filePath(file_name);
         if (QFileInfo::exists(path))
             return QUrl::fromLocalFile(path);
         return QVariant();
     }
-    case LicensePlateText:
-        return QVariant();
+    case LicensePlateText: { // 11
+        // FusedPlate, as written by the LPR workers
+        const QByteArray results = QSqlTableModel::data(createIndex(index.row(), 11)).toByteArray();
+        if (results.isEmpty())
+            return QVariant();
+
+        const QString text = QJsonDocument::fromJson(results).object().value("text").toString();
+        return text.isEmpty() ? QVariant() : text;
+    }
     }
 
 return QVariant();
@@ -107,6 +122,44 @@ QHash<int, QByteArray> EventsModel::roleNames() const
     return roles;
 }
 
+QVariantList EventsModel::track(qulonglong eventId) const
+{
+    QVariantList samples;
+
+    QSqlQuery query(database());
+    query.prepare("SELECT \"data\" FROM \"TrackChunk\" WHERE \"eventId\" = ? ORDER BY \"seq\"");
+    query.addBindValue(eventId);
+    if (!query.exec()) {
+        qCWarning(logger) << "Failed reading the track of event" << eventId << query.lastError().text();
+        return samples;
+    }
+
+    while (query.next()) {
+        const QByteArray data = query.value(0).toByteArray();
+        const auto chunk = TrackCodec::decode(reinterpret_cast<const uint8_t *>(data.constData()), data.size());
+        if (!chunk) {
+            qCWarning(logger) << "Skipping a corrupt track chunk of event" << eventId;
+            continue;
+        }
+
+        for (const auto &sample : chunk.value()) {
+            const Prediction &p = sample.prediction;
+            samples.append(QVariantMap{
+                {"timestamp", QDateTime::fromMSecsSinceEpoch(sample.timestamp, Qt::UTC)},
+                {"x", p.box.x},
+                {"y", p.box.y},
+                {"width", p.box.width},
+                {"height", p.box.height},
+                {"conf", p.conf},
+                {"label", QString::fromStdString(p.className)},
+                {"trackerid", p.trackerId}
+            });
+        }
+    }
+
+    return samples;
+}
+
 QString EventsModel::formatRange(const QDateTime &startTime, const QDateTime &endTime) const
 {
     QDate sDate = startTime.date();
@@ -35,6 +35,8 @@ public:
     QHash<int, QByteArray> roleNames() const override;
 
     Q_INVOKABLE QString formatRange(const QDateTime &startTime, const QDateTime &endTime) const;
+    // Decoded track of the event, for replay. Samples of {timestamp, x, y, width, height, conf, label, trackerid}.
+    Q_INVOKABLE QVariantList track(qulonglong eventId) const;
 public slots:
     void newEvent(size_t id);
     void eventUpdated(size_t id, int updateType);
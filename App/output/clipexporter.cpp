@@ -0,0 +1,110 @@
+#include <QFileInfo>
+#include <QLoggingCategory>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+#include <output/remuxer.h>
+#include "clipexporter.h"
+
+Q_STATIC_LOGGING_CATEGORY(logger, "apss.output.clip_exporter")
+
+namespace {
+
+struct InputRAII {
+    AVFormatContext *ctx = nullptr;
+
+    ~InputRAII() {
+        if (ctx)
+            avformat_close_input(&ctx);
+    }
+};
+
+}
+
+bool ClipExporter::cut(const QList<RecordingSegment> &segments,
+                       const QDateTime &start,
+                       const QDateTime &end,
+                       const QString &outPath)
+{
+    if (segments.isEmpty() || start >= end)
+        return false;
+
+    QFileInfo(outPath).dir().mkpath(".");
+
+    Remuxer output;
+    AVRational out_tb = { 0, 1 };
+    const QDateTime origin = segments.front().startTime;
+    bool is_done = false;
+
+    for (const auto &segment : segments) {
+        if (is_done)
+            break;
+        if (segment.endTime < start || segment.startTime > end)
+            continue;
+
+        InputRAII input;
+        const std::string path = segment.path.toStdString();
+        if (avformat_open_input(&input.ctx, path.c_str(), nullptr, nullptr) < 0
+            || avformat_find_stream_info(input.ctx, nullptr) < 0) {
+            qCWarning(logger) << "Skipping unreadable segment" << segment.path;
+            continue;
+        }
+
+        const int stream_index = av_find_best_stream(input.ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (stream_index < 0)
+            continue;
+        const AVStream *stream = input.ctx->streams[stream_index];
+
+        if (!output.isOpen()) {
+            out_tb = stream->time_base;
+            if (!output.openOutput(outPath, stream->codecpar, out_tb) || !output.writeHeader()) {
+                qCWarning(logger) << "Failed to open clip" << outPath;
+                return false;
+            }
+        }
+
+        // Segments are rebased to their own start, place them on the clip's timeline
+        const int64_t offset = av_rescale_q(origin.msecsTo(segment.startTime), { 1, 1000 }, stream->time_base);
+
+        // Rewind the first segment to the keyframe before the clip
+        if (segment.startTime < start) {
+            const int64_t target = av_rescale_q(segment.startTime.msecsTo(start), { 1, 1000 }, stream->time_base);
+            av_seek_frame(input.ctx, stream_index, target, AVSEEK_FLAG_BACKWARD);
+        }
+
+        AVPacket *pkt = av_packet_alloc();
+        while (av_read_frame(input.ctx, pkt) >= 0) {
+            if (pkt->stream_index != stream_index) {
+                av_packet_unref(pkt);
+                continue;
+            }
+
+            const int64_t pts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+            const QDateTime time = segment.startTime.addMSecs(av_rescale_q(pts, stream->time_base, { 1, 1000 }));
+            if (time > end) {
+                is_done = true;
+                av_packet_unref(pkt);
+                break;
+            }
+
+            if (pkt->pts != AV_NOPTS_VALUE)
+                pkt->pts += offset;
+            if (pkt->dts != AV_NOPTS_VALUE)
+                pkt->dts += offset;
+
+            SharedPacket shared(av_packet_clone(pkt), [](AVPacket *p) { av_packet_free(&p); });
+            av_packet_unref(pkt);
+            if (shared)
+                output.writePacket(shared, stream->time_base);
+        }
+        av_packet_free(&pkt);
+    }
+
+    if (!output.isOpen())
+        return false;
+
+    output.close();
+    return true;
+}
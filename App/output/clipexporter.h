@@ -0,0 +1,23 @@
+#pragma once
+
+#include <QDateTime>
+#include <QList>
+#include <QString>
+
+#include <output/segmentwriter.h>
+
+/**
+ * @brief Cuts clips out of a camera's recording segments, on demand, without re-encoding.
+ *
+ * The clip starts at the last keyframe at or before the requested start, so it may begin up to
+ * a GOP early. Timestamps continue across segments.
+ */
+class ClipExporter
+{
+public:
+    // segments are of one camera, oldest first.
+    static bool cut(const QList<RecordingSegment> &segments,
+                    const QDateTime &start,
+                    const QDateTime &end,
+                    const QString &outPath);
+};
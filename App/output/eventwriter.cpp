@@ -0,0 +1,507 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QLoggingCategory>
+#include <QMutexLocker>
+
+#include <sqlite3.h>
+#include <odb/sqlite/connection.hxx>
+#include <odb/sqlite/traits.hxx>
+#include <odb/sqlite/transaction.hxx>
+#include <rfl/json/write.hpp>
+#include <rfl/json.hpp>
+
+#include <utils/trackcodec.h>
+#include "eventwriter.h"
+
+Q_STATIC_LOGGING_CATEGORY(logger, "apss.output.event_writer")
+
+namespace {
+
+// 6 bound columns a row, well under SQLite's default limit of host parameters
+constexpr size_t PREDICTIONS_PER_INSERT = 64;
+
+std::string insertPredictionsSql(size_t rows)
+{
+    std::string sql = "INSERT INTO \"Prediction\" (\"eventId\", \"frameId\", \"videoTimestamp\", \"streamTimestamp\", \"data\", \"hasSubPredictions\") VALUES ";
+    for (size_t i = 0; i < rows; ++i)
+        sql += i == 0 ? "(?, ?, ?, ?, ?, ?)" : ", (?, ?, ?, ?, ?, ?)";
+
+    return sql;
+}
+
+int64_t sampleTime(const APSS::ODB::Prediction &p)
+{
+    if (p.streamTimestamp.isValid())
+        return p.streamTimestamp.toMSecsSinceEpoch();
+
+    return p.videoTimestamp.isValid() ? p.videoTimestamp.toMSecsSinceEpoch() : 0;
+}
+
+void check(int rc, sqlite3 *handle)
+{
+    if (rc != SQLITE_OK && rc != SQLITE_DONE && rc != SQLITE_ROW)
+        throw std::runtime_error(sqlite3_errmsg(handle));
+}
+
+void bindText(sqlite3_stmt *stmt, int indx, const QString &text)
+{
+    if (text.isNull()) {
+        sqlite3_bind_null(stmt, indx);
+        return;
+    }
+
+    const QByteArray utf8 = text.toUtf8();
+    sqlite3_bind_text(stmt, indx, utf8.constData(), utf8.size(), SQLITE_TRANSIENT);
+}
+
+void bindDateTime(sqlite3_stmt *stmt, int indx, const QDateTime &time)
+{
+    // The same text ODB's Qt profile stores, so the rows read back through ODB
+    odb::details::buffer buffer;
+    std::size_t size = 0;
+    bool is_null = true;
+    odb::sqlite::value_traits<QDateTime, odb::sqlite::id_text>::set_image(buffer, size, is_null, time);
+
+    if (is_null)
+        sqlite3_bind_null(stmt, indx);
+    else
+        sqlite3_bind_text(stmt, indx, buffer.data(), static_cast<int>(size), SQLITE_TRANSIENT);
+}
+
+}
+
+bool EventWriter::Ticket::isValid() const
+{
+    return m_id.valid();
+}
+
+bool EventWriter::Ticket::isReady() const
+{
+    return m_id.valid() && m_id.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+size_t EventWriter::Ticket::id() const
+{
+    return m_id.get();
+}
+
+EventWriter::EventWriter(std::shared_ptr<odb::database> db,
+                         const DatabaseConfig &config,
+                         QObject *parent)
+    : QThread(parent)
+    , m_db(db)
+    , m_commitInterval(std::max(1, config.commit_interval.value_or(50)))
+    , m_commitRows(std::max(1, config.commit_rows.value_or(512)))
+    , m_trackChunkSize(std::max(1, config.track_chunk_size.value_or(256)))
+    , m_predictionRows(config.prediction_rows.value_or(false))
+{
+    setObjectName("event_writer");
+    m_queue.set_capacity(std::max(1, config.queue_size.value_or(1024)));
+}
+
+EventWriter::~EventWriter()
+{
+    stop();
+}
+
+void EventWriter::createSchema(odb::database &db)
+{
+    odb::transaction t(db.begin());
+    db.execute("CREATE TABLE IF NOT EXISTS \"TrackChunk\" ("
+               "\"id\" INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT,"
+               "\"eventId\" INTEGER NOT NULL,"
+               "\"seq\" INTEGER NOT NULL,"
+               "\"startTime\" INTEGER NOT NULL,"
+               "\"endTime\" INTEGER NOT NULL,"
+               "\"samples\" INTEGER NOT NULL,"
+               "\"data\" BLOB NOT NULL)");
+    db.execute("CREATE INDEX IF NOT EXISTS \"TrackChunk_eventId_i\" ON \"TrackChunk\" (\"eventId\", \"seq\")");
+    t.commit();
+}
+
+void EventWriter::stop()
+{
+    try {
+        if (isRunning()) {
+            // Behind everything already queued, it's the one mutation that waits for room
+            m_queue.push(Mutation{});
+            {
+                QMutexLocker lock(&m_mtx);
+                m_wake.wakeAll();
+            }
+
+            qCDebug(logger) << "Waiting for" << objectName() << "to exit gracefully...";
+            if (!wait(3000)) {
+                qCDebug(logger) << objectName() << "didn't exit. Applying force killing...";
+                terminate();
+                wait();
+            }
+            qCDebug(logger) << objectName() << "thread has exited...";
+        }
+    } catch (const std::exception &e) {
+        qCDebug(logger) << e.what();
+    } catch (...) {
+        qCCritical(logger) << "Uknown/Uncaught exception occurred!";
+    }
+}
+
+EventWriter::Ticket EventWriter::insertEvent(const APSS::ODB::Event &event)
+{
+    Mutation mutation;
+    mutation.type = Mutation::Insert;
+    mutation.ticket = std::make_shared<Ticket::State>();
+    mutation.event = event;
+
+    Ticket ticket;
+    ticket.m_state = mutation.ticket;
+    ticket.m_id = mutation.ticket->promise.get_future().share();
+
+    // The queue is sized for bursts, past that the track tries again with its next frame
+    if (!enqueue(std::move(mutation)))
+        return Ticket();
+
+    return ticket;
+}
+
+void EventWriter::finishEvent(const Ticket &ticket, const APSS::ODB::Event &event, PredictionRows predictions)
+{
+    if (!ticket.isValid())
+        return;
+
+    Mutation mutation;
+    mutation.type = Mutation::Finish;
+    mutation.ticket = ticket.m_state;
+    mutation.event = event;
+    mutation.predictions = std::move(predictions);
+    enqueue(std::move(mutation));
+}
+
+void EventWriter::appendTrack(const Ticket &ticket, PredictionRows predictions)
+{
+    if (!ticket.isValid() || predictions.empty())
+        return;
+
+    Mutation mutation;
+    mutation.type = Mutation::Append;
+    mutation.ticket = ticket.m_state;
+    mutation.predictions = std::move(predictions);
+    enqueue(std::move(mutation));
+}
+
+bool EventWriter::updatePlate(size_t eventId, const QString &licensePlateResults, const std::optional<QString> &subLabel)
+{
+    if (eventId == 0)
+        return false;
+
+    Mutation mutation;
+    mutation.type = Mutation::Plate;
+    mutation.event.id = eventId;
+    mutation.event.licensePlateResults = licensePlateResults;
+    mutation.event.subLabel = subLabel.value_or(QString());
+    mutation.hasSubLabel = subLabel.has_value();
+    return enqueue(std::move(mutation));
+}
+
+size_t EventWriter::trackChunkSize() const
+{
+    return m_trackChunkSize;
+}
+
+size_t EventWriter::dropped() const
+{
+    return m_dropped.load();
+}
+
+bool EventWriter::enqueue(Mutation mutation)
+{
+    if (!m_queue.try_push(std::move(mutation))) {
+        qCWarning(logger) << "Event writer queue is full, dropped a mutation," << ++m_dropped << "so far";
+        return false;
+    }
+
+    QMutexLocker lock(&m_mtx);
+    m_wake.wakeOne();
+    return true;
+}
+
+void EventWriter::run()
+{
+    qCInfo(logger) << "Starting" << objectName() << "thread";
+
+    try {
+        m_connection = static_cast<odb::sqlite::database &>(*m_db).connection();
+
+        std::vector<Mutation> group;
+        bool is_stopping = false;
+        while (!is_stopping) {
+            group.clear();
+
+            Mutation mutation;
+            m_queue.pop(mutation);
+            if (mutation.type == Mutation::Stop)
+                break;
+
+            // Group commit, whatever arrives within the interval goes into the same transaction
+            QElapsedTimer timer;
+            timer.start();
+            size_t group_rows = rows(mutation);
+            group.emplace_back(std::move(mutation));
+
+            while (group_rows < m_commitRows) {
+                if (!m_queue.try_pop(mutation)) {
+                    const qint64 remaining = m_commitInterval - timer.elapsed();
+                    if (remaining <= 0)
+                        break;
+
+                    // Pushed before they wake it, so checked under the lock nothing is missed
+                    QMutexLocker lock(&m_mtx);
+                    if (m_queue.empty())
+                        m_wake.wait(&m_mtx, static_cast<unsigned long>(remaining));
+                    continue;
+                }
+
+                if (mutation.type == Mutation::Stop) {
+                    is_stopping = true;
+                    break;
+                }
+
+                group_rows += rows(mutation);
+                group.emplace_back(std::move(mutation));
+            }
+
+            commit(group);
+        }
+    }
+    catch(const tbb::user_abort &) {}
+    catch(const std::exception &e) {
+        qCCritical(logger) << e.what();
+    }
+    catch(...) {
+        qCCritical(logger) << "Uknown/Uncaught exception occurred.";
+    }
+
+    finalizeStatements();
+    m_connection.reset();
+
+    qCInfo(logger) << "Stopping" << objectName() << "thread";
+}
+
+size_t EventWriter::rows(const Mutation &mutation) const
+{
+    return 1 + mutation.predictions.size();
+}
+
+void EventWriter::commit(std::vector<Mutation> &group)
+{
+    std::string error;
+    if (tryCommit(group, error)) {
+        for (auto &mutation : group) {
+            if (mutation.type == Mutation::Insert)
+                mutation.ticket->promise.set_value(mutation.ticket->id);
+        }
+        return;
+    }
+
+    qCCritical(logger) << "Failed committing" << group.size() << "event mutations," << error;
+    if (group.size() > 1)
+        qCInfo(logger) << "Retrying them one by one";
+
+    // The ones that fail on their own too are lost, with what they carried
+    QList<size_t> lost_tracks;
+    QList<size_t> lost_plates;
+    for (auto &mutation : group) {
+        const bool is_committed = group.size() > 1 && tryCommit(std::span(&mutation, 1), error);
+        if (mutation.type == Mutation::Insert) {
+            if (is_committed)
+                mutation.ticket->promise.set_value(mutation.ticket->id);
+            else
+                mutation.ticket->promise.set_exception(std::make_exception_ptr(std::runtime_error(error)));
+        } else if (is_committed) {
+            continue;
+        } else if (mutation.type == Mutation::Plate) {
+            lost_plates.append(mutation.event.id);
+        } else if (mutation.ticket->id != 0) {
+            lost_tracks.append(mutation.ticket->id);
+        }
+    }
+
+    if (!lost_tracks.isEmpty())
+        qCWarning(logger) << "Events that lost part of their track, or their end:" << lost_tracks;
+    if (!lost_plates.isEmpty())
+        qCWarning(logger) << "Events that lost their plate:" << lost_plates;
+}
+
+bool EventWriter::tryCommit(std::span<Mutation> mutations, std::string &error)
+{
+    // Restored on a rollback, or the chunks written next would leave gaps in the seq column.
+    // In reverse, so a ticket ends up with what it had before its first mutation.
+    std::vector<std::pair<Ticket::State *, int>> sequences;
+    sequences.reserve(mutations.size());
+    for (const auto &mutation : mutations) {
+        if (mutation.ticket)
+            sequences.emplace_back(mutation.ticket.get(), mutation.ticket->trackChunks);
+    }
+
+    try {
+        odb::transaction t(m_connection->begin());
+        for (auto &mutation : mutations)
+            apply(mutation);
+        t.commit();
+        return true;
+    } catch (const std::exception &e) {
+        error = e.what();
+    }
+
+    for (auto it = sequences.rbegin(); it != sequences.rend(); ++it)
+        it->first->trackChunks = it->second;
+
+    // None of the new events exist
+    for (auto &mutation : mutations) {
+        if (mutation.type == Mutation::Insert)
+            mutation.ticket->id = 0;
+    }
+    return false;
+}
+
+void EventWriter::apply(Mutation &mutation)
+{
+    if (mutation.type == Mutation::Insert) {
+        mutation.ticket->id = m_db->persist(mutation.event);
+    } else if (mutation.type == Mutation::Plate) {
+        updatePlate(mutation);
+    } else {
+        // The insert was either committed before or is part of this transaction
+        const size_t id = mutation.ticket->id;
+        if (id == 0)
+            return;
+
+        if (mutation.type == Mutation::Finish)
+            updateEvent(id, mutation.event);
+
+        insertTrack(*mutation.ticket, mutation.predictions);
+        if (m_predictionRows)
+            insertPredictions(id, mutation.predictions);
+    }
+}
+
+void EventWriter::updateEvent(size_t id, const APSS::ODB::Event &event)
+{
+    // Only the columns the tracker owns, the recognizer may be writing the others.
+    if (!m_updateEvent)
+        m_updateEvent = prepare("UPDATE \"Event\" SET \"endTime\" = ?, \"topScore\" = ?, \"score\" = ? WHERE \"id\" = ?");
+
+    sqlite3 *handle = m_connection->handle();
+    sqlite3_reset(m_updateEvent);
+    bindDateTime(m_updateEvent, 1, event.endTime);
+    sqlite3_bind_double(m_updateEvent, 2, event.topScore);
+    sqlite3_bind_double(m_updateEvent, 3, event.score);
+    sqlite3_bind_int64(m_updateEvent, 4, static_cast<sqlite3_int64>(id));
+    check(sqlite3_step(m_updateEvent), handle);
+}
+
+void EventWriter::updatePlate(const Mutation &mutation)
+{
+    // Only the columns the recognizer owns
+    if (!m_updatePlate)
+        m_updatePlate = prepare("UPDATE \"Event\" SET \"licensePlateResults\" = ?, "
+                                "\"subLabel\" = CASE WHEN ? THEN ? ELSE \"subLabel\" END WHERE \"id\" = ?");
+
+    sqlite3 *handle = m_connection->handle();
+    sqlite3_reset(m_updatePlate);
+    bindText(m_updatePlate, 1, mutation.event.licensePlateResults);
+    sqlite3_bind_int(m_updatePlate, 2, mutation.hasSubLabel ? 1 : 0);
+    bindText(m_updatePlate, 3, mutation.event.subLabel);
+    sqlite3_bind_int64(m_updatePlate, 4, static_cast<sqlite3_int64>(mutation.event.id));
+    check(sqlite3_step(m_updatePlate), handle);
+}
+
+void EventWriter::insertPredictions(size_t eventId, PredictionRows &predictions)
+{
+    if (predictions.empty())
+        return;
+
+    if (!m_insertPrediction) {
+        m_insertPrediction = prepare(insertPredictionsSql(1).c_str());
+        m_insertPredictions = prepare(insertPredictionsSql(PREDICTIONS_PER_INSERT).c_str());
+    }
+
+    sqlite3 *handle = m_connection->handle();
+    size_t offset = 0;
+    while (offset < predictions.size()) {
+        const size_t remaining = predictions.size() - offset;
+        sqlite3_stmt *stmt = remaining >= PREDICTIONS_PER_INSERT ? m_insertPredictions : m_insertPrediction;
+        const size_t n = stmt == m_insertPredictions ? PREDICTIONS_PER_INSERT : 1;
+
+        sqlite3_reset(stmt);
+        for (size_t r = 0; r < n; ++r) {
+            auto &[p, object] = predictions[offset + r];
+            p.eventId = eventId;
+            p.data = QString::fromStdString(rfl::json::write(object));
+
+            const int col = static_cast<int>(r) * 6;
+            sqlite3_bind_int64(stmt, col + 1, static_cast<sqlite3_int64>(p.eventId));
+            bindText(stmt, col + 2, p.frameId);
+            bindDateTime(stmt, col + 3, p.videoTimestamp);
+            bindDateTime(stmt, col + 4, p.streamTimestamp);
+            bindText(stmt, col + 5, p.data);
+            sqlite3_bind_int(stmt, col + 6, p.hasSubPredictions ? 1 : 0);
+        }
+
+        check(sqlite3_step(stmt), handle);
+        offset += n;
+    }
+}
+
+void EventWriter::insertTrack(Ticket::State &ticket, const PredictionRows &predictions)
+{
+    if (predictions.empty())
+        return;
+
+    if (!m_insertTrackChunk)
+        m_insertTrackChunk = prepare("INSERT INTO \"TrackChunk\" (\"eventId\", \"seq\", \"startTime\", \"endTime\", \"samples\", \"data\") VALUES (?, ?, ?, ?, ?, ?)");
+
+    sqlite3 *handle = m_connection->handle();
+    std::vector<TrackSample> samples;
+    samples.reserve(std::min(predictions.size(), m_trackChunkSize));
+
+    for (size_t offset = 0; offset < predictions.size(); offset += m_trackChunkSize) {
+        const size_t end = std::min(predictions.size(), offset + m_trackChunkSize);
+
+        samples.clear();
+        for (size_t i = offset; i < end; ++i)
+            samples.push_back({ sampleTime(predictions[i].first), predictions[i].second });
+
+        const std::vector<uint8_t> data = TrackCodec::encode(samples);
+
+        sqlite3_reset(m_insertTrackChunk);
+        sqlite3_bind_int64(m_insertTrackChunk, 1, static_cast<sqlite3_int64>(ticket.id));
+        sqlite3_bind_int(m_insertTrackChunk, 2, ticket.trackChunks++);
+        sqlite3_bind_int64(m_insertTrackChunk, 3, samples.front().timestamp);
+        sqlite3_bind_int64(m_insertTrackChunk, 4, samples.back().timestamp);
+        sqlite3_bind_int(m_insertTrackChunk, 5, static_cast<int>(samples.size()));
+        sqlite3_bind_blob(m_insertTrackChunk, 6, data.data(), static_cast<int>(data.size()), SQLITE_STATIC);
+        check(sqlite3_step(m_insertTrackChunk), handle);
+    }
+}
+
+sqlite3_stmt *EventWriter::prepare(const char *sql)
+{
+    sqlite3 *handle = m_connection->handle();
+    sqlite3_stmt *stmt = nullptr;
+    check(sqlite3_prepare_v3(handle, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr), handle);
+    return stmt;
+}
+
+void EventWriter::finalizeStatements()
+{
+    for (sqlite3_stmt **stmt : { &m_updateEvent, &m_updatePlate, &m_insertPrediction, &m_insertPredictions, &m_insertTrackChunk }) {
+        sqlite3_finalize(*stmt);
+        *stmt = nullptr;
+    }
+}
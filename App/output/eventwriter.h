@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include <odb/sqlite/database.hxx>
+
+#include <tbb_patched.h>
+#include <config/databaseconfig.h>
+#include <db/event-odb.hxx>
+#include <db/prediction-odb.hxx>
+#include <utils/prediction.h>
+
+struct sqlite3_stmt;
+
+/**
+ * @brief Write-behind writer of events and their predictions, on its own thread.
+ *
+ * Mutations are queued and committed in groups, every commit_interval ms or commit_rows rows,
+ * whichever comes first, so the tracking thread never waits on SQLite. None of them ever block,
+ * when the writer falls queue_size mutations behind the new ones are dropped, and counted. Predictions go in with
+ * multi-row inserts over prepared statements kept for the writer's own connection.
+ *
+ * The id of a new event is only known once its group is committed, it's handed out as a Ticket.
+ * A mutation that fails rolls back its whole group, the rest of the group is then retried one
+ * mutation at a time, so only the failing one is lost.
+ *
+ * A track's predictions are stored as TrackCodec chunks in the TrackChunk table, the JSON rows
+ * of the Prediction table are only written with prediction_rows, for debugging. Long tracks
+ * are appended chunk by chunk while alive, so their history never piles up in memory.
+ */
+class EventWriter : public QThread
+{
+    Q_OBJECT
+public:
+    using PredictionRows = std::vector<std::pair<APSS::ODB::Prediction, Prediction>>;
+
+    class Ticket {
+    public:
+        bool isValid() const;
+        // Committed, or failed
+        bool isReady() const;
+        // Only once ready, throws if the insert failed.
+        size_t id() const;
+
+    private:
+        friend class EventWriter;
+        struct State {
+            std::promise<size_t> promise;
+            size_t id = 0;      // Written and read by the writer thread only
+            int trackChunks = 0;    // Likewise, sequence of the next chunk
+        };
+
+        std::shared_ptr<State> m_state;
+        std::shared_future<size_t> m_id;
+    };
+
+    explicit EventWriter(std::shared_ptr<odb::database> db,
+                         const DatabaseConfig &config,
+                         QObject *parent = nullptr);
+    ~EventWriter();
+    // The tables written outside of the ODB model. Idempotent.
+    static void createSchema(odb::database &db);
+    // Writes whatever is queued, then exits.
+    void stop();
+
+    // Invalid if the queue is full.
+    Ticket insertEvent(const APSS::ODB::Event &event);
+    // Updates the end time and scores of the event, and adds its predictions. Their eventId is filled in.
+    void finishEvent(const Ticket &ticket, const APSS::ODB::Event &event, PredictionRows predictions);
+    // Adds predictions of a live event, in order. Best flushed trackChunkSize() rows at a time.
+    void appendTrack(const Ticket &ticket, PredictionRows predictions);
+    // Sets the plate results of a committed event, and its label if a watchlist was matched. Only
+    // those columns, the tracker may still be finishing it. Never blocks, false if the queue is full.
+    bool updatePlate(size_t eventId, const QString &licensePlateResults, const std::optional<QString> &subLabel);
+    size_t trackChunkSize() const;
+    // Mutations dropped on a full queue
+    size_t dropped() const;
+
+protected:
+    // QThread interface
+    void run() override;
+
+private:
+    struct Mutation {
+        enum Type { Insert, Append, Finish, Plate, Stop };
+
+        Type type = Stop;
+        std::shared_ptr<Ticket::State> ticket;
+        APSS::ODB::Event event;     // With Plate, only its id, plate results and sub label
+        bool hasSubLabel = false;
+        PredictionRows predictions;
+    };
+
+    bool enqueue(Mutation mutation);
+    size_t rows(const Mutation &mutation) const;
+    void commit(std::vector<Mutation> &group);
+    // In one transaction. Rolled back on failure, with the tickets as they were before.
+    bool tryCommit(std::span<Mutation> mutations, std::string &error);
+    void apply(Mutation &mutation);
+    void updateEvent(size_t id, const APSS::ODB::Event &event);
+    void updatePlate(const Mutation &mutation);
+    void insertPredictions(size_t eventId, PredictionRows &predictions);
+    void insertTrack(Ticket::State &ticket, const PredictionRows &predictions);
+    sqlite3_stmt *prepare(const char *sql);
+    void finalizeStatements();
+
+private:
+    std::shared_ptr<odb::database> m_db;
+    odb::sqlite::connection_ptr m_connection;
+    tbb::concurrent_bounded_queue<Mutation> m_queue;
+    std::atomic<size_t> m_dropped = 0;
+
+    // Wakes the writer within a group commit's window
+    QMutex m_mtx;
+    QWaitCondition m_wake;
+    int m_commitInterval = 50;
+    size_t m_commitRows = 512;
+    size_t m_trackChunkSize = 256;
+    bool m_predictionRows = false;
+
+    sqlite3_stmt *m_updateEvent = nullptr;
+    sqlite3_stmt *m_updatePlate = nullptr;
+    sqlite3_stmt *m_insertPrediction = nullptr;
+    sqlite3_stmt *m_insertPredictions = nullptr;    // PREDICTIONS_PER_INSERT rows at once
+    sqlite3_stmt *m_insertTrackChunk = nullptr;
+};
@@ -0,0 +1,150 @@
+#include <algorithm>
+
+#include <QDateTime>
+#include <QLoggingCategory>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "imagewriter.h"
+
+Q_STATIC_LOGGING_CATEGORY(logger, "apss.output.image_writer")
+
+namespace {
+
+constexpr double LATENCY_ALPHA = 0.1;
+
+}
+
+ImageWriter::ImageWriter(const SnapshotsConfig &config, EngineMetrics *metrics)
+    : m_metrics(metrics)
+    , m_format(config.format.value_or(ImageFormatEnum::JPEG))
+    , m_capacity(std::max(1, config.queue_size.value_or(64)))
+    , m_numWorkers(std::max(1, config.writers.value_or(2)))
+{
+    const int quality = std::clamp(config.quality.value_or(90), 1, 100);
+    if (m_format == ImageFormatEnum::WebP)
+        m_params = { cv::IMWRITE_WEBP_QUALITY, quality };
+    else
+        m_params = { cv::IMWRITE_JPEG_QUALITY, quality };
+}
+
+ImageWriter::~ImageWriter()
+{
+    stop();
+}
+
+void ImageWriter::start()
+{
+    QMutexLocker lock(&m_mtx);
+    if (!m_workers.isEmpty())
+        return;
+
+    m_isStopping = false;
+    for (int i = 0; i < m_numWorkers; ++i) {
+        QThread *worker = QThread::create([this]() { work(); });
+        worker->setObjectName(QString("image_writer_%1").arg(i));
+        worker->start(QThread::LowPriority);
+        m_workers.append(worker);
+    }
+}
+
+void ImageWriter::stop()
+{
+    QList<QThread *> workers;
+    {
+        QMutexLocker lock(&m_mtx);
+        m_isStopping = true;
+        workers.swap(m_workers);
+        m_hasJobs.wakeAll();
+    }
+
+    for (QThread *worker : std::as_const(workers)) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+QString ImageWriter::extension() const
+{
+    return m_format == ImageFormatEnum::WebP ? ".webp" : ".jpg";
+}
+
+bool ImageWriter::write(const QString &path, const cv::Mat &img)
+{
+    if (img.empty())
+        return false;
+
+    QMutexLocker lock(&m_mtx);
+    auto it = m_jobs.find(path);
+    if (it != m_jobs.end()) {
+        // Only the newest image of the track survives, it keeps its place in the queue
+        it->img = img;
+        return true;
+    }
+
+    if (m_order.size() >= m_capacity) {
+        ++m_dropped;
+        updateMetrics();
+        qCWarning(logger) << "Image queue is full, dropping" << path;
+        return false;
+    }
+
+    m_jobs.insert(path, Job{ img, QDateTime::currentMSecsSinceEpoch() });
+    m_order.push_back(path);
+    updateMetrics();
+    m_hasJobs.wakeOne();
+    return true;
+}
+
+size_t ImageWriter::pending() const
+{
+    QMutexLocker lock(&m_mtx);
+    return m_order.size();
+}
+
+void ImageWriter::work()
+{
+    QMutexLocker lock(&m_mtx);
+    while (true) {
+        while (m_order.empty() && !m_isStopping)
+            m_hasJobs.wait(&m_mtx);
+
+        // Drain before leaving, these are the thumbnails of events already in the database
+        if (m_order.empty())
+            break;
+
+        const QString path = m_order.front();
+        m_order.pop_front();
+        const Job job = m_jobs.take(path);
+        updateMetrics();
+
+        lock.unlock();
+        bool written = false;
+        try {
+            written = cv::imwrite(path.toStdString(), job.img, m_params);
+        } catch (const cv::Exception &e) {
+            qCWarning(logger) << "Failed writing" << path << "," << e.what();
+        }
+        const double latency = QDateTime::currentMSecsSinceEpoch() - job.queuedAt;
+        lock.relock();
+
+        if (!written)
+            qCWarning(logger) << "Failed writing" << path;
+
+        updateMetrics(latency);
+    }
+}
+
+void ImageWriter::updateMetrics(double latencyMs)
+{
+    // Called with m_mtx held
+    if (latencyMs >= 0.0)
+        m_latency = m_latency == 0.0 ? latencyMs : (1.0 - LATENCY_ALPHA) * m_latency + LATENCY_ALPHA * latencyMs;
+
+    if (!m_metrics)
+        return;
+
+    m_metrics->setImageWriterQueueDepth(static_cast<int>(m_order.size()));
+    m_metrics->setImageWriterDropped(m_dropped);
+    m_metrics->setImageWriterLatency(m_latency);
+}
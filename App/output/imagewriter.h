@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <opencv2/core/mat.hpp>
+
+#include <config/snapshotsconfig.h>
+#include <engine/enginemetrics.h>
+
+/**
+ * @brief Pool of threads writing thumbnails and plate crops to disk, off the tracking thread.
+ *
+ * The queue is bounded and keyed by path. As the path of an image is fixed for its track, a
+ * newer image of the same track replaces the pending one, and only the newest gets written.
+ */
+class ImageWriter
+{
+public:
+    explicit ImageWriter(const SnapshotsConfig &config, EngineMetrics *metrics = nullptr);
+    ~ImageWriter();
+    void start();
+    // Writes whatever is still pending, then joins the workers.
+    void stop();
+
+    // The file extension matching the configured format, i.e. ".jpg"
+    QString extension() const;
+    // Never blocks, returns false if the queue is full. The image must not be modified afterwards.
+    bool write(const QString &path, const cv::Mat &img);
+    size_t pending() const;
+
+private:
+    struct Job {
+        cv::Mat img;
+        qint64 queuedAt = 0;
+    };
+
+    void work();
+    void updateMetrics(double latencyMs = -1.0);
+
+private:
+    mutable QMutex m_mtx;
+    QWaitCondition m_hasJobs;
+    QHash<QString, Job> m_jobs;
+    std::deque<QString> m_order;
+    bool m_isStopping = false;
+
+    QList<QThread *> m_workers;
+    EngineMetrics *m_metrics = nullptr;
+    ImageFormatEnum m_format = ImageFormatEnum::JPEG;
+    std::vector<int> m_params;
+    size_t m_capacity = 64;
+    int m_numWorkers = 2;
+    int m_dropped = 0;
+    double m_latency = 0.0;
+};
@@ -0,0 +1,79 @@
+#include <algorithm>
+
+#include <QtEndian>
+
+#include "keyframeindex.h"
+
+namespace {
+
+constexpr qsizetype ENTRY_SIZE = 2 * sizeof(int64_t);
+
+}
+
+KeyframeIndex KeyframeIndex::fromByteArray(const QByteArray &data)
+{
+    KeyframeIndex index;
+    if (data.size() % ENTRY_SIZE != 0)
+        return index;
+
+    index.m_keyframes.reserve(data.size() / ENTRY_SIZE);
+    for (qsizetype pos = 0; pos < data.size(); pos += ENTRY_SIZE) {
+        const char *entry = data.constData() + pos;
+        index.m_keyframes.push_back({ qFromLittleEndian<qint64>(entry),
+                                      qFromLittleEndian<qint64>(entry + sizeof(int64_t)) });
+    }
+
+    return index;
+}
+
+QByteArray KeyframeIndex::toByteArray() const
+{
+    QByteArray data(static_cast<qsizetype>(m_keyframes.size()) * ENTRY_SIZE, Qt::Uninitialized);
+    char *entry = data.data();
+    for (const Keyframe &keyframe : m_keyframes) {
+        qToLittleEndian<qint64>(keyframe.time, entry);
+        qToLittleEndian<qint64>(keyframe.offset, entry + sizeof(int64_t));
+        entry += ENTRY_SIZE;
+    }
+
+    return data;
+}
+
+void KeyframeIndex::append(int64_t time, int64_t offset)
+{
+    if (!m_keyframes.empty() && time <= m_keyframes.back().time)
+        return;
+
+    m_keyframes.push_back({ time, offset });
+}
+
+void KeyframeIndex::clear()
+{
+    m_keyframes.clear();
+}
+
+bool KeyframeIndex::isEmpty() const
+{
+    return m_keyframes.empty();
+}
+
+size_t KeyframeIndex::size() const
+{
+    return m_keyframes.size();
+}
+
+const std::vector<KeyframeIndex::Keyframe> &KeyframeIndex::keyframes() const
+{
+    return m_keyframes;
+}
+
+std::optional<KeyframeIndex::Keyframe> KeyframeIndex::seek(int64_t time) const
+{
+    if (m_keyframes.empty())
+        return std::nullopt;
+
+    auto it = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), time, [](int64_t t, const Keyframe &keyframe) {
+        return t < keyframe.time;
+    });
+    return it == m_keyframes.begin() ? *it : *std::prev(it);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <QByteArray>
+
+/**
+ * @brief Where a segment's keyframes are, in time and in the file.
+ *
+ * Written by the segment writer as it goes and stored with the segment's Recording, so a player
+ * seeks into a segment by binary search here instead of opening and probing the file. Serialized
+ * as fixed-size little-endian pairs.
+ */
+class KeyframeIndex
+{
+public:
+    struct Keyframe {
+        int64_t time = 0;       // ms since the segment's start
+        int64_t offset = 0;     // Bytes into the file, where decoding can start
+    };
+
+    // Empty if the data is truncated
+    static KeyframeIndex fromByteArray(const QByteArray &data);
+    QByteArray toByteArray() const;
+
+    // Keyframes come in increasing time, one that doesn't is ignored.
+    void append(int64_t time, int64_t offset);
+    void clear();
+    bool isEmpty() const;
+    size_t size() const;
+    const std::vector<Keyframe> &keyframes() const;
+
+    // The last keyframe at or before time, the first one if time is before all of them.
+    std::optional<Keyframe> seek(int64_t time) const;
+
+private:
+    std::vector<Keyframe> m_keyframes;
+};
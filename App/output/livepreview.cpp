@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <QVideoFrameFormat>
+
+#include <opencv2/imgproc.hpp>
+
+#include "livepreview.h"
+
+LivePreview::LivePreview(qreal maxFps)
+{
+    setMaxFps(maxFps);
+    m_clock.start();
+}
+
+void LivePreview::setMaxFps(qreal maxFps)
+{
+    m_minInterval = maxFps > 0.0 ? 1000.0 / maxFps : 0.0;
+}
+
+bool LivePreview::isDue(const QString &camera)
+{
+    const qint64 now = m_clock.elapsed();
+    auto it = m_lastPresented.find(camera);
+    if (it != m_lastPresented.end() && now - *it < m_minInterval)
+        return false;
+
+    m_lastPresented.insert(camera, now);
+    return true;
+}
+
+QVideoFrame LivePreview::toVideoFrame(const cv::Mat &bgr, const QSize &target)
+{
+    if (bgr.empty() || bgr.type() != CV_8UC3)
+        return QVideoFrame();
+
+    // Fit into the target, keeping the aspect ratio, as the tile does
+    double scale = 1.0;
+    if (target.isValid() && !target.isEmpty())
+        scale = std::min({ 1.0, static_cast<double>(target.width()) / bgr.cols, static_cast<double>(target.height()) / bgr.rows });
+
+    // 4:2:0 needs even dimensions
+    const int width = std::max(2, static_cast<int>(std::lround(bgr.cols * scale)) & ~1);
+    const int height = std::max(2, static_cast<int>(std::lround(bgr.rows * scale)) & ~1);
+
+    cv::Mat scaled = bgr;
+    if (width != bgr.cols || height != bgr.rows)
+        cv::resize(bgr, scaled, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+
+    cv::Mat i420;
+    cv::cvtColor(scaled, i420, cv::COLOR_BGR2YUV_I420);
+
+    QVideoFrame frame(QVideoFrameFormat(QSize(width, height), QVideoFrameFormat::Format_NV12));
+    if (!frame.map(QVideoFrame::WriteOnly))
+        return QVideoFrame();
+
+    // I420 is Y, then the U and V planes, NV12 wants U and V interleaved
+    const uchar *y_plane = i420.data;
+    const uchar *u_plane = y_plane + width * height;
+    const uchar *v_plane = u_plane + (width / 2) * (height / 2);
+
+    for (int row = 0; row < height; ++row)
+        std::memcpy(frame.bits(0) + row * frame.bytesPerLine(0), y_plane + row * width, width);
+
+    for (int row = 0; row < height / 2; ++row) {
+        uchar *uv = frame.bits(1) + row * frame.bytesPerLine(1);
+        const uchar *u = u_plane + row * (width / 2);
+        const uchar *v = v_plane + row * (width / 2);
+        for (int col = 0; col < width / 2; ++col) {
+            uv[2 * col] = u[col];
+            uv[2 * col + 1] = v[col];
+        }
+    }
+
+    frame.unmap();
+    return frame;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSize>
+#include <QString>
+#include <QVideoFrame>
+#include <opencv2/core/mat.hpp>
+
+/**
+ * @brief Turns processed frames into what a live tile actually needs.
+ *
+ * Frames are scaled down to the tile's on-screen size, converted to NV12 so the scene graph
+ * can upload them as is, and each camera is capped at the display's refresh rate.
+ */
+class LivePreview
+{
+public:
+    explicit LivePreview(qreal maxFps = 60.0);
+    void setMaxFps(qreal maxFps);
+    // False if the camera's previous frame was presented too recently, true and remembered otherwise.
+    bool isDue(const QString &camera);
+    // Never upscales, an invalid target keeps the frame's size.
+    static QVideoFrame toVideoFrame(const cv::Mat &bgr, const QSize &target);
+
+private:
+    QElapsedTimer m_clock;
+    QHash<QString, qint64> m_lastPresented;     // ms, on m_clock
+    qreal m_minInterval = 0.0;                  // ms
+};
@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include <QDeadlineTimer>
+#include <QLoggingCategory>
+
+#include "muxingexecutor.h"
+
+Q_STATIC_LOGGING_CATEGORY(logger, "apss.output.muxing_executor")
+
+namespace {
+
+// Packets of an output written before its worker moves on to the next ready one
+constexpr int MUX_BATCH = 32;
+
+}
+
+MuxingExecutor::MuxingExecutor(int workers, size_t queueSize)
+    : m_numWorkers(std::max(1, workers))
+    , m_capacity(std::max<size_t>(1, queueSize))
+{}
+
+MuxingExecutor::~MuxingExecutor()
+{
+    stop();
+}
+
+void MuxingExecutor::start()
+{
+    if (!m_workers.isEmpty())
+        return;
+
+    for (int i = 0; i < m_numWorkers; ++i) {
+        QThread *worker = QThread::create([this]() { work(); });
+        worker->setObjectName(QString("muxer_%1").arg(i));
+        worker->start();
+        m_workers.append(worker);
+    }
+}
+
+void MuxingExecutor::stop(int timeoutMs)
+{
+    if (m_workers.isEmpty())
+        return;
+
+    QList<OutputPtr> outputs;
+    {
+        std::lock_guard lock(m_outputsMtx);
+        outputs = m_outputs;
+    }
+    for (const auto &output : std::as_const(outputs))
+        removeOutput(output);
+
+    // Queued packets are the recordings of the last seconds, let them in
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(0, timeoutMs));
+    {
+        std::unique_lock lock(m_pendingMtx);
+        if (!m_drained.wait_until(lock, deadline, [this]() { return m_pending.load() == 0; })) {
+            qCWarning(logger) << "Muxers didn't catch up within" << timeoutMs << "ms, dropping"
+                              << m_pending.load() << "queued packets";
+            m_isDropping.store(true);
+        }
+    }
+
+    for (int i = 0; i < m_workers.size(); ++i)
+        m_ready.push(nullptr);
+
+    for (QThread *worker : std::as_const(m_workers)) {
+        // Stuck in a write, it'd never return
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (!worker->wait(QDeadlineTimer(std::max<qint64>(500, remaining.count())))) {
+            qCWarning(logger) << worker->objectName() << "is stuck, forcing termination";
+            worker->terminate();
+            worker->wait();
+        }
+        delete worker;
+    }
+    m_workers.clear();
+
+    // Rescheduled after the workers took their nullptr, or left by a terminated one. Their segments
+    // still have to be finalized and indexed.
+    OutputPtr ready;
+    while (m_ready.try_pop(ready)) {}
+    {
+        std::lock_guard lock(m_outputsMtx);
+        outputs = m_outputs;
+    }
+    for (const auto &output : std::as_const(outputs)) {
+        Output::Item item;
+        while (output->m_queue.try_pop(item)) {}
+        output->m_size.store(0);
+
+        try {
+            close(output);
+        } catch (const std::exception &e) {
+            qCCritical(logger) << output->m_name << e.what();
+        } catch (...) {
+            qCCritical(logger) << "Uknown/Uncaught exception occurred in" << output->m_name;
+        }
+    }
+    m_pending.store(0);
+    m_isDropping.store(false);
+}
+
+MuxingExecutor::OutputPtr MuxingExecutor::addOutput(const QString &name, WriteFn write, CloseFn close)
+{
+    auto output = std::make_shared<Output>();
+    output->m_name = name;
+    output->m_write = std::move(write);
+    output->m_close = std::move(close);
+
+    std::lock_guard lock(m_outputsMtx);
+    m_outputs.append(output);
+    return output;
+}
+
+MuxingExecutor::OutputPtr MuxingExecutor::addOutput(const QString &name, QSharedPointer<PacketDistributor> source, WriteFn write, CloseFn close)
+{
+    OutputPtr output = addOutput(name, std::move(write), std::move(close));
+    if (!source)
+        return output;
+
+    // Weak, the reader lives in the output
+    std::weak_ptr<Output> weak = output;
+    output->m_distributor = source;
+    output->m_reader = source->addReader(name, [this, weak](PacketDistributor::Reader &) {
+        if (auto output = weak.lock())
+            schedule(output);
+    });
+    output->m_hasReader.store(true);
+
+    return output;
+}
+
+bool MuxingExecutor::push(const OutputPtr &output, SharedPacket pkt, AVRational timeBase)
+{
+    if (!output || !pkt || output->m_isClosing.load())
+        return false;
+
+    if (output->m_size.load() >= m_capacity) {
+        // Logged once in a while, a stalled disk would otherwise flood it
+        if (output->m_dropped.fetch_add(1) % 100 == 0)
+            qCWarning(logger) << output->m_name << "can't keep up, dropped" << output->m_dropped.load() << "packets";
+        return false;
+    }
+
+    output->m_size.fetch_add(1);
+    m_pending.fetch_add(1);
+    output->m_queue.push({ std::move(pkt), timeBase });
+    schedule(output);
+    return true;
+}
+
+void MuxingExecutor::removeOutput(const OutputPtr &output)
+{
+    if (!output || output->m_isClosing.exchange(true))
+        return;
+
+    m_pending.fetch_add(1);
+    output->m_queue.push({});
+    schedule(output);
+}
+
+size_t MuxingExecutor::pending(const OutputPtr &output) const
+{
+    if (!output)
+        return 0;
+
+    size_t pending = output->m_size.load();
+    if (output->m_hasReader.load() && !output->m_isClosing.load())
+        pending += output->m_reader->lag();
+    return pending;
+}
+
+size_t MuxingExecutor::dropped(const OutputPtr &output) const
+{
+    if (!output)
+        return 0;
+
+    size_t dropped = output->m_dropped.load();
+    if (output->m_hasReader.load())
+        dropped += output->m_reader->dropped();
+    return dropped;
+}
+
+void MuxingExecutor::schedule(const OutputPtr &output)
+{
+    if (!output->m_isScheduled.exchange(true))
+        m_ready.push(output);
+}
+
+void MuxingExecutor::work()
+{
+    try {
+        while (true) {
+            OutputPtr output;
+            m_ready.pop(output);
+            if (!output)
+                break;
+
+            run(output);
+        }
+    } catch (const tbb::user_abort &) {}
+}
+
+void MuxingExecutor::run(const OutputPtr &output)
+{
+    int written = 0;
+    if (output->m_hasReader.load() && !output->m_isClosed) {
+        PacketDistributor::Entry entry;
+        while (written < MUX_BATCH && !m_isDropping.load() && output->m_reader->read(entry)) {
+            try {
+                output->m_write(entry.pkt, entry.timeBase);
+            } catch (const std::exception &e) {
+                qCCritical(logger) << output->m_name << e.what();
+            } catch (...) {
+                qCCritical(logger) << "Uknown/Uncaught exception occurred in" << output->m_name;
+            }
+            ++written;
+        }
+    }
+
+    // Only once the reader has caught up, so the close that's queued comes after its packets
+    Output::Item item;
+    for (int i = written; i < MUX_BATCH && output->m_queue.try_pop(item); ++i) {
+        try {
+            if (!item.pkt) {
+                close(output);
+            } else {
+                output->m_size.fetch_sub(1);
+                // Checked at every packet, a stalled write can take long
+                if (!output->m_isClosed && !m_isDropping.load())
+                    output->m_write(item.pkt, item.timeBase);
+            }
+        } catch (const std::exception &e) {
+            qCCritical(logger) << output->m_name << e.what();
+        } catch (...) {
+            qCCritical(logger) << "Uknown/Uncaught exception occurred in" << output->m_name;
+        }
+
+        item = Output::Item();
+        done();
+    }
+
+    // Back of the line. A packet that arrived while it was scheduled has to be caught here, its push
+    // saw it as scheduled and didn't queue it.
+    output->m_isScheduled.store(false);
+    if (hasWork(output) && !output->m_isScheduled.exchange(true))
+        m_ready.push(output);
+}
+
+bool MuxingExecutor::hasWork(const OutputPtr &output) const
+{
+    if (!output->m_queue.empty())
+        return true;
+
+    return output->m_hasReader.load() && !output->m_isClosed && !m_isDropping.load() && output->m_reader->lag() > 0;
+}
+
+void MuxingExecutor::close(const OutputPtr &output)
+{
+    {
+        std::lock_guard lock(m_outputsMtx);
+        m_outputs.removeOne(output);
+    }
+
+    if (output->m_hasReader.load())
+        output->m_distributor->removeReader(output->m_reader);
+    // Set first, one that throws isn't closed again
+    if (!std::exchange(output->m_isClosed, true) && output->m_close)
+        output->m_close();
+}
+
+void MuxingExecutor::done()
+{
+    if (m_pending.fetch_sub(1) != 1)
+        return;
+
+    // Taken, so stop() can't miss it between checking and waiting
+    std::lock_guard lock(m_pendingMtx);
+    m_drained.notify_all();
+}
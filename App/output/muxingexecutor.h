@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <memory>
+
+#include <QList>
+#include <QString>
+#include <QThread>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <tbb_patched.h>
+#include <output/packetdistributor.h>
+#include <output/remuxer.h>
+
+/**
+ * @brief A fixed number of workers muxing any number of outputs.
+ *
+ * Every output has its own lock-free queue of packets and is scheduled cooperatively: it's put on
+ * the ready queue when a packet arrives and a worker writes a batch of its packets, then moves on
+ * to the next ready output. An output is only ever on one worker at a time, so its packets are
+ * written in order, and a slow one only holds up its own queue.
+ *
+ * Pushing never blocks and allocates no Qt events, so it's done straight from the capture threads.
+ * An output can also follow a PacketDistributor instead, it's then woken by the capture and reads
+ * the packets off its own reader, so they're never queued twice.
+ */
+class MuxingExecutor
+{
+public:
+    using WriteFn = std::function<void(const SharedPacket &pkt, AVRational timeBase)>;
+    using CloseFn = std::function<void()>;
+
+    class Output;
+    using OutputPtr = std::shared_ptr<Output>;
+
+    explicit MuxingExecutor(int workers = 2, size_t queueSize = 512);
+    ~MuxingExecutor();
+    void start();
+    // Writes whatever is queued, closes the outputs still open, then joins the workers. Whatever
+    // isn't written within timeoutMs, a stalled disk, is dropped. The outputs the workers didn't get
+    // to close are closed on the calling thread.
+    void stop(int timeoutMs = 5000);
+
+    // write and close are called on the workers, never concurrently for the same output.
+    OutputPtr addOutput(const QString &name, WriteFn write, CloseFn close = CloseFn());
+    // Writes every packet published to the distributor from now on, push() isn't needed.
+    OutputPtr addOutput(const QString &name, QSharedPointer<PacketDistributor> source, WriteFn write, CloseFn close = CloseFn());
+    // Never blocks, returns false if the output's queue is full or it's being removed.
+    bool push(const OutputPtr &output, SharedPacket pkt, AVRational timeBase);
+    // Closed once its queued packets are written.
+    void removeOutput(const OutputPtr &output);
+
+    // Including the ones its reader lags behind by, or lost
+    size_t pending(const OutputPtr &output) const;
+    size_t dropped(const OutputPtr &output) const;
+
+private:
+    void schedule(const OutputPtr &output);
+    void work();
+    void run(const OutputPtr &output);
+    bool hasWork(const OutputPtr &output) const;
+    void close(const OutputPtr &output);
+    void done();
+
+private:
+    tbb::concurrent_bounded_queue<OutputPtr> m_ready;   // nullptr stops a worker
+    QList<QThread *> m_workers;
+    QList<OutputPtr> m_outputs;     // Added, not yet closed. Guarded by m_outputsMtx
+    std::mutex m_outputsMtx;
+    std::atomic<size_t> m_pending = 0;
+    std::mutex m_pendingMtx;
+    std::condition_variable m_drained;     // m_pending reached 0
+    std::atomic<bool> m_isDropping = false; // Stopping past its deadline, nothing more is written
+
+    int m_numWorkers = 2;
+    size_t m_capacity = 512;
+};
+
+class MuxingExecutor::Output
+{
+public:
+    QString name() const { return m_name; }
+
+private:
+    friend class MuxingExecutor;
+
+    struct Item {
+        SharedPacket pkt;       // nullptr closes the output
+        AVRational timeBase = { 0, 1 };
+    };
+
+    QString m_name;
+    WriteFn m_write;
+    CloseFn m_close;
+    tbb::concurrent_queue<Item> m_queue;
+    QSharedPointer<PacketDistributor> m_distributor;
+    PacketDistributor::ReaderPtr m_reader;
+    std::atomic<bool> m_hasReader = false;  // Set once m_reader is, it can be woken before that
+    std::atomic<size_t> m_size = 0;
+    std::atomic<size_t> m_dropped = 0;
+    std::atomic<bool> m_isScheduled = false;
+    std::atomic<bool> m_isClosing = false;
+    bool m_isClosed = false;    // Workers only, and stop() once they exited
+};
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <utility>
+
+#include <QLoggingCategory>
+
+#include "packetdistributor.h"
+
+Q_STATIC_LOGGING_CATEGORY(logger, "apss.output.packet_distributor")
+
+PacketDistributor::PacketDistributor(size_t capacity)
+    : m_slots(std::max<size_t>(1, capacity))
+{}
+
+size_t PacketDistributor::capacity() const
+{
+    return m_slots.size();
+}
+
+uint64_t PacketDistributor::head() const
+{
+    return m_head.load(std::memory_order_acquire);
+}
+
+void PacketDistributor::publish(SharedPacket pkt, AVRational timeBase)
+{
+    if (!pkt)
+        return;
+
+    // The reference it replaces is released outside of the lock
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    Slot &slot = m_slots[head % m_slots.size()];
+    Entry overwritten;
+    {
+        std::lock_guard lock(slot.mtx);
+        overwritten = std::move(slot.entry);
+        slot.entry = { std::move(pkt), timeBase };
+        slot.seq = head;
+    }
+    m_head.store(head + 1, std::memory_order_release);
+
+    // Implicitly shared, copying it doesn't allocate
+    QList<ReaderPtr> readers;
+    {
+        std::lock_guard lock(m_readersMtx);
+        readers = m_readers;
+    }
+    for (const auto &reader : std::as_const(readers)) {
+        if (reader->m_notify)
+            reader->m_notify(*reader);
+    }
+}
+
+void PacketDistributor::setCodecParameters(const AVCodecParameters *codecpar)
+{
+    std::shared_ptr<AVCodecParameters> copy;
+    if (codecpar) {
+        copy.reset(avcodec_parameters_alloc(), [](AVCodecParameters *p) { avcodec_parameters_free(&p); });
+        if (!copy || avcodec_parameters_copy(copy.get(), codecpar) < 0) {
+            qCWarning(logger) << "Failed copying the codec parameters";
+            copy.reset();
+        }
+    }
+
+    std::lock_guard lock(m_codecparMtx);
+    m_codecpar = std::move(copy);
+}
+
+std::shared_ptr<const AVCodecParameters> PacketDistributor::codecParameters() const
+{
+    std::lock_guard lock(m_codecparMtx);
+    return m_codecpar;
+}
+
+PacketDistributor::ReaderPtr PacketDistributor::addReader(const QString &name, NotifyFn notify)
+{
+    auto reader = std::make_shared<Reader>();
+    reader->m_distributor = this;
+    reader->m_name = name;
+    reader->m_notify = std::move(notify);
+    reader->m_cursor.store(head());
+
+    std::lock_guard lock(m_readersMtx);
+    m_readers.append(reader);
+    return reader;
+}
+
+void PacketDistributor::removeReader(const ReaderPtr &reader)
+{
+    std::lock_guard lock(m_readersMtx);
+    m_readers.removeOne(reader);
+}
+
+QList<PacketDistributor::ReaderPtr> PacketDistributor::readers() const
+{
+    std::lock_guard lock(m_readersMtx);
+    return m_readers;
+}
+
+QString PacketDistributor::Reader::name() const
+{
+    return m_name;
+}
+
+bool PacketDistributor::Reader::read(Entry &entry)
+{
+    const auto &slots = m_distributor->m_slots;
+    uint64_t cursor = m_cursor.load(std::memory_order_relaxed);
+
+    // Re-read every time, the capture keeps publishing while this reads
+    for (uint64_t head = m_distributor->head(); cursor < head; head = m_distributor->head()) {
+        if (head - cursor > slots.size()) {
+            // Lapped, its packets are gone. Resume from the oldest one still held, at a keyframe.
+            const uint64_t lost = head - slots.size() - cursor;
+            m_dropped.fetch_add(lost);
+            qCWarning(logger) << m_name << "fell a whole ring behind, dropped" << lost << "packets";
+            cursor = head - slots.size();
+            m_needsKeyframe = true;
+            m_hasStarted = true;
+        }
+
+        const Slot &slot = slots[cursor % slots.size()];
+        Entry candidate;
+        {
+            std::lock_guard lock(slot.mtx);
+            // Overwritten since the head was read, it's lapped on the next pass
+            if (slot.seq != cursor)
+                continue;
+            candidate = slot.entry;
+        }
+
+        ++cursor;
+        if (m_needsKeyframe && !(candidate.pkt->flags & AV_PKT_FLAG_KEY)) {
+            // The ones before its first keyframe were never its to lose
+            if (m_hasStarted)
+                m_dropped.fetch_add(1);
+            continue;
+        }
+
+        m_needsKeyframe = false;
+        m_hasStarted = true;
+        entry = std::move(candidate);
+        m_cursor.store(cursor, std::memory_order_release);
+        return true;
+    }
+
+    m_cursor.store(cursor, std::memory_order_release);
+    return false;
+}
+
+uint64_t PacketDistributor::Reader::lag() const
+{
+    const uint64_t head = m_distributor->head();
+    const uint64_t cursor = m_cursor.load(std::memory_order_acquire);
+    return head > cursor ? head - cursor : 0;
+}
+
+uint64_t PacketDistributor::Reader::dropped() const
+{
+    return m_dropped.load();
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+using SharedPacket = QSharedPointer<AVPacket>;
+
+/**
+ * @brief Fans a camera's compressed packets out to any number of consumers, without copying them.
+ *
+ * The capture publishes every packet once into a fixed ring of references. Each consumer (the
+ * recorder, ...) has a Reader with its own cursor into the ring and takes
+ * the packets as references to the same refcounted buffers, whenever it gets to them.
+ *
+ * The capture never waits for a reader. Each slot has its own lock, held only to swap or copy its
+ * reference, so at worst it waits for a reader copying that one slot. One that falls a whole ring
+ * behind skips ahead to the next keyframe still in it, so it can carry on decoding, and counts what
+ * it skipped as dropped.
+ */
+class PacketDistributor
+{
+public:
+    struct Entry {
+        SharedPacket pkt;
+        AVRational timeBase = { 0, 1 };
+    };
+
+    class Reader;
+    using ReaderPtr = std::shared_ptr<Reader>;
+    // Called on the capture thread after every publish, so it has to be cheap, e.g. wake a worker.
+    using NotifyFn = std::function<void(Reader &reader)>;
+
+    explicit PacketDistributor(size_t capacity = 512);
+    size_t capacity() const;
+    // Sequence number of the next packet published
+    uint64_t head() const;
+
+    // Single producer. The packet is shared as is, it should be refcounted and not modified after.
+    void publish(SharedPacket pkt, AVRational timeBase);
+    // Of the stream published, copied so the readers can use them after the capture closed its
+    // input. Null until it's opened.
+    void setCodecParameters(const AVCodecParameters *codecpar);
+    std::shared_ptr<const AVCodecParameters> codecParameters() const;
+
+    // Starts at the next keyframe published.
+    ReaderPtr addReader(const QString &name, NotifyFn notify = NotifyFn());
+    void removeReader(const ReaderPtr &reader);
+    QList<ReaderPtr> readers() const;
+
+private:
+    struct Slot {
+        mutable std::mutex mtx;
+        Entry entry;
+        uint64_t seq = 0;   // Of the packet in it, it was lapped if not the one a reader expects
+    };
+
+    std::vector<Slot> m_slots;
+    std::atomic<uint64_t> m_head = 0;
+
+    mutable std::mutex m_readersMtx;
+    QList<ReaderPtr> m_readers;
+
+    mutable std::mutex m_codecparMtx;
+    std::shared_ptr<const AVCodecParameters> m_codecpar;
+};
+
+class PacketDistributor::Reader
+{
+public:
+    QString name() const;
+    // The next packet, false once it has caught up. Only to be called by one thread at a time.
+    bool read(Entry &entry);
+
+    // Packets published but not read yet
+    uint64_t lag() const;
+    // Packets it was lapped on, or skipped waiting for a keyframe after
+    uint64_t dropped() const;
+
+private:
+    friend class PacketDistributor;
+
+    const PacketDistributor *m_distributor = nullptr;
+    QString m_name;
+    NotifyFn m_notify;
+    std::atomic<uint64_t> m_cursor = 0;
+    std::atomic<uint64_t> m_dropped = 0;
+    bool m_needsKeyframe = true;
+    bool m_hasStarted = false;
+};
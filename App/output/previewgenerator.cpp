@@ -0,0 +1,410 @@
+#include <algorithm>
+
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QMutexLocker>
+
+#include <opencv2/imgcodecs.hpp>
+
+extern "C" {
+#include <libavutil/opt.h>
+#include <libswscale/swscale.h>
+}
+
+#include <output/remuxer.h>
+#include "previewgenerator.h"
+
+Q_STATIC_LOGGING_CATEGORY(logger, "apss.output.preview_generator")
+
+namespace {
+
+constexpr qint64 HOUR_MS = 60 * 60 * 1000;
+// An hour nothing more was recorded in this long after its end is finished, the camera stopped
+constexpr qint64 IDLE_HOUR_MS = 5 * 60 * 1000;
+constexpr int IDLE_CHECK_MS = 60 * 1000;
+
+int even(int value)
+{
+    return std::max(2, value & ~1);
+}
+
+}
+
+// The preview of one hour of a camera, while it's being written
+struct PreviewGenerator::Hour {
+    QDateTime start;
+    QDateTime firstFrame;
+    QDateTime lastFrame;
+    QString previewPath;
+    QString spritePath;
+    int jpegQuality = 70;
+
+    AVCodecContext *encoder = nullptr;
+    AVFrame *scaled = nullptr;
+    AVPacket *pkt = nullptr;
+    SwsContext *scaler = nullptr;
+    int64_t lastPts = AV_NOPTS_VALUE;
+    Remuxer preview;
+
+    SwsContext *tileScaler = nullptr;
+    cv::Size tileSize;
+    cv::Mat sprite;
+    int lastSlot = -1;
+
+    ~Hour()
+    {
+        preview.close();
+        sws_freeContext(tileScaler);
+        sws_freeContext(scaler);
+        av_packet_free(&pkt);
+        av_frame_free(&scaled);
+        avcodec_free_context(&encoder);
+    }
+};
+
+PreviewGenerator::PreviewGenerator(const APSSConfig &config,
+                                   QSharedPointer<StorageMaintainer> storage,
+                                   const QDir &dir,
+                                   QObject *parent)
+    : QThread(parent)
+    , m_config(config)
+    , m_storage(storage)
+    , m_dir(dir)
+{
+    setObjectName("preview_generator");
+}
+
+PreviewGenerator::~PreviewGenerator()
+{
+    stop();
+}
+
+void PreviewGenerator::stop()
+{
+    try {
+        if (isRunning()) {
+            requestInterruption();
+            {
+                QMutexLocker lock(&m_mtx);
+                m_wake.wakeAll();
+            }
+
+            qCDebug(logger) << "Waiting for" << objectName() << "to exit gracefully...";
+            wait();
+            qCDebug(logger) << objectName() << "thread has exited...";
+        }
+    } catch (const std::exception &e) {
+        qCDebug(logger) << e.what();
+    } catch (...) {
+        qCCritical(logger) << "Uknown/Uncaught exception occurred!";
+    }
+}
+
+void PreviewGenerator::addSegment(const RecordingSegment &segment)
+{
+    const auto config = m_config.cameras.find(segment.camera.toStdString());
+    if (config == m_config.cameras.end() || !config->second.record || !config->second.record->preview)
+        return;
+
+    m_pending.push(segment);
+
+    QMutexLocker lock(&m_mtx);
+    m_wake.wakeOne();
+}
+
+QString PreviewGenerator::previewPath(const QDir &dir, const QString &camera, const QDateTime &firstFrame)
+{
+    return QString("%1/%2/%3.mkv").arg(dir.absolutePath(), camera, firstFrame.toUTC().toString("yyyy-MM-dd_hh.mm.ss"));
+}
+
+QString PreviewGenerator::spritePath(const QDir &dir, const QString &camera, const QDateTime &firstFrame)
+{
+    return QString("%1/%2/%3.jpg").arg(dir.absolutePath(), camera, firstFrame.toUTC().toString("yyyy-MM-dd_hh.mm.ss"));
+}
+
+void PreviewGenerator::run()
+{
+    qCInfo(logger) << "Starting" << objectName() << "thread";
+
+    try {
+        RecordingSegment segment;
+        while (!isInterruptionRequested()) {
+            while (!isInterruptionRequested() && m_pending.try_pop(segment))
+                generate(segment);
+
+            finishIdleHours(QDateTime::currentDateTimeUtc());
+
+            QMutexLocker lock(&m_mtx);
+            if (!isInterruptionRequested() && m_pending.empty())
+                m_wake.wait(&m_mtx, IDLE_CHECK_MS);
+        }
+
+        // Only keyframes, it doesn't take long
+        while (m_pending.try_pop(segment))
+            generate(segment);
+    }
+    catch(const std::exception &e) {
+        qCCritical(logger) << e.what();
+    }
+    catch(...) {
+        qCCritical(logger) << "Uknown/Uncaught exception occurred.";
+    }
+
+    try {
+        for (auto &[camera, hour] : m_hours)
+            finishHour(camera, *hour);
+    } catch (const std::exception &e) {
+        qCCritical(logger) << e.what();
+    }
+    m_hours.clear();
+
+    qCInfo(logger) << "Stopping" << objectName() << "thread";
+}
+
+void PreviewGenerator::generate(const RecordingSegment &segment)
+{
+    AVFormatContext *ctx = nullptr;
+    const std::string path = segment.path.toStdString();
+    if (avformat_open_input(&ctx, path.c_str(), nullptr, nullptr) < 0 || avformat_find_stream_info(ctx, nullptr) < 0) {
+        qCWarning(logger) << "Failed to open segment" << segment.path;
+        avformat_close_input(&ctx);
+        return;
+    }
+
+    const AVCodec *codec = nullptr;
+    const int stream_index = av_find_best_stream(ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    AVCodecContext *decoder = stream_index >= 0 ? avcodec_alloc_context3(codec) : nullptr;
+    if (!decoder
+        || avcodec_parameters_to_context(decoder, ctx->streams[stream_index]->codecpar) < 0
+        || avcodec_open2(decoder, codec, nullptr) < 0) {
+        qCWarning(logger) << "Failed to open a decoder for" << segment.path;
+        avcodec_free_context(&decoder);
+        avformat_close_input(&ctx);
+        return;
+    }
+    decoder->skip_frame = AVDISCARD_NONKEY;
+
+    // The segment's timestamps start at 0, on its first keyframe
+    const AVRational time_base = ctx->streams[stream_index]->time_base;
+    AVPacket *pkt = av_packet_alloc();
+    AVFrame *frame = av_frame_alloc();
+    auto receive = [&]() {
+        while (avcodec_receive_frame(decoder, frame) == 0) {
+            const int64_t ts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+            if (ts != AV_NOPTS_VALUE)
+                addFrame(segment.camera, segment.startTime.addMSecs(av_rescale_q(ts, time_base, { 1, 1000 })), frame);
+            av_frame_unref(frame);
+        }
+    };
+
+    while (av_read_frame(ctx, pkt) >= 0) {
+        // Not even read into the decoder, only keyframes are previewed
+        if (pkt->stream_index == stream_index && (pkt->flags & AV_PKT_FLAG_KEY)) {
+            avcodec_send_packet(decoder, pkt);
+            receive();
+        }
+        av_packet_unref(pkt);
+    }
+    avcodec_send_packet(decoder, nullptr);
+    receive();
+
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    avcodec_free_context(&decoder);
+    avformat_close_input(&ctx);
+}
+
+void PreviewGenerator::addFrame(const QString &camera, const QDateTime &time, const AVFrame *frame)
+{
+    const qint64 ms = time.toMSecsSinceEpoch();
+    const QDateTime hour_start = QDateTime::fromMSecsSinceEpoch(ms - ms % HOUR_MS, Qt::UTC);
+
+    std::unique_ptr<Hour> &hour = m_hours[camera];
+    if (hour && hour->start != hour_start) {
+        // Footage of an hour already finished, from a backlog or a clock change
+        if (hour_start < hour->start)
+            return;
+
+        finishHour(camera, *hour);
+        hour.reset();
+    }
+
+    if (!hour && !(hour = openHour(camera, time, frame))) {
+        m_hours.erase(camera);
+        return;
+    }
+
+    const int64_t pts = ms - hour->start.toMSecsSinceEpoch();
+    if (hour->lastPts != AV_NOPTS_VALUE && pts <= hour->lastPts)
+        return;
+
+    encode(*hour, frame, pts);
+    drawTile(*hour, frame, static_cast<int>(pts / (TILE_INTERVAL * 1000)));
+    hour->lastPts = pts;
+    hour->lastFrame = time;
+}
+
+std::unique_ptr<PreviewGenerator::Hour> PreviewGenerator::openHour(const QString &camera, const QDateTime &time, const AVFrame *frame)
+{
+    const qint64 ms = time.toMSecsSinceEpoch();
+    const Quality q = quality(camera);
+
+    auto hour = std::make_unique<Hour>();
+    hour->start = QDateTime::fromMSecsSinceEpoch(ms - ms % HOUR_MS, Qt::UTC);
+    hour->firstFrame = time;
+    hour->lastFrame = time;
+    hour->previewPath = previewPath(m_dir, camera, time);
+    hour->spritePath = spritePath(m_dir, camera, time);
+    hour->jpegQuality = q.jpegQuality;
+
+    // Never upscaled
+    const int width = even(std::min(q.width, frame->width));
+    const int height = even(static_cast<int>(av_rescale(width, frame->height, frame->width)));
+
+    const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+    if (!codec)
+        codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+    hour->encoder = codec ? avcodec_alloc_context3(codec) : nullptr;
+    if (!hour->encoder) {
+        qCWarning(logger) << "No encoder for previews";
+        return nullptr;
+    }
+
+    hour->encoder->width = width;
+    hour->encoder->height = height;
+    hour->encoder->pix_fmt = AV_PIX_FMT_YUV420P;
+    hour->encoder->time_base = { 1, 1000 };
+    hour->encoder->bit_rate = q.bitRate;
+    hour->encoder->gop_size = 10;
+    hour->encoder->max_b_frames = 0;
+    hour->encoder->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    av_opt_set(hour->encoder->priv_data, "preset", "veryfast", 0);
+    if (avcodec_open2(hour->encoder, codec, nullptr) < 0) {
+        qCWarning(logger) << "Failed to open the preview encoder" << codec->name;
+        return nullptr;
+    }
+
+    hour->scaled = av_frame_alloc();
+    hour->scaled->format = AV_PIX_FMT_YUV420P;
+    hour->scaled->width = width;
+    hour->scaled->height = height;
+    hour->pkt = av_packet_alloc();
+    if (av_frame_get_buffer(hour->scaled, 0) < 0)
+        return nullptr;
+
+    QFileInfo(hour->previewPath).dir().mkpath(".");
+    AVCodecParameters *codecpar = avcodec_parameters_alloc();
+    avcodec_parameters_from_context(codecpar, hour->encoder);
+    const bool is_open = hour->preview.openOutput(hour->previewPath, codecpar, hour->encoder->time_base)
+                         && hour->preview.writeHeader();
+    avcodec_parameters_free(&codecpar);
+    if (!is_open) {
+        qCWarning(logger) << "Failed to open preview" << hour->previewPath;
+        return nullptr;
+    }
+
+    // Half the preview's width, a tile per TILE_INTERVAL of the hour
+    hour->tileSize = cv::Size(even(width / 2), even(height / 2));
+    const int rows = (HOUR_MS / 1000 / TILE_INTERVAL + SPRITE_COLUMNS - 1) / SPRITE_COLUMNS;
+    hour->sprite = cv::Mat::zeros(rows * hour->tileSize.height, SPRITE_COLUMNS * hour->tileSize.width, CV_8UC3);
+
+    return hour;
+}
+
+void PreviewGenerator::encode(Hour &hour, const AVFrame *frame, int64_t pts)
+{
+    hour.scaler = sws_getCachedContext(hour.scaler,
+                                       frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+                                       hour.scaled->width, hour.scaled->height, AV_PIX_FMT_YUV420P,
+                                       SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!hour.scaler || av_frame_make_writable(hour.scaled) < 0)
+        return;
+
+    sws_scale(hour.scaler, frame->data, frame->linesize, 0, frame->height, hour.scaled->data, hour.scaled->linesize);
+    hour.scaled->pts = pts;
+    if (avcodec_send_frame(hour.encoder, hour.scaled) < 0)
+        return;
+
+    while (avcodec_receive_packet(hour.encoder, hour.pkt) == 0) {
+        SharedPacket out(av_packet_clone(hour.pkt), [](AVPacket *p) { av_packet_free(&p); });
+        hour.preview.writePacket(out, hour.encoder->time_base);
+        av_packet_unref(hour.pkt);
+    }
+}
+
+void PreviewGenerator::drawTile(Hour &hour, const AVFrame *frame, int slot)
+{
+    const int slots = (hour.sprite.rows / hour.tileSize.height) * SPRITE_COLUMNS;
+    if (slot <= hour.lastSlot || slot >= slots)
+        return;
+
+    hour.tileScaler = sws_getCachedContext(hour.tileScaler,
+                                           frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+                                           hour.tileSize.width, hour.tileSize.height, AV_PIX_FMT_BGR24,
+                                           SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!hour.tileScaler)
+        return;
+
+    // Scaled straight into its place in the sheet
+    cv::Mat tile = hour.sprite(cv::Rect((slot % SPRITE_COLUMNS) * hour.tileSize.width,
+                                        (slot / SPRITE_COLUMNS) * hour.tileSize.height,
+                                        hour.tileSize.width,
+                                        hour.tileSize.height));
+    uint8_t *dst[] = { tile.data };
+    const int dst_stride[] = { static_cast<int>(tile.step) };
+    sws_scale(hour.tileScaler, frame->data, frame->linesize, 0, frame->height, dst, dst_stride);
+    hour.lastSlot = slot;
+}
+
+void PreviewGenerator::finishHour(const QString &camera, Hour &hour)
+{
+    avcodec_send_frame(hour.encoder, nullptr);
+    while (avcodec_receive_packet(hour.encoder, hour.pkt) == 0) {
+        SharedPacket out(av_packet_clone(hour.pkt), [](AVPacket *p) { av_packet_free(&p); });
+        hour.preview.writePacket(out, hour.encoder->time_base);
+        av_packet_unref(hour.pkt);
+    }
+    hour.preview.close();
+
+    if (!cv::imwrite(hour.spritePath.toStdString(), hour.sprite, { cv::IMWRITE_JPEG_QUALITY, hour.jpegQuality }))
+        qCWarning(logger) << "Failed writing sprite" << hour.spritePath;
+
+    qCDebug(logger) << "Finished the preview of" << camera << "from" << hour.firstFrame << "to" << hour.lastFrame;
+    if (!m_storage)
+        return;
+
+    m_storage->addFile(StorageMaintainer::Kind::Preview, camera, hour.previewPath, hour.firstFrame, hour.lastFrame, QFileInfo(hour.previewPath).size());
+    if (QFileInfo::exists(hour.spritePath))
+        m_storage->addFile(StorageMaintainer::Kind::Sprite, camera, hour.spritePath, hour.firstFrame, hour.lastFrame, QFileInfo(hour.spritePath).size());
+}
+
+void PreviewGenerator::finishIdleHours(const QDateTime &now)
+{
+    for (auto it = m_hours.begin(); it != m_hours.end();) {
+        if (it->second->start.msecsTo(now) < HOUR_MS + IDLE_HOUR_MS) {
+            ++it;
+            continue;
+        }
+
+        finishHour(it->first, *it->second);
+        it = m_hours.erase(it);
+    }
+}
+
+PreviewGenerator::Quality PreviewGenerator::quality(const QString &camera) const
+{
+    RecordPreviewConfig preview;
+    const auto config = m_config.cameras.find(camera.toStdString());
+    if (config != m_config.cameras.end() && config->second.record && config->second.record->preview)
+        preview = config->second.record->preview.value();
+
+    switch (preview.quality.value_or(RecordQualityEnum::Medium)) {
+    case RecordQualityEnum::VeryLow:    return { 160, 32000, 50 };
+    case RecordQualityEnum::Low:        return { 240, 64000, 60 };
+    case RecordQualityEnum::Medium:     return { 320, 128000, 70 };
+    case RecordQualityEnum::High:       return { 480, 256000, 80 };
+    case RecordQualityEnum::VeryHigh:   return { 640, 512000, 90 };
+    }
+
+    return Quality();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+
+#include <QDateTime>
+#include <QDir>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <opencv2/core.hpp>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+#include <apss.h>
+#include <tbb_patched.h>
+#include <config/apssconfig.h>
+#include <output/segmentwriter.h>
+#include <output/storagemaintainer.h>
+
+/**
+ * @brief Low-resolution previews of the recordings, so scrubbing never touches the footage.
+ *
+ * For every hour of a camera's recording there's a preview clip of its keyframes only, small and
+ * at a low bitrate, and a JPEG sprite sheet with a tile every TILE_INTERVAL seconds, laid out by
+ * the time into the hour. Both are registered with the storage maintainer, which keeps them as
+ * long as any of the footage they cover. Their size follows the camera's record preview quality.
+ *
+ * Closed segments are queued to it, and only their keyframes are decoded. An hour is finished once
+ * the camera's footage moves past it, a while after it ends, or when stopped.
+ */
+class PreviewGenerator : public QThread
+{
+    Q_OBJECT
+public:
+    static constexpr int TILE_INTERVAL = 10;    // Seconds of footage a sprite tile stands for
+    static constexpr int SPRITE_COLUMNS = 12;   // 30 rows for the hour
+
+    explicit PreviewGenerator(const APSSConfig &config,
+                              QSharedPointer<StorageMaintainer> storage = nullptr,
+                              const QDir &dir = PREVIEW_DIR,
+                              QObject *parent = nullptr);
+    ~PreviewGenerator();
+    // Previews what was queued before, and finishes the hours started.
+    void stop();
+
+    // Never blocks. Skipped if the camera has no record preview config.
+    void addSegment(const RecordingSegment &segment);
+
+    // Named after their first frame, under dir/camera/. The sprite's hour is the one that's in.
+    static QString previewPath(const QDir &dir, const QString &camera, const QDateTime &firstFrame);
+    static QString spritePath(const QDir &dir, const QString &camera, const QDateTime &firstFrame);
+
+protected:
+    // QThread interface
+    void run() override;
+
+private:
+    struct Quality {
+        int width = 320;
+        int64_t bitRate = 128000;
+        int jpegQuality = 70;
+    };
+
+    struct Hour;
+
+    void generate(const RecordingSegment &segment);
+    void addFrame(const QString &camera, const QDateTime &time, const AVFrame *frame);
+    std::unique_ptr<Hour> openHour(const QString &camera, const QDateTime &time, const AVFrame *frame);
+    void encode(Hour &hour, const AVFrame *frame, int64_t pts);
+    void drawTile(Hour &hour, const AVFrame *frame, int slot);
+    void finishHour(const QString &camera, Hour &hour);
+    void finishIdleHours(const QDateTime &now);
+    Quality quality(const QString &camera) const;
+
+private:
+    const APSSConfig &m_config;
+    QSharedPointer<StorageMaintainer> m_storage;
+    QDir m_dir;
+    tbb::concurrent_queue<RecordingSegment> m_pending;
+
+    QMutex m_mtx;
+    QWaitCondition m_wake;
+
+    // Thread only
+    std::unordered_map<QString, std::unique_ptr<Hour>> m_hours;
+};
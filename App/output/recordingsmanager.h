@@ -1,50 +1,82 @@
 #pragma once
 
-#include <QObject>
-#include <QMediaCaptureSession>
-#include <QMediaRecorder>
-#include <QVideoFrameInput>
+#include <memory>
+#include <optional>
 
-#include <opencv2/core/mat.hpp>
-#include <opencv2/videoio.hpp>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
 
 #include <odb/sqlite/database.hxx>
 
 #include <tbb_patched.h>
 #include <camera/camerametrics.h>
 #include <config/apssconfig.h>
-#include <output/packetringbuffer.h>
-#include <output/perobjectremuxer.h>
-#include <utils/frame.h>
+#include <output/muxingexecutor.h>
+#include <output/packetdistributor.h>
+#include <output/previewgenerator.h>
+#include <output/remuxer.h>
+#include <output/segmentwriter.h>
+#include <output/storagemaintainer.h>
+
+// Where playback of a camera's recordings, from a given time, starts
+struct RecordingPosition {
+    QString path;
+    QDateTime segmentStart;
+    QDateTime keyframeTime;     // At or before the time asked for, after it if that was a gap
+    int64_t offset = 0;         // Bytes into the file, of that keyframe
+};
 
 // manager
+// Continuous recording of every camera with recording enabled, one segment writer per camera,
+// muxed by a small pool of workers. Events don't own recordings, they're time ranges cut out of
+// the segments on demand.
 class RecordingsManager : public QObject
 {
     Q_OBJECT
 public:
     explicit RecordingsManager(const APSSConfig &config,
                                std::shared_ptr<odb::database> db,
-                               const QHash<QString, SharedCameraMetrics> &cameraMetrics);
+                               const QHash<QString, SharedCameraMetrics> &cameraMetrics,
+                               QSharedPointer<StorageMaintainer> storage = nullptr);
+
+    // Segments of the camera overlapping the range, oldest first, from the Recording index and
+    // the ones not indexed yet, with what's on disk of the one being written last. Thread safe.
+    QList<RecordingSegment> segments(const QString &camera, const QDateTime &start, const QDateTime &end) const;
+    // Cuts the range, padded by the camera's pre/post capture, into a clip. Empty if nothing was recorded. Thread safe.
+    QString exportClip(const QString &camera, const QDateTime &start, const QDateTime &end, const QString &name) const;
+    // From the Recording index, no file is opened. Across any number of days, empty if nothing
+    // was recorded at or after the time. Thread safe.
+    std::optional<RecordingPosition> seek(const QString &camera, const QDateTime &time) const;
 
-public slots:
     void init();
     void stop();
-    void onRecordFrame(SharedFrame frame, const QList<int> &activeEvents);
+    // Starts recording every packet the camera's capture publishes, if it has recording enabled.
+    void record(const QString &camera, QSharedPointer<PacketDistributor> packets);
+
+public slots:
+    // Deleted by the storage maintainer, they're no longer part of any clip
+    void forgetFiles(const QStringList &paths);
 
 private:
-    struct Remuxer {
-        PerObjectRemuxer *remuxer = nullptr;
-        QThread *thread = nullptr;
-        QDateTime startTime;
-        bool isFree = true;
-        int assignedTo = -1;
-    };
+    void addSegment(const RecordingSegment &segment);
+    // More of the one being written was flushed to disk
+    void updateOpenSegment(const RecordingSegment &segment);
 
+private:
     const APSSConfig &m_apssConfig;
     std::shared_ptr<odb::database> m_db;
-
-    // recorder/remuxers
     const QHash<QString, SharedCameraMetrics> &m_cameraMetrics;
-    QList<Remuxer> m_remuxerPool;
-};
+    QSharedPointer<StorageMaintainer> m_storage;
+    PreviewGenerator m_previews;
+
+    MuxingExecutor m_executor;
+    // Written by record() only, on the engine's thread
+    QHash<QString, MuxingExecutor::OutputPtr> m_outputs;
 
+    mutable QMutex m_mtx;
+    QHash<QString, QList<RecordingSegment>> m_segments;     // The last few closed, maybe not indexed yet
+    QHash<QString, RecordingSegment> m_openSegments;
+    QHash<QString, QDateTime> m_openRefreshed;     // End of the open segment when last indexed
+};
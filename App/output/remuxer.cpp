@@ -0,0 +1,166 @@
+#include "remuxer.h"
+
+#include <QLoggingCategory>
+
+Q_STATIC_LOGGING_CATEGORY(logger, "apss.output.remuxer");
+
+Remuxer::Remuxer() {}
+
+Remuxer::~Remuxer() {
+    close();
+}
+
+bool Remuxer::openOutput(const QString &filename, const AVStream *inStream) {
+    return openOutput(filename, inStream->codecpar, inStream->time_base);
+}
+
+bool Remuxer::openOutput(const QString &filename, const AVCodecParameters *codecpar, AVRational timeBase) {
+    std::string file = filename.toStdString();
+    avformat_alloc_output_context2(&m_oc, nullptr, nullptr, file.c_str());
+    if (!m_oc) {
+        qCCritical(logger) << "Failed to alloc output context for " << filename;
+        return false;
+    }
+    m_outStream = avformat_new_stream(m_oc, nullptr);
+    if (!m_outStream) {
+        qCCritical(logger) << "Failed to create out stream\n";
+        return false;
+    }
+    // copy codec parameters
+    int ret = avcodec_parameters_copy(m_outStream->codecpar, codecpar);
+    if (ret < 0) {
+        qCCritical(logger) << "Failed to copy codecpar\n";
+        return false;
+    }
+    m_outStream->codecpar->codec_tag = 0;   // Let the muxer pick its own
+    m_outStream->time_base = timeBase;
+
+    if (!(m_oc->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open(&m_oc->pb, file.c_str(), AVIO_FLAG_WRITE);
+        if (ret < 0) {
+            char buf[256]; av_strerror(ret, buf, sizeof(buf));
+            qCCritical(logger) << "Could not open output file: " << buf << "\n";
+            return false;
+        }
+    }
+    // We'll write header on-demand right before the first packet (so we can set options if needed)
+    m_path = filename;
+
+    return true;
+}
+
+bool Remuxer::writeHeader() {
+    if (m_headerWritten)
+        return true;
+
+    int ret = avformat_write_header(m_oc, nullptr);
+    if (ret < 0) {
+        char buf[256];
+        av_strerror(ret, buf, sizeof(buf));
+        qCCritical(logger) << "write_header failed: " << buf << "\n";
+        return false;
+    }
+
+    m_headerWritten = true;
+    return true;
+}
+
+bool Remuxer::writePacket(QSharedPointer<AVPacket> pkt, AVRational inTb, AVRational outTb, int outStreamIndex) {
+    if (!pkt || !m_oc)
+        return false;
+
+    // Decode order. Anything at or before the last written packet came from the ring buffer already.
+    const int64_t ts = pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+    if (m_lastTs != AV_NOPTS_VALUE && ts != AV_NOPTS_VALUE && ts <= m_lastTs)
+        return true;
+
+    if (m_tsOffset == AV_NOPTS_VALUE) {
+        // Nothing before a keyframe can be decoded
+        if (!(pkt->flags & AV_PKT_FLAG_KEY) || ts == AV_NOPTS_VALUE)
+            return true;
+        m_tsOffset = ts;
+    }
+
+    // The packet is shared with the other writers, rebase and rescale a reference of it
+    AVPacket *out = av_packet_clone(pkt.get());
+    if (!out)
+        return false;
+
+    if (out->pts != AV_NOPTS_VALUE)
+        out->pts -= m_tsOffset;
+    if (out->dts != AV_NOPTS_VALUE)
+        out->dts -= m_tsOffset;
+    av_packet_rescale_ts(out, inTb, outTb);
+    out->stream_index = outStreamIndex;
+
+    int ret = av_interleaved_write_frame(m_oc, out);
+    av_packet_free(&out);
+    if (ret < 0) {
+        char buf[256];
+        av_strerror(ret, buf, sizeof(buf));
+        qCCritical(logger) << "Failed to write packet:" << buf << "\n";
+        return false;
+    }
+
+    if (ts != AV_NOPTS_VALUE)
+        m_lastTs = ts;
+    return true;
+}
+
+bool Remuxer::writePacket(QSharedPointer<AVPacket> pkt, AVRational inTb)
+{
+    // The muxer may change the stream's time base when writing the header
+    if (!m_oc || !writeHeader())
+        return false;
+
+    return writePacket(pkt, inTb, m_outStream->time_base, m_outStream->index);
+}
+
+void Remuxer::close() {
+    if (!m_oc)
+        return;
+    // flush and trailer
+    if (m_headerWritten)
+        av_write_trailer(m_oc);
+    if (!(m_oc->oformat->flags & AVFMT_NOFILE))
+        avio_closep(&m_oc->pb);
+
+    avformat_free_context(m_oc);
+    m_oc = nullptr;
+    m_outStream = nullptr;
+    m_headerWritten = false;
+    m_tsOffset = AV_NOPTS_VALUE;
+    m_lastTs = AV_NOPTS_VALUE;
+}
+
+AVStream *Remuxer::outStream() const
+{
+    return m_outStream;
+}
+
+QString Remuxer::path()
+{
+    return m_path;
+}
+
+bool Remuxer::isOpen() const
+{
+    return m_oc != nullptr;
+}
+
+int64_t Remuxer::size() const
+{
+    return m_oc && m_oc->pb ? avio_tell(m_oc->pb) : 0;
+}
+
+int64_t Remuxer::flush()
+{
+    if (!m_oc || !m_oc->pb || !writeHeader())
+        return -1;
+
+    av_interleaved_write_frame(m_oc, nullptr);
+    if (m_oc->oformat->flags & AVFMT_ALLOW_FLUSH)
+        av_write_frame(m_oc, nullptr);
+    avio_flush(m_oc->pb);
+    return avio_tell(m_oc->pb);
+}
@@ -7,32 +7,40 @@ extern "C" {
 #include <libavformat/avformat.h>
 }
 
-#include <output/packetringbuffer.h>
+#include <output/packetdistributor.h>
 
-using SharedPacket = QSharedPointer<AVPacket>;
-
-// Per-object remuxer worker (no re-encoding).
-class PerObjectRemuxer : public QObject {
+// Remuxer of a single video stream into a file (no re-encoding).
+// Output timestamps are rebased to its first packet, which is always a keyframe, so the file
+// plays from its first frame.
+class Remuxer : public QObject {
     Q_OBJECT
 public:
-    PerObjectRemuxer();
-    ~PerObjectRemuxer();
+    Remuxer();
+    ~Remuxer();
     AVStream *outStream() const;
     QString path();
+    bool isOpen() const;
+    // Bytes written so far
+    int64_t size() const;
+    // Writes out what the muxer holds back (a Matroska cluster), so the next packet starts a new one.
+    // The offset it starts at, -1 if not open.
+    int64_t flush();
 
 public slots:
     // Create an output file and copy the codec parameters from in_stream->codecpar
     bool openOutput(const QString &filename, const AVStream *inStream);
+    bool openOutput(const QString &filename, const AVCodecParameters *codecpar, AVRational timeBase);
     bool writeHeader();
     // Write a packet that came from input stream; rescale timestamps to output timebase
     bool writePacket(QSharedPointer<AVPacket> pkt, AVRational inTb, AVRational outTb, int outStreamIndex);
     bool writePacket(QSharedPointer<AVPacket> pkt, AVRational inTb);
-    bool writeCachedPackets(QSharedPointer<PacketRingBuffer> ringBuffer, AVRational inTimebase);
     void close();
 
 private:
     AVFormatContext *m_oc = nullptr;
     AVStream *m_outStream = nullptr;
     bool m_headerWritten = false;
+    int64_t m_tsOffset = AV_NOPTS_VALUE;    // In the input's time base
+    int64_t m_lastTs = AV_NOPTS_VALUE;
     QString m_path;
 };
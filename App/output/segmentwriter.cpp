@@ -0,0 +1,204 @@
+#include <algorithm>
+
+#include <QFileInfo>
+#include <QLoggingCategory>
+
+#include "segmentwriter.h"
+
+Q_STATIC_LOGGING_CATEGORY(logger, "apss.output.segment_writer")
+
+SegmentWriter::SegmentWriter(const QString &camera, int segmentDuration, const QDir &dir, int fragmentDuration)
+    : m_camera(camera)
+    , m_dir(dir)
+    , m_segmentSeconds(std::max(1, segmentDuration))
+    , m_fragmentMs(std::max(0, fragmentDuration))
+{}
+
+SegmentWriter::~SegmentWriter()
+{
+    close();
+    avcodec_parameters_free(&m_codecpar);
+}
+
+std::optional<RecordingSegment> SegmentWriter::setStream(const AVCodecParameters *codecpar, AVRational timeBase)
+{
+    const bool is_same = m_codecpar
+                         && m_codecpar->codec_id == codecpar->codec_id
+                         && m_codecpar->width == codecpar->width
+                         && m_codecpar->height == codecpar->height
+                         && av_cmp_q(m_timeBase, timeBase) == 0;
+    if (is_same)
+        return std::nullopt;
+
+    std::optional<RecordingSegment> closed = close();
+
+    if (!m_codecpar)
+        m_codecpar = avcodec_parameters_alloc();
+    avcodec_parameters_copy(m_codecpar, codecpar);
+    m_timeBase = timeBase;
+    m_segmentDuration = av_rescale_q(m_segmentSeconds, { 1, 1 }, m_timeBase);
+    m_fragmentDuration = av_rescale_q(m_fragmentMs, { 1, 1000 }, m_timeBase);
+    m_anchorTs = AV_NOPTS_VALUE;
+    m_lastTs = AV_NOPTS_VALUE;
+    m_frameDuration = 0;
+    return closed;
+}
+
+std::optional<RecordingSegment> SegmentWriter::write(SharedPacket pkt)
+{
+    if (!pkt || !m_codecpar)
+        return std::nullopt;
+
+    const int64_t ts = pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+    if (ts == AV_NOPTS_VALUE)
+        return std::nullopt;
+
+    const bool is_key = pkt->flags & AV_PKT_FLAG_KEY;
+    std::optional<RecordingSegment> closed;
+
+    if (m_lastTs != AV_NOPTS_VALUE) {
+        if (ts <= m_lastTs || ts - m_lastTs > m_segmentDuration) {
+            // The stream restarted, or jumped far ahead. Segments can't span it.
+            closed = close();
+            m_anchorTs = AV_NOPTS_VALUE;
+        } else if (pkt->duration <= 0) {
+            m_frameDuration = ts - m_lastTs;
+        }
+    }
+
+    if (pkt->duration > 0)
+        m_frameDuration = pkt->duration;
+    m_lastTs = ts;
+
+    if (m_anchorTs == AV_NOPTS_VALUE) {
+        m_anchorTs = ts;
+        m_anchorTime = QDateTime::currentDateTimeUtc();
+    }
+
+    if (m_remuxer.isOpen() && is_key && ts - m_segmentStartTs >= m_segmentDuration)
+        closed = close();
+
+    if (!m_remuxer.isOpen()) {
+        // Segments start at a keyframe
+        if (!is_key)
+            return closed;
+
+        if (!open(wallTime(ts)))
+            return closed;
+        m_segmentStartTs = ts;
+        m_flushedTs = ts;
+    }
+
+    // Ends the muxer's cluster, a keyframe starts a new one right where a player can start reading
+    const int64_t offset = is_key ? flush(ts) : -1;
+    if (m_remuxer.writePacket(pkt, m_timeBase)) {
+        m_segmentEndTs = ts + m_frameDuration;
+        if (offset >= 0)
+            m_current.keyframes.append(av_rescale_q(ts - m_segmentStartTs, m_timeBase, { 1, 1000 }), offset);
+
+        // A long GOP doesn't keep it off the disk any longer than a fragment
+        if (m_fragmentDuration > 0 && m_segmentEndTs - m_flushedTs >= m_fragmentDuration)
+            flush(m_segmentEndTs);
+    }
+
+    return closed;
+}
+
+std::optional<RecordingSegment> SegmentWriter::close()
+{
+    if (!m_remuxer.isOpen())
+        return std::nullopt;
+
+    m_current.endTime = current()->endTime;
+    m_remuxer.close();
+    m_current.size = QFileInfo(m_current.path).size();
+
+    RecordingSegment closed = m_current;
+    m_current = RecordingSegment();
+    m_segmentStartTs = AV_NOPTS_VALUE;
+    m_segmentEndTs = AV_NOPTS_VALUE;
+    m_flushedTs = AV_NOPTS_VALUE;
+    m_flushedSize = 0;
+    m_hasFragment = false;
+
+    qCDebug(logger) << "Closed segment" << closed.path << "of" << closed.startTime.msecsTo(closed.endTime) << "ms";
+    return closed;
+}
+
+std::optional<RecordingSegment> SegmentWriter::current() const
+{
+    if (!m_remuxer.isOpen())
+        return std::nullopt;
+
+    RecordingSegment segment = m_current;
+    if (m_segmentEndTs != AV_NOPTS_VALUE)
+        segment.endTime = wallTime(m_segmentEndTs);
+    segment.size = m_remuxer.size();
+    return segment;
+}
+
+std::optional<RecordingSegment> SegmentWriter::takeFragment()
+{
+    if (!m_remuxer.isOpen() || !m_hasFragment)
+        return std::nullopt;
+
+    m_hasFragment = false;
+    RecordingSegment segment = m_current;
+    segment.endTime = wallTime(m_flushedTs);
+    segment.size = m_flushedSize;
+
+    // The last keyframe may still be held by the muxer
+    segment.keyframes.clear();
+    for (const auto &keyframe : m_current.keyframes.keyframes()) {
+        if (keyframe.offset < m_flushedSize)
+            segment.keyframes.append(keyframe.time, keyframe.offset);
+    }
+    return segment;
+}
+
+QString SegmentWriter::segmentPath(const QDir &dir, const QString &camera, const QDateTime &startTime)
+{
+    return QString("%1/%2/%3/%4/%5.mkv")
+        .arg(dir.absolutePath(),
+             startTime.toString("yyyy-MM-dd"),
+             startTime.toString("hh"),
+             camera,
+             startTime.toString("mm.ss.zzz"));
+}
+
+bool SegmentWriter::open(const QDateTime &startTime)
+{
+    const QFileInfo file_info(segmentPath(m_dir, m_camera, startTime));
+    file_info.dir().mkpath(".");
+
+    if (!m_remuxer.openOutput(file_info.filePath(), m_codecpar, m_timeBase) || !m_remuxer.writeHeader()) {
+        qCWarning(logger) << "Failed to open segment" << file_info.filePath();
+        m_remuxer.close();
+        return false;
+    }
+
+    m_current = RecordingSegment();
+    m_current.camera = m_camera;
+    m_current.path = file_info.filePath();
+    m_current.startTime = startTime;
+    m_current.endTime = startTime;
+    return true;
+}
+
+int64_t SegmentWriter::flush(int64_t ts)
+{
+    const int64_t offset = m_remuxer.flush();
+    if (offset < 0)
+        return offset;
+
+    if (ts > m_flushedTs)
+        m_hasFragment = true;
+    m_flushedTs = ts;
+    m_flushedSize = offset;
+    return offset;
+}
+
+QDateTime SegmentWriter::wallTime(int64_t ts) const
+{
+    return m_anchorTime.addMSecs(av_rescale_q(ts - m_anchorTs, m_timeBase, { 1, 1000 }));
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <optional>
+
+#include <QDateTime>
+#include <QDir>
+#include <QString>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <output/keyframeindex.h>
+#include <output/remuxer.h>
+
+/**
+ * @brief A closed, or still being written, piece of a camera's continuous recording.
+ */
+struct RecordingSegment {
+    QString camera;
+    QString path;
+    QDateTime startTime;
+    QDateTime endTime;
+    int64_t size = 0;   // Bytes
+    KeyframeIndex keyframes;
+};
+
+/**
+ * @brief Continuous recording of a camera, every packet written once, into fixed-length segments.
+ *
+ * A segment is closed at the first keyframe past its duration, so each one starts with a keyframe
+ * and plays on its own. Its keyframes are indexed as they're written, with the offset in the file
+ * each one starts at. Wall-clock times of the segments follow the stream's timestamps from the
+ * first packet, re-anchored whenever the timestamps jump (a reconnect, a looped file).
+ *
+ * The segment being written is flushed to disk in fragments, a Matroska cluster at every keyframe
+ * and at least every fragment duration. What's on disk always plays up to its last fragment, while
+ * it's still being written or if the process dies before closing it.
+ *
+ * Not thread safe, it's fed by the recordings manager's thread.
+ */
+class SegmentWriter
+{
+public:
+    // Segments go under dir/yyyy-MM-dd/hh/camera/. The fragment duration is in ms.
+    explicit SegmentWriter(const QString &camera, int segmentDuration, const QDir &dir, int fragmentDuration = 1000);
+    ~SegmentWriter();
+
+    // The stream the packets come from, before the first one. Changing it closes the segment being written.
+    std::optional<RecordingSegment> setStream(const AVCodecParameters *codecpar, AVRational timeBase);
+    // The segment this packet closed, if any.
+    std::optional<RecordingSegment> write(SharedPacket pkt);
+    std::optional<RecordingSegment> close();
+    // The one being written, if any
+    std::optional<RecordingSegment> current() const;
+    // The one being written, if more of it was flushed to disk since the last call. It ends, and
+    // its size is, where the file on disk does.
+    std::optional<RecordingSegment> takeFragment();
+
+    static QString segmentPath(const QDir &dir, const QString &camera, const QDateTime &startTime);
+
+private:
+    bool open(const QDateTime &startTime);
+    // Everything written before ts goes out to disk. The offset the next packet starts at, -1 on failure.
+    int64_t flush(int64_t ts);
+    QDateTime wallTime(int64_t ts) const;
+
+private:
+    QString m_camera;
+    QDir m_dir;
+    int m_segmentSeconds = 10;
+    int64_t m_segmentDuration = 0;     // In the stream's time base
+    int m_fragmentMs = 1000;
+    int64_t m_fragmentDuration = 0;    // In the stream's time base
+    AVCodecParameters *m_codecpar = nullptr;
+    AVRational m_timeBase = { 1, AV_TIME_BASE };
+
+    Remuxer m_remuxer;
+    RecordingSegment m_current;
+    int64_t m_segmentStartTs = AV_NOPTS_VALUE;
+    int64_t m_segmentEndTs = AV_NOPTS_VALUE;    // Of the last packet written, plus its duration
+    int64_t m_lastTs = AV_NOPTS_VALUE;          // Of the last packet seen
+    int64_t m_frameDuration = 0;
+    int64_t m_flushedTs = AV_NOPTS_VALUE;       // Everything before it is on disk
+    int64_t m_flushedSize = 0;
+    bool m_hasFragment = false;
+
+    // Wall clock of the stream
+    QDateTime m_anchorTime;
+    int64_t m_anchorTs = AV_NOPTS_VALUE;
+};
@@ -0,0 +1,578 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLoggingCategory>
+#include <QMutexLocker>
+#include <QStorageInfo>
+
+#include <sqlite3.h>
+#include <odb/sqlite/connection.hxx>
+#include <odb/sqlite/traits.hxx>
+#include <odb/sqlite/transaction.hxx>
+
+#include <apss.h>
+#include <db/recording>
+#include "storagemaintainer.h"
+
+Q_STATIC_LOGGING_CATEGORY(logger, "apss.output.storage_maintainer")
+
+namespace {
+
+constexpr qint64 DAY_MS = 24 * 60 * 60 * 1000;
+// Segments younger than this are never expired, an event may still start over them
+constexpr qint64 MIN_SEGMENT_AGE_MS = 10 * 60 * 1000;
+
+void check(int rc, sqlite3 *handle)
+{
+    if (rc != SQLITE_OK && rc != SQLITE_DONE && rc != SQLITE_ROW)
+        throw std::runtime_error(sqlite3_errmsg(handle));
+}
+
+void bindText(sqlite3_stmt *stmt, int indx, const QString &text)
+{
+    const QByteArray utf8 = text.toUtf8();
+    sqlite3_bind_text(stmt, indx, utf8.constData(), utf8.size(), SQLITE_TRANSIENT);
+}
+
+void bindDateTime(sqlite3_stmt *stmt, int indx, qint64 ms)
+{
+    // The Event table is ODB's, its times are text in the Qt profile's format
+    odb::details::buffer buffer;
+    std::size_t size = 0;
+    bool is_null = true;
+    odb::sqlite::value_traits<QDateTime, odb::sqlite::id_text>::set_image(buffer, size, is_null, QDateTime::fromMSecsSinceEpoch(ms, Qt::UTC));
+    sqlite3_bind_text(stmt, indx, buffer.data(), static_cast<int>(size), SQLITE_TRANSIENT);
+}
+
+QDateTime dateTimeColumn(sqlite3_stmt *stmt, int col)
+{
+    QDateTime time;
+    const bool is_null = sqlite3_column_type(stmt, col) == SQLITE_NULL;
+    const int size = sqlite3_column_bytes(stmt, col);
+    odb::details::buffer buffer(std::max(1, size));
+    if (!is_null)
+        std::memcpy(buffer.data(), sqlite3_column_text(stmt, col), size);
+
+    odb::sqlite::value_traits<QDateTime, odb::sqlite::id_text>::set_value(time, buffer, size, is_null);
+    // Stored as UTC, read back without a spec
+    time.setTimeSpec(Qt::UTC);
+    return time;
+}
+
+struct Retention {
+    qint64 record = 0;      // ms every segment is kept for
+    qint64 review = 0;      // ms the segments and clips of an event are kept for, after it ends
+    qint64 preCapture = 0;
+    qint64 postCapture = 0;
+};
+
+Retention retention(const APSSConfig &config, const QString &camera)
+{
+    RecordConfig record;
+    const auto camera_config = config.cameras.find(camera.toStdString());
+    if (camera_config != config.cameras.end() && camera_config->second.record)
+        record = camera_config->second.record.value();
+
+    Retention retention;
+    // Without a motion detector, events are what tell a segment had motion or active objects
+    const RecordRetainConfig retain = record.retain.value_or(RecordRetainConfig());
+    if (retain.mode.value_or(RetainModeEnum::All) == RetainModeEnum::All)
+        retention.record = static_cast<qint64>(retain.days.value_or(0) * DAY_MS);
+
+    for (const auto &events : { record.detections, record.alerts }) {
+        if (!events)
+            continue;
+
+        const ReviewRetainConfig review = events->retain.value_or(ReviewRetainConfig());
+        retention.review = std::max(retention.review, static_cast<qint64>(review.days.value_or(0) * DAY_MS));
+        retention.preCapture = std::max<qint64>(retention.preCapture, events->pre_capture.value_or(0) * 1000);
+        retention.postCapture = std::max<qint64>(retention.postCapture, events->post_capture.value_or(0) * 1000);
+    }
+
+    return retention;
+}
+
+}
+
+StorageMaintainer::StorageMaintainer(std::shared_ptr<odb::database> db,
+                                     const APSSConfig &config,
+                                     QObject *parent)
+    : QThread(parent)
+    , m_db(db)
+    , m_config(config)
+{
+    setObjectName("storage_maintainer");
+
+    const StorageConfig storage = config.storage.value_or(StorageConfig());
+    m_highWater = std::clamp(storage.high_water.value_or(90.0f), 1.0f, 100.0f);
+    m_lowWater = std::clamp(storage.low_water.value_or(85.0f), 0.0f, m_highWater);
+    m_checkInterval = std::max(1, storage.check_interval.value_or(60));
+    m_deleteBatch = std::max(1, storage.delete_batch.value_or(16));
+    m_deleteInterval = std::max(0, storage.delete_interval.value_or(50));
+}
+
+StorageMaintainer::~StorageMaintainer()
+{
+    stop();
+}
+
+void StorageMaintainer::createSchema(odb::database &db)
+{
+    odb::transaction t(db.begin());
+    db.execute("CREATE TABLE IF NOT EXISTS \"StorageFile\" ("
+               "\"id\" INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT,"
+               "\"kind\" INTEGER NOT NULL,"
+               "\"camera\" TEXT NOT NULL,"
+               "\"path\" TEXT NOT NULL UNIQUE,"
+               "\"startTime\" INTEGER NOT NULL,"
+               "\"endTime\" INTEGER NOT NULL,"
+               "\"size\" INTEGER NOT NULL,"
+               "\"retainUntil\" INTEGER NOT NULL DEFAULT 0)");
+    db.execute("CREATE INDEX IF NOT EXISTS \"StorageFile_startTime_i\" ON \"StorageFile\" (\"startTime\")");
+    db.execute("CREATE INDEX IF NOT EXISTS \"StorageFile_camera_i\" ON \"StorageFile\" (\"camera\", \"kind\", \"endTime\")");
+    t.commit();
+}
+
+void StorageMaintainer::stop()
+{
+    try {
+        if (isRunning()) {
+            requestInterruption();
+            {
+                QMutexLocker lock(&m_mtx);
+                m_wake.wakeAll();
+            }
+
+            qCDebug(logger) << "Waiting for" << objectName() << "to exit gracefully...";
+            wait();
+            qCDebug(logger) << objectName() << "thread has exited...";
+        }
+    } catch (const std::exception &e) {
+        qCDebug(logger) << e.what();
+    } catch (...) {
+        qCCritical(logger) << "Uknown/Uncaught exception occurred!";
+    }
+}
+
+void StorageMaintainer::addFile(Kind kind, const QString &camera, const QString &path,
+                                const QDateTime &startTime, const QDateTime &endTime, qint64 size)
+{
+    File file;
+    file.kind = kind;
+    file.camera = camera;
+    file.path = path;
+    file.startTime = startTime.toMSecsSinceEpoch();
+    file.endTime = (endTime.isValid() ? endTime : startTime).toMSecsSinceEpoch();
+    file.size = size;
+    m_pending.push(std::move(file));
+
+    QMutexLocker lock(&m_mtx);
+    m_wake.wakeOne();
+}
+
+void StorageMaintainer::addSegment(const RecordingSegment &segment)
+{
+    Recording recording;
+    recording.setId(QString("%1_%2").arg(segment.camera, segment.startTime.toString(Qt::ISODateWithMs)));
+    recording.setCamera(segment.camera);
+    recording.setPath(segment.path);
+    recording.setStartTime(segment.startTime.toUTC());
+    recording.setEndTime(segment.endTime.toUTC());
+    recording.setDuration(segment.startTime.msecsTo(segment.endTime) / 1000.0f);
+    recording.setSegmentSize(segment.size / (1024.0f * 1024.0f));
+    recording.setKeyframes(segment.keyframes.toByteArray());
+    m_pendingRecordings.push(std::move(recording));
+
+    addFile(Kind::Segment, segment.camera, segment.path, segment.startTime, segment.endTime, segment.size);
+}
+
+void StorageMaintainer::run()
+{
+    qCInfo(logger) << "Starting" << objectName() << "thread";
+
+    try {
+        m_connection = static_cast<odb::sqlite::database &>(*m_db).connection();
+
+        // Started before the event writer, every event of this run starts after it
+        m_runStart = QDateTime::currentMSecsSinceEpoch();
+        try {
+            closeDanglingEvents();
+        } catch (const std::exception &e) {
+            qCCritical(logger) << "Failed closing the events left open," << e.what();
+        }
+
+        QElapsedTimer since_expire;
+        bool has_backlog = false;
+        while (!isInterruptionRequested()) {
+            bool has_more = false;
+            try {
+                insertFiles();
+
+                has_more = relieveDisk();
+                if (!has_more && (has_backlog || !since_expire.isValid() || since_expire.hasExpired(m_checkInterval * 1000LL))) {
+                    since_expire.start();
+                    has_backlog = expire(QDateTime::currentMSecsSinceEpoch());
+                    has_more = has_backlog;
+                }
+            } catch (const std::exception &e) {
+                // Tried again on the next check, a busy database isn't a reason to stop maintaining
+                qCCritical(logger) << e.what();
+                has_backlog = false;
+            }
+
+            // Right after the pause if a batch wasn't enough, or as soon as a file is added
+            QMutexLocker lock(&m_mtx);
+            if (!isInterruptionRequested() && m_pending.empty())
+                m_wake.wait(&m_mtx, has_more ? m_deleteInterval : m_checkInterval * 1000);
+        }
+
+        // Whatever was written last is still indexed, for the next run
+        insertFiles();
+    }
+    catch(const std::exception &e) {
+        qCCritical(logger) << e.what();
+    }
+    catch(...) {
+        qCCritical(logger) << "Uknown/Uncaught exception occurred.";
+    }
+
+    finalizeStatements();
+    m_connection.reset();
+
+    qCInfo(logger) << "Stopping" << objectName() << "thread";
+}
+
+void StorageMaintainer::insertFiles()
+{
+    if (m_pending.empty() && m_pendingRecordings.empty())
+        return;
+
+    if (!m_insertFile) {
+        m_insertFile = prepare("INSERT INTO \"StorageFile\" (\"kind\", \"camera\", \"path\", \"startTime\", \"endTime\", \"size\") "
+                               "VALUES (?, ?, ?, ?, ?, ?) ON CONFLICT(\"path\") DO UPDATE SET "
+                               "\"startTime\" = excluded.\"startTime\", \"endTime\" = excluded.\"endTime\", \"size\" = excluded.\"size\"");
+    }
+
+    sqlite3 *handle = m_connection->handle();
+    odb::transaction t(m_connection->begin());
+
+    File file;
+    while (m_pending.try_pop(file)) {
+        sqlite3_reset(m_insertFile);
+        sqlite3_bind_int(m_insertFile, 1, static_cast<int>(file.kind));
+        bindText(m_insertFile, 2, file.camera);
+        bindText(m_insertFile, 3, file.path);
+        sqlite3_bind_int64(m_insertFile, 4, file.startTime);
+        sqlite3_bind_int64(m_insertFile, 5, file.endTime);
+        sqlite3_bind_int64(m_insertFile, 6, file.size);
+        check(sqlite3_step(m_insertFile), handle);
+    }
+
+    Recording recording;
+    while (m_pendingRecordings.try_pop(recording)) {
+        // A segment written again, after a restart within the same ms, replaces the first
+        try {
+            m_db->persist(recording);
+        } catch (const odb::object_already_persistent &) {
+            m_db->update(recording);
+        }
+    }
+
+    t.commit();
+}
+
+void StorageMaintainer::closeDanglingEvents()
+{
+    // Once per run, the statements aren't kept
+    sqlite3 *handle = m_connection->handle();
+    sqlite3_stmt *select = prepare("SELECT e.\"id\", (SELECT MAX(c.\"endTime\") FROM \"TrackChunk\" AS c WHERE c.\"eventId\" = e.\"id\") "
+                                   "FROM \"Event\" AS e WHERE e.\"endTime\" IS NULL AND e.\"startTime\" < ?");
+    sqlite3_stmt *update = nullptr;
+
+    try {
+        update = prepare("UPDATE \"Event\" SET \"endTime\" = COALESCE(?, \"startTime\") WHERE \"id\" = ?");
+
+        odb::transaction t(m_connection->begin());
+        bindDateTime(select, 1, m_runStart);
+
+        int closed = 0;
+        int rc = SQLITE_OK;
+        while ((rc = sqlite3_step(select)) == SQLITE_ROW) {
+            // At its last prediction, or its start if none was stored
+            const qint64 last = sqlite3_column_int64(select, 1);
+            sqlite3_reset(update);
+            if (last > 0)
+                bindDateTime(update, 1, last);
+            else
+                sqlite3_bind_null(update, 1);
+            sqlite3_bind_int64(update, 2, sqlite3_column_int64(select, 0));
+            check(sqlite3_step(update), handle);
+            ++closed;
+        }
+        check(rc, handle);
+        t.commit();
+
+        if (closed > 0)
+            qCInfo(logger) << "Closed" << closed << "events a previous run left without an end";
+    } catch (...) {
+        sqlite3_finalize(select);
+        sqlite3_finalize(update);
+        throw;
+    }
+
+    sqlite3_finalize(select);
+    sqlite3_finalize(update);
+}
+
+bool StorageMaintainer::relieveDisk()
+{
+    const double usage = diskUsage();
+    if (usage < m_lowWater || (!m_isRelieving && usage < m_highWater)) {
+        m_isRelieving = false;
+        return false;
+    }
+
+    if (!m_isRelieving)
+        qCWarning(logger) << "Recordings disk is" << usage << "% full, deleting the oldest files";
+    m_isRelieving = true;
+
+    if (!m_selectOldest) {
+        m_selectOldest = prepare("SELECT \"id\", \"camera\", \"path\", \"startTime\", \"endTime\" FROM \"StorageFile\" "
+                                 "ORDER BY \"startTime\" LIMIT ?");
+    }
+
+    sqlite3_reset(m_selectOldest);
+    sqlite3_bind_int(m_selectOldest, 1, m_deleteBatch);
+    const std::vector<Candidate> oldest = select(m_selectOldest);
+    if (oldest.empty()) {
+        // Nothing of ours left to delete, something else fills the disk
+        qCWarning(logger) << "Recordings disk is" << usage << "% full, with no recordings left to delete";
+        m_isRelieving = false;
+        return false;
+    }
+
+    remove(oldest);
+    return true;
+}
+
+bool StorageMaintainer::expire(qint64 nowMs)
+{
+    if (!m_selectCameras)
+        m_selectCameras = prepare("SELECT DISTINCT \"camera\" FROM \"StorageFile\"");
+
+    QStringList cameras;
+    sqlite3_reset(m_selectCameras);
+    int rc = SQLITE_OK;
+    while ((rc = sqlite3_step(m_selectCameras)) == SQLITE_ROW)
+        cameras.append(QString::fromUtf8(reinterpret_cast<const char *>(sqlite3_column_text(m_selectCameras, 0))));
+    check(rc, m_connection->handle());
+
+    int budget = m_deleteBatch;
+    bool has_more = false;
+    for (const QString &camera : std::as_const(cameras)) {
+        if (isInterruptionRequested())
+            break;
+        has_more |= expireCamera(camera, nowMs, budget);
+    }
+
+    return has_more;
+}
+
+bool StorageMaintainer::expireCamera(const QString &camera, qint64 nowMs, int &budget)
+{
+    if (budget <= 0)
+        return true;
+
+    if (!m_selectExpiredSegments) {
+        m_selectExpiredSegments = prepare("SELECT \"id\", \"camera\", \"path\", \"startTime\", \"endTime\" FROM \"StorageFile\" "
+                                          "WHERE \"camera\" = ? AND \"kind\" = 0 AND \"endTime\" < ? AND \"retainUntil\" < ? "
+                                          "ORDER BY \"startTime\" LIMIT ?");
+        m_selectExpiredClips = prepare("SELECT \"id\", \"camera\", \"path\", \"startTime\", \"endTime\" FROM \"StorageFile\" "
+                                       "WHERE \"camera\" = ? AND \"kind\" = 1 AND \"endTime\" < ? "
+                                       "ORDER BY \"startTime\" LIMIT ?");
+        m_selectExpiredPreviews = prepare("SELECT p.\"id\", p.\"camera\", p.\"path\", p.\"startTime\", p.\"endTime\" FROM \"StorageFile\" AS p "
+                                          "WHERE p.\"camera\" = ? AND p.\"kind\" IN (2, 3) AND p.\"endTime\" < ? AND NOT EXISTS ("
+                                          "SELECT 1 FROM \"StorageFile\" AS s WHERE s.\"camera\" = p.\"camera\" AND s.\"kind\" = 0 "
+                                          "AND s.\"startTime\" <= p.\"endTime\" AND s.\"endTime\" >= p.\"startTime\") "
+                                          "ORDER BY p.\"startTime\" LIMIT ?");
+    }
+
+    const Retention keep = retention(m_config, camera);
+    const int limit = budget;
+
+    sqlite3_reset(m_selectExpiredSegments);
+    bindText(m_selectExpiredSegments, 1, camera);
+    sqlite3_bind_int64(m_selectExpiredSegments, 2, nowMs - std::max(keep.record, MIN_SEGMENT_AGE_MS));
+    sqlite3_bind_int64(m_selectExpiredSegments, 3, nowMs);
+    sqlite3_bind_int(m_selectExpiredSegments, 4, limit);
+    const std::vector<Candidate> segments = select(m_selectExpiredSegments);
+
+    std::vector<Candidate> expired;
+    for (const Candidate &segment : segments) {
+        // The segments of an event's clip, padded like the clip, are kept as long as the event is
+        const qint64 event_end = latestOverlappingEvent(camera, segment.startTime - keep.postCapture, segment.endTime + keep.preCapture, nowMs);
+        if (event_end > 0 && event_end + keep.review > nowMs)
+            retain(segment.id, event_end + keep.review);
+        else
+            expired.push_back(segment);
+    }
+
+    sqlite3_reset(m_selectExpiredClips);
+    bindText(m_selectExpiredClips, 1, camera);
+    sqlite3_bind_int64(m_selectExpiredClips, 2, nowMs - keep.review);
+    sqlite3_bind_int(m_selectExpiredClips, 3, limit);
+    const std::vector<Candidate> clips = select(m_selectExpiredClips);
+    expired.insert(expired.end(), clips.begin(), clips.end());
+
+    // Nothing left of the footage they preview
+    sqlite3_reset(m_selectExpiredPreviews);
+    bindText(m_selectExpiredPreviews, 1, camera);
+    sqlite3_bind_int64(m_selectExpiredPreviews, 2, nowMs - MIN_SEGMENT_AGE_MS);
+    sqlite3_bind_int(m_selectExpiredPreviews, 3, limit);
+    const std::vector<Candidate> previews = select(m_selectExpiredPreviews);
+    expired.insert(expired.end(), previews.begin(), previews.end());
+
+    if (!expired.empty()) {
+        qCInfo(logger) << "Deleting" << expired.size() << "expired recordings of" << camera;
+        remove(expired);
+    }
+    budget -= static_cast<int>(expired.size());
+
+    return segments.size() == static_cast<size_t>(limit)
+           || clips.size() == static_cast<size_t>(limit)
+           || previews.size() == static_cast<size_t>(limit);
+}
+
+qint64 StorageMaintainer::latestOverlappingEvent(const QString &camera, qint64 startMs, qint64 endMs, qint64 nowMs)
+{
+    if (!m_selectEvent) {
+        // Ongoing events first, their endTime is null. Only the ones of this run are, one left
+        // open before would otherwise keep every later segment forever.
+        m_selectEvent = prepare("SELECT \"endTime\" FROM \"Event\" "
+                                "WHERE \"camera\" = ? AND \"startTime\" <= ? "
+                                "AND ((\"endTime\" IS NULL AND \"startTime\" >= ?) OR \"endTime\" >= ?) "
+                                "ORDER BY \"endTime\" IS NOT NULL, \"endTime\" DESC LIMIT 1");
+    }
+
+    sqlite3_reset(m_selectEvent);
+    bindText(m_selectEvent, 1, camera);
+    bindDateTime(m_selectEvent, 2, endMs);
+    bindDateTime(m_selectEvent, 3, m_runStart);
+    bindDateTime(m_selectEvent, 4, startMs);
+
+    const int rc = sqlite3_step(m_selectEvent);
+    check(rc, m_connection->handle());
+    if (rc != SQLITE_ROW)
+        return 0;
+
+    const QDateTime end = dateTimeColumn(m_selectEvent, 0);
+    return end.isValid() ? end.toMSecsSinceEpoch() : nowMs;
+}
+
+void StorageMaintainer::retain(qint64 id, qint64 untilMs)
+{
+    if (!m_updateRetain)
+        m_updateRetain = prepare("UPDATE \"StorageFile\" SET \"retainUntil\" = ? WHERE \"id\" = ?");
+
+    odb::transaction t(m_connection->begin());
+    sqlite3_reset(m_updateRetain);
+    sqlite3_bind_int64(m_updateRetain, 1, untilMs);
+    sqlite3_bind_int64(m_updateRetain, 2, id);
+    check(sqlite3_step(m_updateRetain), m_connection->handle());
+    t.commit();
+}
+
+void StorageMaintainer::remove(const std::vector<Candidate> &files)
+{
+    if (!m_deleteFile) {
+        m_deleteFile = prepare("DELETE FROM \"StorageFile\" WHERE \"id\" = ?");
+        m_deleteRecording = prepare("DELETE FROM \"Recording\" WHERE \"path\" = ?");
+    }
+
+    // Deleted one at a time, and paced, a big unlink burst stalls the disk the recordings are written to
+    std::vector<qint64> deleted;
+    QStringList paths;
+    for (const Candidate &file : files) {
+        if (isInterruptionRequested())
+            break;
+
+        // Already gone is as good as deleted
+        if (!QFile::remove(file.path) && QFile::exists(file.path)) {
+            qCWarning(logger) << "Failed deleting" << file.path;
+            continue;
+        }
+
+        deleted.push_back(file.id);
+        paths.append(file.path);
+        if (m_deleteInterval > 0)
+            QThread::msleep(m_deleteInterval);
+    }
+
+    if (deleted.empty())
+        return;
+
+    sqlite3 *handle = m_connection->handle();
+    odb::transaction t(m_connection->begin());
+    for (qint64 id : deleted) {
+        sqlite3_reset(m_deleteFile);
+        sqlite3_bind_int64(m_deleteFile, 1, id);
+        check(sqlite3_step(m_deleteFile), handle);
+    }
+    // Clips have none, nothing matches
+    for (const QString &path : std::as_const(paths)) {
+        sqlite3_reset(m_deleteRecording);
+        bindText(m_deleteRecording, 1, path);
+        check(sqlite3_step(m_deleteRecording), handle);
+    }
+    t.commit();
+
+    emit filesDeleted(paths);
+}
+
+std::vector<StorageMaintainer::Candidate> StorageMaintainer::select(sqlite3_stmt *stmt)
+{
+    std::vector<Candidate> rows;
+    int rc = SQLITE_OK;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        Candidate row;
+        row.id = sqlite3_column_int64(stmt, 0);
+        row.camera = QString::fromUtf8(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)));
+        row.path = QString::fromUtf8(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2)));
+        row.startTime = sqlite3_column_int64(stmt, 3);
+        row.endTime = sqlite3_column_int64(stmt, 4);
+        rows.push_back(std::move(row));
+    }
+    check(rc, m_connection->handle());
+
+    return rows;
+}
+
+double StorageMaintainer::diskUsage() const
+{
+    // A statfs() of the volume, nothing is scanned
+    const QStorageInfo storage(RECORD_DIR.absolutePath());
+    if (!storage.isValid() || storage.bytesTotal() <= 0)
+        return 0.0;
+
+    return 100.0 * (storage.bytesTotal() - storage.bytesAvailable()) / storage.bytesTotal();
+}
+
+sqlite3_stmt *StorageMaintainer::prepare(const char *sql)
+{
+    sqlite3 *handle = m_connection->handle();
+    sqlite3_stmt *stmt = nullptr;
+    check(sqlite3_prepare_v3(handle, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr), handle);
+    return stmt;
+}
+
+void StorageMaintainer::finalizeStatements()
+{
+    for (sqlite3_stmt **stmt : { &m_insertFile, &m_selectOldest, &m_selectCameras, &m_selectExpiredSegments, &m_selectExpiredClips,
+                                 &m_selectExpiredPreviews, &m_selectEvent, &m_updateRetain, &m_deleteFile, &m_deleteRecording }) {
+        sqlite3_finalize(*stmt);
+        *stmt = nullptr;
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <QDateTime>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QWaitCondition>
+#include <odb/sqlite/database.hxx>
+
+#include <tbb_patched.h>
+#include <config/apssconfig.h>
+#include <db/recording.h>
+#include <output/segmentwriter.h>
+
+struct sqlite3_stmt;
+
+/**
+ * @brief Keeps the recordings within their retention and the disk under its high-water mark.
+ *
+ * Every file written (segments, exported clips) is registered with its camera, time range and
+ * size in the StorageFile table, and that index is all it ever looks at, the recording dirs are
+ * never scanned. Segments also get their Recording, with their keyframe index, which goes with
+ * the file.
+ *
+ * A segment outlives the camera's record retain days (none, with a Motion or ActiveObjects
+ * mode) only while it overlaps an event within the review retain days. Events a previous run left
+ * without an end (a crash, a lost Finish) are closed at their last prediction when it starts. Clips are only caches
+ * of the events and go with the review retain days, previews with the last segment they cover.
+ * When the disk fills past high_water, the oldest files go first, whatever their retention.
+ *
+ * It runs at the lowest priority and deletes a small batch at a time, pausing between files.
+ */
+class StorageMaintainer : public QThread
+{
+    Q_OBJECT
+public:
+    enum class Kind { Segment = 0, Clip = 1, Preview = 2, Sprite = 3 };
+
+    explicit StorageMaintainer(std::shared_ptr<odb::database> db,
+                               const APSSConfig &config,
+                               QObject *parent = nullptr);
+    ~StorageMaintainer();
+    // The StorageFile table. Idempotent.
+    static void createSchema(odb::database &db);
+    void stop();
+
+    // Registered on the maintainer's thread, never blocks. A file registered again is updated.
+    void addFile(Kind kind, const QString &camera, const QString &path,
+                 const QDateTime &startTime, const QDateTime &endTime, qint64 size);
+    // A closed segment, registered along with its Recording
+    void addSegment(const RecordingSegment &segment);
+
+signals:
+    void filesDeleted(const QStringList &paths);
+
+protected:
+    // QThread interface
+    void run() override;
+
+private:
+    struct File {
+        Kind kind = Kind::Segment;
+        QString camera;
+        QString path;
+        qint64 startTime = 0;   // ms since epoch
+        qint64 endTime = 0;
+        qint64 size = 0;
+    };
+
+    struct Candidate {
+        qint64 id = 0;
+        QString camera;
+        QString path;
+        qint64 startTime = 0;
+        qint64 endTime = 0;
+    };
+
+    void insertFiles();
+    // Of the events started before this run, that never got an end time
+    void closeDanglingEvents();
+    // Each returns true if there's more to delete than a batch.
+    bool relieveDisk();
+    bool expire(qint64 nowMs);
+    bool expireCamera(const QString &camera, qint64 nowMs, int &budget);
+    // End of the latest event overlapping the range, now if one of this run is ongoing, 0 if none.
+    qint64 latestOverlappingEvent(const QString &camera, qint64 startMs, qint64 endMs, qint64 nowMs);
+    void retain(qint64 id, qint64 untilMs);
+    void remove(const std::vector<Candidate> &files);
+    std::vector<Candidate> select(sqlite3_stmt *stmt);
+    double diskUsage() const;
+    sqlite3_stmt *prepare(const char *sql);
+    void finalizeStatements();
+
+private:
+    std::shared_ptr<odb::database> m_db;
+    odb::sqlite::connection_ptr m_connection;
+    const APSSConfig &m_config;
+    tbb::concurrent_queue<File> m_pending;
+    tbb::concurrent_queue<Recording> m_pendingRecordings;
+
+    QMutex m_mtx;
+    QWaitCondition m_wake;
+
+    float m_highWater = 90.0f;
+    float m_lowWater = 85.0f;
+    int m_checkInterval = 60;
+    int m_deleteBatch = 16;
+    int m_deleteInterval = 50;
+    bool m_isRelieving = false;     // Between the high and low water marks. Thread only
+    qint64 m_runStart = 0;          // ms since epoch, events without an end started before it are dangling
+
+    sqlite3_stmt *m_insertFile = nullptr;
+    sqlite3_stmt *m_selectOldest = nullptr;
+    sqlite3_stmt *m_selectCameras = nullptr;
+    sqlite3_stmt *m_selectExpiredSegments = nullptr;
+    sqlite3_stmt *m_selectExpiredClips = nullptr;
+    sqlite3_stmt *m_selectExpiredPreviews = nullptr;
+    sqlite3_stmt *m_selectEvent = nullptr;
+    sqlite3_stmt *m_updateRetain = nullptr;
+    sqlite3_stmt *m_deleteFile = nullptr;
+    sqlite3_stmt *m_deleteRecording = nullptr;
+};
@@ -1,14 +1,11 @@
 #include <algorithm>
+#include <cstdlib>
 #include <exception>
 
 #include <QLoggingCategory>
 #include <qcontainerfwd.h>
 
 #include <opencv2/core.hpp>
-#include <opencv2/imgcodecs.hpp>
-#include <odb/transaction.hxx>
-#include <rfl/json/write.hpp>
-#include <rfl/json.hpp>
 
 #include <apss.h>
 #include <detectors/image.h>
@@ -19,13 +16,35 @@
 Q_STATIC_LOGGING_CATEGORY(logger, "apss.engine.object_proc")
 
 TrackedObjectProcessor::TrackedObjectProcessor(SharedFrameBoundedQueue &frameQueue,
-                                               std::shared_ptr<odb::database> db,
+                                               EventWriter &eventWriter,
+                                               const APSSConfig &config,
+                                               ImageWriter &imageWriter,
+                                               LPRRequestQueue *lprRequestQueue,
+                                               PlateFusionStore *plateFusion,
+                                               EmbeddingRequestQueue *embeddingQueue,
                                                QObject *parent)
     : QThread{parent}
     , m_frameQueue(frameQueue)
-    , m_db(db)
+    , m_eventWriter(eventWriter)
+    , m_imageWriter(imageWriter)
+    , m_lprRequestQueue(lprRequestQueue)
+    , m_plateFusion(plateFusion)
+    , m_embeddingQueue(embeddingQueue)
 {
     setObjectName("tracked_object_processor");
+
+    if (config.lpr) {
+        m_savePlates = config.lpr->save_plates.value_or(true);
+        m_plateCandidates = std::max(1, config.lpr->plate_candidates.value_or(1));
+        m_minPlateArea = config.lpr->min_area;
+        for (const auto &camera : config.lpr->priority_cameras.value_or(std::set<std::string>()))
+            m_lprPriorityCameras.insert(QString::fromStdString(camera));
+    }
+
+    if (config.database) {
+        m_stationaryInterval = std::max(0, config.database->stationary_interval.value_or(0));
+        m_stationaryThreshold = config.database->stationary_threshold.value_or(0.02f);
+    }
 }
 
 void TrackedObjectProcessor::stop()
@@ -67,24 +86,10 @@ void TrackedObjectProcessor::run()
             processFrame(frame, events_history);
             cleanupLostTracks(events_history);
 
-            // draw results
-            PredictionList predictions_ = frame->predictions();
-            cv::Mat frame_mat = frame->data();
-
-            Utils::drawDetections(frame_mat, predictions_, {}, {}, 0.0f);
-            for (const auto &prediction: predictions_) {
-                if (prediction.subPredictions) {
-                    Utils::drawDetections(frame_mat, prediction.subPredictions.value(), {}, {}, 0.0f);
-                }
-            }
-
-            frame->setData(frame_mat);
-
+            // The frame stays untouched, the UI draws the predictions on top of it
             emit frameChanged(frame);
             emit frameChangedWithEvents(frame, events_history.keys());
         }
-
-        finalizeAllEvents(cameras_history);
     }
     catch(const tbb::user_abort &) {}
     catch(const std::exception &e) {
@@ -94,6 +99,9 @@ void TrackedObjectProcessor::run()
         qCCritical(logger) << "Uknown/Uncaught exception occurred in TrackedObjectProcessor.";
     }
 
+    // Also when stopped by aborting the queue, the engine stops the event writer after this returns
+    finalizeAllEvents(cameras_history);
+
     qCInfo(logger) << "Stopping" << objectName() << "thread";
 }
 
@@ -114,9 +122,7 @@ void TrackedObjectProcessor::processFrame(SharedFrame frame, QHash<int, TrackedE
             updateThumbnails(event_history, object, frame);
             processLicensePlates(event_history, object, frame);
 
-            if (!event_history.isPersisted) {
-                odb::transaction t(m_db->begin());
-
+            if (!event_history.ticket.isValid()) {
                 // Event
                 auto &event = event_history.event;
                 event.label = QString::fromStdString(object.className);
@@ -124,31 +130,15 @@ void TrackedObjectProcessor::processFrame(SharedFrame frame, QHash<int, TrackedE
                 event.startTime = frame->timestamp();
                 event.topScore = object.conf;
                 event.trackerId = object.trackerId;
-                event_history.id = m_db->persist(event);
-
-                // NOTE: Only the first prediction will have timestamp. To acheive replayable prediction footage,
-                // we would need to track predictions separately. But that's not my goal and nothing is using the
-                // predictions being submitted to the database, at the moment. So, I won't bother updating them. 
-                // But only submitted at the end.
-                
-                APSS::ODB::Prediction p;
-                p.eventId = event_history.id;
-                p.frameId = frame->id();
-                p.streamTimestamp = frame->timestamp();
-                p.hasSubPredictions = object.subPredictions.has_value();
-                event_history.predictions.emplace_back(p, object);
+                // Written behind, the id is picked up once the writer has committed it
+                event_history.ticket = m_eventWriter.insertEvent(event);
 
-                t.commit();
-
-                event_history.isPersisted = true;
-                emit eventPersisted(event_history.id);
+                addPrediction(event_history, object, frame);
             } else {
                 // Update existing event
-                APSS::ODB::Prediction p;
-                p.eventId = event_history.id;
-                p.frameId = frame->id();
-                p.streamTimestamp = frame->timestamp();
-                event_history.predictions.emplace_back(p, object);
+                resolveEventId(event_history);
+
+                addPrediction(event_history, object, frame);
                 event_history.event.endTime = frame->timestamp();
 
                 if (object.conf > event_history.event.topScore)
@@ -158,6 +148,8 @@ void TrackedObjectProcessor::processFrame(SharedFrame frame, QHash<int, TrackedE
                 event_history.event.score = object.conf;
 
                 // emit eventUpdated(event_history.id);
+
+                requestRecognition(event_history);
             }
         }
     } catch (const std::exception &e) {
@@ -209,11 +201,15 @@ void TrackedObjectProcessor::updateThumbnails(TrackedEvent &eventHistory, const
         best_thumbnail.counter++;
         best_thumbnail.wasSmartCropped = is_smart_croppable;
         eventHistory.lastObjectBoxArea = object.box.area();
+        if (m_embeddingQueue) {
+            const cv::Rect object_rect = object.box & cv::Rect(cv::Point(0, 0), frame_data.size());
+            if (!object_rect.empty())
+                eventHistory.reidCrop = frame_data(object_rect).clone();
+        }
         
         if (is_first_ever)
-            eventHistory.event.thumbnail = THUMB_DIR.filePath(QString("%1_%2.jpg").arg(frame->camera()).arg(object.trackerId));  // Dragons, I KNOW!
-        // TODO: This should be moved to a separate thread.
-        cv::imwrite(eventHistory.event.thumbnail.toStdString(), eventHistory.bestThumbnail.img);
+            eventHistory.event.thumbnail = THUMB_DIR.filePath(QString("%1_%2%3").arg(frame->camera()).arg(object.trackerId).arg(m_imageWriter.extension()));  // Dragons, I KNOW!
+        m_imageWriter.write(eventHistory.event.thumbnail, best_thumbnail.img);
 
         if (eventHistory.isPersisted)
             emit eventUpdated(eventHistory.id, EventThumbnail);
@@ -226,7 +222,7 @@ void TrackedObjectProcessor::processLicensePlates(TrackedEvent& eventHistory, co
         return;
 
     cv::Mat frame_data = frame->data();
-    auto &best_plate = eventHistory.bestPlate;
+    auto &candidates = eventHistory.plateCandidates;
     for (const auto &plate : object.subPredictions.value()) {
         if (plate.className != "license_plate")
             continue;
@@ -240,17 +236,40 @@ void TrackedObjectProcessor::processLicensePlates(TrackedEvent& eventHistory, co
             continue;
         }
 
-        if (best_plate.empty() || plate.box.area() > best_plate.total() * 1.2) {
-            // This would be a single plate anyway. But this check is required for the more than one plate case.
-            Utils::perspectiveCrop(frame_data, best_plate, plate.points);
+        // Both scored on the box's area, so the geometry alone bounds the quality. Only plates
+        // that could make it into the top-K are cropped.
+        const bool is_full = candidates.size() >= m_plateCandidates;
+        const float geometry = PlateFusion::geometryQuality(plate.points, plate.box.area(), m_minPlateArea);
+        if (geometry <= 0.0f || (is_full && geometry <= candidates.back().quality))
+            continue;
 
-            // TODO: This should be moved to a separate thread.
-            if (!best_plate.empty())
-                cv::imwrite(THUMB_DIR.filePath(QString("%1_%2_lp.jpg").arg(frame->camera()).arg(object.trackerId)).toStdString(), eventHistory.bestPlate);
+        // A fresh Mat each time, as a pending background write may still be holding the previous one.
+        cv::Mat plate_crop;
+        Utils::perspectiveCrop(frame_data, plate_crop, plate.points);
+        if (plate_crop.empty())
+            continue;
 
-            if (eventHistory.isPersisted)
-                emit eventUpdated(eventHistory.id, EventPlate);
-        }
+        const float quality = geometry * PlateFusion::sharpness(plate_crop);
+        if (quality <= 0.0f || (is_full && quality <= candidates.back().quality))
+            continue;
+
+        auto pos = std::find_if(candidates.begin(), candidates.end(), [quality](const PlateCandidate &candidate) {
+            return quality > candidate.quality;
+        });
+        const bool is_best = pos == candidates.begin();
+        candidates.insert(pos, PlateCandidate{ plate_crop, plate.box, quality, false });
+        if (candidates.size() > m_plateCandidates)
+            candidates.pop_back();
+
+        if (!is_best)
+            continue;
+
+        // The recognizer gets the plate in memory, the file is only for the UI.
+        if (m_savePlates)
+            m_imageWriter.write(THUMB_DIR.filePath(QString("%1_%2_lp%3").arg(frame->camera()).arg(object.trackerId).arg(m_imageWriter.extension())), plate_crop);
+
+        if (eventHistory.isPersisted)
+            emit eventUpdated(eventHistory.id, EventPlate);
     }
 }
 void TrackedObjectProcessor::cleanupLostTracks(QHash<int, TrackedEvent>& eventsHistory)
@@ -259,26 +278,19 @@ void TrackedObjectProcessor::cleanupLostTracks(QHash<int, TrackedEvent>& eventsH
     try {
         for (auto it = eventsHistory.begin(); it != eventsHistory.end();) {
             if (it->lostCount > TRACK_MAX_EVENTS) {
-                const auto &history = eventsHistory[it.key()];
-
-                // TODO: Persist events if they're not.                
-                APSS::ODB::Event event;
-                odb::transaction t(m_db->begin());
+                auto &history = it.value();
 
-                m_db->load(it->id, event);
-                event.endTime = history.event.endTime;
-                event.topScore = history.event.topScore;
-                event.score = history.event.score;
-                m_db->update(event);
+                resolveEventId(history);
+                m_eventWriter.finishEvent(history.ticket, history.event, std::move(history.predictions));
 
-                for (auto [p, object] : history.predictions) {
-                    p.data = QString::fromStdString(rfl::json::write(object));
-                    m_db->persist(p);
-                }
+                // Last chance for a crop that couldn't be queued earlier
+                requestRecognition(history);
+                if (m_plateFusion && history.isPersisted)
+                    m_plateFusion->close(it->id);
+                requestEmbedding(history);
 
-                t.commit();
-
-                emit eventCompleted(it->id);
+                if (history.isPersisted)
+                    emit eventCompleted(it->id);
                 
                 it = eventsHistory.erase(it);
             } else {
@@ -289,27 +301,125 @@ void TrackedObjectProcessor::cleanupLostTracks(QHash<int, TrackedEvent>& eventsH
         qCCritical(logger) << "Error updating db event," << e.what();
     }
 }
+
+void TrackedObjectProcessor::resolveEventId(TrackedEvent &eventHistory)
+{
+    if (eventHistory.isPersisted || !eventHistory.ticket.isReady())
+        return;
+
+    try {
+        eventHistory.id = eventHistory.ticket.id();
+    } catch (const std::exception &) {
+        // Already logged by the writer, the event is gone. Stop asking.
+        eventHistory.ticket = EventWriter::Ticket();
+        return;
+    }
+
+    eventHistory.isPersisted = true;
+    emit eventPersisted(eventHistory.id);
+}
+
+void TrackedObjectProcessor::addPrediction(TrackedEvent &eventHistory, const Prediction &object, SharedFrame frame)
+{
+    const qint64 now = frame->timestamp().toMSecsSinceEpoch();
+
+    // A parked car would add a prediction every frame for hours. While it sits still, keep one now and then.
+    if (m_stationaryInterval > 0 && !eventHistory.lastSampleBox.empty()
+        && now - eventHistory.lastSampleTime < m_stationaryInterval) {
+        const cv::Rect &last = eventHistory.lastSampleBox;
+        const float tolerance = m_stationaryThreshold * std::max(last.width, last.height);
+        const bool is_stationary = std::abs(object.box.x - last.x) <= tolerance
+                                   && std::abs(object.box.y - last.y) <= tolerance
+                                   && std::abs(object.box.br().x - last.br().x) <= tolerance
+                                   && std::abs(object.box.br().y - last.br().y) <= tolerance;
+        if (is_stationary)
+            return;
+    }
+
+    APSS::ODB::Prediction p;
+    p.frameId = frame->id();
+    p.streamTimestamp = frame->timestamp();
+    p.hasSubPredictions = object.subPredictions.has_value();
+    eventHistory.predictions.emplace_back(p, object);
+    eventHistory.lastSampleTime = now;
+    eventHistory.lastSampleBox = object.box;
+
+    // Streamed to the writer a chunk at a time, the history of a track never grows past one.
+    // Without a ticket the event failed to insert, there's nowhere to put them.
+    if (eventHistory.predictions.size() >= m_eventWriter.trackChunkSize()) {
+        m_eventWriter.appendTrack(eventHistory.ticket, std::move(eventHistory.predictions));
+        eventHistory.predictions = EventWriter::PredictionRows();
+        eventHistory.predictions.reserve(m_eventWriter.trackChunkSize());
+    }
+}
+
+void TrackedObjectProcessor::requestRecognition(TrackedEvent &eventHistory)
+{
+    if (!m_lprRequestQueue || !m_plateFusion || !eventHistory.isPersisted)
+        return;
+
+    if (eventHistory.plateReads >= static_cast<int>(m_plateCandidates) || m_plateFusion->hasConverged(eventHistory.id))
+        return;
+
+    // The best crop that hasn't been read yet, if it's noticeably better than the last one that was.
+    auto candidate = std::find_if(eventHistory.plateCandidates.begin(), eventHistory.plateCandidates.end(), [](const PlateCandidate &c) {
+        return !c.submitted;
+    });
+    if (candidate == eventHistory.plateCandidates.end())
+        return;
+
+    if (eventHistory.plateReads > 0 && candidate->quality < eventHistory.lastReadQuality * (1.0f + LPR_MIN_QUALITY_GAIN))
+        return;
+
+    LPRRequest request;
+    request.eventId = eventHistory.id;
+    request.camera = eventHistory.event.camera;
+    request.trackerId = eventHistory.event.trackerId;
+    request.plate = candidate->img;
+    request.plateBox = candidate->box;
+    request.quality = candidate->quality;
+
+    // Never block tracking on the recognizer
+    m_plateFusion->submitted(eventHistory.id);
+    const bool priority = m_lprPriorityCameras.contains(eventHistory.event.camera);
+    if (!m_lprRequestQueue->tryPush(std::move(request), priority)) {
+        m_plateFusion->skipped(eventHistory.id);
+        qCWarning(logger) << "LPR queue is full, dropping plate of event" << eventHistory.id;
+        return;
+    }
+
+    candidate->submitted = true;
+    eventHistory.plateReads++;
+    eventHistory.lastReadQuality = candidate->quality;
+}
+
+void TrackedObjectProcessor::requestEmbedding(TrackedEvent &eventHistory)
+{
+    if (!m_embeddingQueue || !eventHistory.isPersisted || eventHistory.reidCrop.empty())
+        return;
+
+    EmbeddingRequest request;
+    request.eventId = eventHistory.id;
+    request.camera = eventHistory.event.camera;
+    request.crop = std::move(eventHistory.reidCrop);
+
+    // Re-ID is best effort, never block tracking on it
+    if (!m_embeddingQueue->try_push(std::move(request)))
+        qCWarning(logger) << "Embedding queue is full, event" << eventHistory.id << "won't be re-identifiable";
+}
+
 void TrackedObjectProcessor::finalizeAllEvents(QHash<QString, QHash<int, TrackedEvent>> &camerasHistory)
 {
     // Submit the remaining events
     try {
         for (auto cam = camerasHistory.begin(); cam != camerasHistory.end(); ++cam) {
             for (auto e = cam->begin(); e != cam->end(); ++e) {
-                APSS::ODB::Event event;
-                odb::transaction t(m_db->begin());
-                
-                m_db->load(e->id, event);
-                event.endTime = e->event.endTime;
-                event.topScore = e->event.topScore;
-                event.score = e->event.score;
-                m_db->update(event);
-
-                for (auto [p, object] : e->predictions) {
-                    p.data = QString::fromStdString(rfl::json::write(object));
-                    m_db->persist(p);
-                }
-
-                t.commit();
+                resolveEventId(e.value());
+                m_eventWriter.finishEvent(e->ticket, e->event, std::move(e->predictions));
+
+                if (m_plateFusion && e->isPersisted)
+                    m_plateFusion->close(e->id);
+                requestEmbedding(e.value());
             }
         }
     } catch (const std::exception &e) {
@@ -4,14 +4,20 @@
 #include <vector>
 #include <cstddef>
 
+#include <QSet>
 #include <QThread>
 
-#include <odb/sqlite/database.hxx>
 #include <opencv2/core/mat.hpp>
 #include <opencv2/core/types.hpp>
 
+#include <config/apssconfig.h>
 #include <db/event-odb.hxx>
 #include <db/prediction-odb.hxx>
+#include <detectors/embeddingsmanager.h>
+#include <detectors/lprrequestqueue.h>
+#include <output/eventwriter.h>
+#include <output/imagewriter.h>
+#include <utils/platefusion.h>
 #include <utils/frame.h>
 #include <utils/prediction.h>
 
@@ -29,14 +35,27 @@ public:
         EventData        = 1 << 6
     };
 
+    struct PlateCandidate {
+        cv::Mat img;
+        cv::Rect box;
+        float quality = 0.0f;
+        bool submitted = false;
+    };
+
     struct TrackedEvent {
-        size_t id;
+        size_t id = 0;
         APSS::ODB::Event event;
-        bool isPersisted = false;
+        EventWriter::Ticket ticket;     // Valid once queued for insertion
+        bool isPersisted = false;       // Committed, id is known
         int lostCount = 0;
         int lastObjectBoxArea;
-        cv::Mat bestPlate;
-        std::vector<std::pair<APSS::ODB::Prediction, Prediction>> predictions;
+        std::vector<PlateCandidate> plateCandidates;    // Top-K by quality, best first
+        int plateReads = 0;
+        float lastReadQuality = 0.0f;
+        cv::Mat reidCrop;           // Tight crop of the object from the best thumbnail, for re-ID
+        EventWriter::PredictionRows predictions;     // Not yet flushed to the writer
+        qint64 lastSampleTime = 0;      // Of the last prediction kept, ms
+        cv::Rect lastSampleBox;
 
         struct {
             cv::Mat img;
@@ -46,7 +65,12 @@ public:
     };
 
     explicit TrackedObjectProcessor(SharedFrameBoundedQueue &frameQueue,
-                                    std::shared_ptr<odb::database> db,
+                                    EventWriter &eventWriter,
+                                    const APSSConfig &config,
+                                    ImageWriter &imageWriter,
+                                    LPRRequestQueue *lprRequestQueue = nullptr,
+                                    PlateFusionStore *plateFusion = nullptr,
+                                    EmbeddingRequestQueue *embeddingQueue = nullptr,
                                     QObject *parent = nullptr);
     void stop();
 
@@ -66,10 +90,24 @@ private:
     std::pair<cv::Rect, bool> getSmartCropRect(cv::Rect object, cv::Size frameSize, float aspectRatio = 1.5f);
     void updateThumbnails(TrackedEvent &event, const Prediction& object, SharedFrame frame);
     void processLicensePlates(TrackedEvent& event, const Prediction& object, SharedFrame frame);
+    void resolveEventId(TrackedEvent &eventHistory);
     void cleanupLostTracks(QHash<int, TrackedEvent>& eventsHistory);
+    void addPrediction(TrackedEvent &eventHistory, const Prediction &object, SharedFrame frame);
+    void requestRecognition(TrackedEvent &eventHistory);
+    void requestEmbedding(TrackedEvent &eventHistory);
     void finalizeAllEvents(QHash<QString, QHash<int, TrackedEvent>> &camerasHistory);
 
 private:
     SharedFrameBoundedQueue &m_frameQueue;
-    std::shared_ptr<odb::database> m_db;
+    EventWriter &m_eventWriter;
+    ImageWriter &m_imageWriter;
+    LPRRequestQueue *m_lprRequestQueue = nullptr;
+    PlateFusionStore *m_plateFusion = nullptr;
+    EmbeddingRequestQueue *m_embeddingQueue = nullptr;
+    bool m_savePlates = true;
+    size_t m_plateCandidates = 3;
+    int m_minPlateArea = 0;
+    QSet<QString> m_lprPriorityCameras;
+    int m_stationaryInterval = 0;
+    float m_stationaryThreshold = 0.02f;
 };
@@ -1,7 +1,28 @@
+#include <algorithm>
+#include <cmath>
 #include <optional>
 
+#include <apss.h>
 #include "tracker.h"
 
+namespace {
+
+constexpr int GRID_MAX_CELLS = 64;      // Per side
+
+float iou(float ax1, float ay1, float ax2, float ay2, float bx1, float by1, float bx2, float by2)
+{
+    const float iw = std::min(ax2, bx2) - std::max(ax1, bx1);
+    const float ih = std::min(ay2, by2) - std::max(ay1, by1);
+    if (iw <= 0.0f || ih <= 0.0f)
+        return 0.0f;
+
+    const float inter = iw * ih;
+    const float uni = (ax2 - ax1) * (ay2 - ay1) + (bx2 - bx1) * (by2 - by1) - inter;
+    return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+}
+
 Tracker::Tracker(std::optional<std::set<std::string>> objectsToTrack,
                  float trackThresh,
                  int trackBuffer,
@@ -19,50 +40,105 @@ Tracker::Tracker(std::optional<std::set<std::string>> objectsToTrack,
 
 void Tracker::track(PredictionList &results)
 {
-    std::set<int> filtered_indxs;
-    std::vector<const Prediction*> sel_results;
+    m_selected.clear();
     for (size_t p = 0; p < results.size(); ++p) {
-        if (m_objectsToTrack.contains(results[p].className)) {
-            sel_results.push_back(&results[p]);
-        } else {
-            filtered_indxs.insert(p);
-        }
+        if (m_objectsToTrack.contains(results[p].className))
+            m_selected.push_back(static_cast<int>(p));
+    }
+
+    if (m_selected.empty())
+        return;
+
+    // Store results in a Nx5 matrix, row[xywh + conf]. Reallocated whenever the count changes.
+    m_detections.resize(m_selected.size(), 5);
+    for (size_t i = 0; i < m_selected.size(); ++i) {
+        const Prediction &prediction = results[m_selected[i]];
+        const cv::Rect &box = prediction.box;
+        m_detections(i, 0) = static_cast<float>(box.x);
+        m_detections(i, 1) = static_cast<float>(box.y);
+        m_detections(i, 2) = static_cast<float>(box.width);
+        m_detections(i, 3) = static_cast<float>(box.height);
+        m_detections(i, 4) = prediction.conf;
     }
 
-    if (sel_results.empty())
+    const std::vector<KalmanBBoxTrack> tracks = m_tracker.process_frame_detections(m_detections);
+    assignTrackIds(results, tracks);
+}
+
+void Tracker::assignTrackIds(PredictionList &results, const std::vector<KalmanBBoxTrack> &tracks)
+{
+    const int n = static_cast<int>(m_selected.size());
+    for (int d = 0; d < n; ++d)
+        results[m_selected[d]].trackerId = -1;
+
+    if (tracks.empty())
         return;
 
-    // Store results in a Nx5 matrix, row[xywh + conf]
-    Eigen::MatrixXf e_predictions(sel_results.size(), 5);
-    for (size_t i = 0; i < sel_results.size(); ++i) {
-        const cv::Rect &box = sel_results.at(i)->box;
-        e_predictions.row(i) <<
-            static_cast<float>(box.x),
-            static_cast<float>(box.y),
-            static_cast<float>(box.width),
-            static_cast<float>(box.height), sel_results.at(i)->conf;
+    // An updated track sits right on top of its detection, so instead of the IoU of every track against
+    // every detection, only the detections around the track's center are looked at. The cells are about
+    // the size of an average detection, so the 3x3 cells around a center always hold its detection.
+    float min_x = m_detections.col(0).minCoeff();
+    float min_y = m_detections.col(1).minCoeff();
+    float max_x = (m_detections.col(0) + m_detections.col(2)).maxCoeff();
+    float max_y = (m_detections.col(1) + m_detections.col(3)).maxCoeff();
+
+    float cell = std::max(m_detections.col(2).mean(), m_detections.col(3).mean());
+    cell = std::max({ cell, (max_x - min_x) / GRID_MAX_CELLS, (max_y - min_y) / GRID_MAX_CELLS, 1.0f });
+
+    const int cols = static_cast<int>((max_x - min_x) / cell) + 1;
+    const int rows = static_cast<int>((max_y - min_y) / cell) + 1;
+
+    const auto cellOf = [&](float x, float y, int &cx, int &cy) {
+        cx = std::clamp(static_cast<int>((x - min_x) / cell), 0, cols - 1);
+        cy = std::clamp(static_cast<int>((y - min_y) / cell), 0, rows - 1);
+    };
+
+    m_cellHeads.assign(static_cast<size_t>(cols) * rows, -1);
+    m_cellNext.assign(n, -1);
+    m_assigned.assign(n, false);
+
+    for (int d = 0; d < n; ++d) {
+        int cx, cy;
+        cellOf(m_detections(d, 0) + m_detections(d, 2) * 0.5f, m_detections(d, 1) + m_detections(d, 3) * 0.5f, cx, cy);
+        const int c = cy * cols + cx;
+        m_cellNext[d] = m_cellHeads[c];
+        m_cellHeads[c] = d;
     }
 
-    // Boxes in eigen matrix, in top-left bottom-right format
-    Eigen::MatrixXf e_tlbr_boxes(sel_results.size(), 4);
-    e_tlbr_boxes << e_predictions.col(0), e_predictions.col(1),
-        e_predictions.col(0) + e_predictions.col(2),
-        e_predictions.col(1) + e_predictions.col(3);
+    for (const auto &track : tracks) {
+        const auto tlbr = track.tlbr();
+        const float tx1 = static_cast<float>(tlbr(0));
+        const float ty1 = static_cast<float>(tlbr(1));
+        const float tx2 = static_cast<float>(tlbr(2));
+        const float ty2 = static_cast<float>(tlbr(3));
+
+        int cx, cy;
+        cellOf((tx1 + tx2) * 0.5f, (ty1 + ty2) * 0.5f, cx, cy);
 
-    // Some tracking results
-    std::vector<KalmanBBoxTrack> tracks = m_tracker.process_frame_detections(e_predictions);
+        int best = -1;
+        float best_iou = TRACKER_MIN_MATCH_IOU;
+        for (int y = std::max(0, cy - 1); y <= std::min(rows - 1, cy + 1); ++y) {
+            for (int x = std::max(0, cx - 1); x <= std::min(cols - 1, cx + 1); ++x) {
+                for (int d = m_cellHeads[y * cols + x]; d >= 0; d = m_cellNext[d]) {
+                    if (m_assigned[d])
+                        continue;
 
-    // TODO: find a better approah for this.
-    // we filter objects, store the filtered indexes, and re-assign track ids in the same sequence as predictions
-    std::vector<int> track_ids = match_detections_with_tracks(e_tlbr_boxes.cast<double>(), tracks);
-    // std::vector<int> track_results(results.size(), -1);
+                    const float dx1 = m_detections(d, 0);
+                    const float dy1 = m_detections(d, 1);
+                    const float overlap = iou(tx1, ty1, tx2, ty2, dx1, dy1, dx1 + m_detections(d, 2), dy1 + m_detections(d, 3));
+                    if (overlap > best_iou) {
+                        best_iou = overlap;
+                        best = d;
+                    }
+                }
+            }
+        }
 
-    for (size_t i = 0, j = 0; i < results.size(); ++i) {
-        if (filtered_indxs.contains(i))
+        if (best < 0)
             continue;
 
-        results[i].trackerId = track_ids.at(j++);
-        // track_results[i] = track_ids[j++];
+        m_assigned[best] = true;
+        results[m_selected[best]].trackerId = track.track_id;
     }
 }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include <BYTETracker.h>
 
 #include "utils/prediction.h"
@@ -21,6 +23,10 @@ public:
     float matchThresh() const;
     int videoFrameRate() const;
 
+private:
+    // Maps every track back to the detection it was updated with, -1 for the unmatched ones.
+    void assignTrackIds(PredictionList &results, const std::vector<KalmanBBoxTrack> &tracks);
+
 private:
     BYTETracker m_tracker;
     const float m_trackThresh = 0.25;
@@ -28,4 +34,13 @@ private:
     const float m_matchThresh = 0.8;
     const int m_videoFrameRate = 30;
     std::set<std::string> m_objectsToTrack = DEFAULT_TRACKED_OBJECTS;
+
+    // Kept across frames, a tracker is per camera and so are these. The vectors keep their capacity,
+    // the matrix doesn't: ByteTrackEigen takes an exact Nx5 MatrixXf, a block of a bigger one would
+    // be copied into a temporary anyway.
+    Eigen::MatrixXf m_detections;       // Nx5, row[xywh + conf]
+    std::vector<int> m_selected;        // Index in the results, of each row of m_detections
+    std::vector<bool> m_assigned;
+    std::vector<int> m_cellHeads;       // Grid hash over the detection centers, first detection of each cell
+    std::vector<int> m_cellNext;        // Next detection in the same cell
 };
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Burkhard-Keller tree over strings, answers "keys within distance k" without
+ * comparing against every key.
+ *
+ * Distance must be a metric (i.e. Levenshtein). Nodes live in a single vector, so building
+ * a tree of a few hundred thousand keys is a handful of allocations and the tree can be
+ * shared read-only between threads once built.
+ */
+template <typename T, typename Distance = int (*)(const std::string &, const std::string &)>
+class BKTree
+{
+public:
+    struct Match {
+        const std::string *key;
+        const T *value;
+        int distance;
+    };
+
+    explicit BKTree(Distance distance) : m_distance(distance) {}
+
+    void reserve(size_t size) { m_nodes.reserve(size); }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    // Values inserted with an existing key are kept alongside the previous ones.
+    void insert(std::string key, T value)
+    {
+        m_size++;
+        if (m_nodes.empty()) {
+            m_nodes.push_back({ std::move(key), { std::move(value) }, {} });
+            return;
+        }
+
+        uint32_t indx = 0;
+        while (true) {
+            const int dist = m_distance(key, m_nodes[indx].key);
+            if (dist == 0) {
+                m_nodes[indx].values.emplace_back(std::move(value));
+                return;
+            }
+
+            const auto &children = m_nodes[indx].children;
+            const auto child = std::find_if(children.begin(), children.end(), [dist](const auto &c) {
+                return c.first == dist;
+            });
+
+            if (child == children.end()) {
+                const uint32_t new_indx = static_cast<uint32_t>(m_nodes.size());
+                m_nodes[indx].children.emplace_back(dist, new_indx);
+                m_nodes.push_back({ std::move(key), { std::move(value) }, {} });
+                return;
+            }
+
+            indx = child->second;
+        }
+    }
+
+    // fn(const std::string &key, const T &value, int distance) for every value within maxDistance
+    template <typename Fn>
+    void search(const std::string &key, int maxDistance, Fn &&fn) const
+    {
+        if (m_nodes.empty())
+            return;
+
+        std::vector<uint32_t> stack = { 0 };
+        while (!stack.empty()) {
+            const Node &node = m_nodes[stack.back()];
+            stack.pop_back();
+
+            const int dist = m_distance(key, node.key);
+            if (dist <= maxDistance) {
+                for (const auto &value : node.values)
+                    fn(node.key, value, dist);
+            }
+
+            // Triangle inequality, only the children in [dist - k, dist + k] can hold a match.
+            for (const auto &[child_dist, child_indx] : node.children) {
+                if (child_dist >= dist - maxDistance && child_dist <= dist + maxDistance)
+                    stack.emplace_back(child_indx);
+            }
+        }
+    }
+
+    // Closest first
+    std::vector<Match> find(const std::string &key, int maxDistance) const
+    {
+        std::vector<Match> matches;
+        search(key, maxDistance, [&matches](const std::string &k, const T &v, int dist) {
+            matches.push_back({ &k, &v, dist });
+        });
+
+        std::stable_sort(matches.begin(), matches.end(), [](const Match &a, const Match &b) {
+            return a.distance < b.distance;
+        });
+
+        return matches;
+    }
+
+private:
+    struct Node {
+        std::string key;
+        std::vector<T> values;
+        std::vector<std::pair<int, uint32_t>> children;     // (distance to this node, node index)
+    };
+
+    Distance m_distance;
+    std::vector<Node> m_nodes;
+    size_t m_size = 0;
+};
@@ -0,0 +1,144 @@
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QTextStream>
+#include <QThreadPool>
+
+#include <utils/platefusion.h>
+#include "knownplates.h"
+
+Q_STATIC_LOGGING_CATEGORY(logger, "apss.utils.known_plates")
+
+KnownPlatesIndex::KnownPlatesIndex()
+    : m_tree(&PlateFusion::editDistance)
+{}
+
+void KnownPlatesIndex::add(const std::map<std::string, std::vector<std::string>> &knownPlates)
+{
+    for (const auto &[label, plates] : knownPlates) {
+        for (const auto &plate : plates)
+            add(plate, label);
+    }
+}
+
+size_t KnownPlatesIndex::addCsv(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qCWarning(logger) << "Couldn't open known plates file" << path << file.errorString();
+        return 0;
+    }
+
+    size_t count = 0;
+    QTextStream stream(&file);
+    QString line;
+    while (stream.readLineInto(&line)) {
+        const QStringView trimmed = QStringView(line).trimmed();
+        if (trimmed.isEmpty() || trimmed.startsWith(u'#'))
+            continue;
+
+        const qsizetype comma = trimmed.indexOf(u',');
+        const QStringView plate = comma < 0 ? trimmed : trimmed.left(comma).trimmed();
+        const QStringView label = comma < 0 ? QStringView() : trimmed.mid(comma + 1).trimmed();
+        add(plate.toString().toStdString(), label.toString().toStdString());
+        count++;
+    }
+
+    return count;
+}
+
+void KnownPlatesIndex::add(const std::string &plate, const std::string &label)
+{
+    std::string normalized = PlateFusion::normalize(plate);
+    if (normalized.empty())
+        return;
+
+    m_tree.insert(std::move(normalized), label);
+}
+
+std::vector<KnownPlateMatch> KnownPlatesIndex::match(const std::string &plate, int maxDistance) const
+{
+    std::vector<KnownPlateMatch> matches;
+    const std::string normalized = PlateFusion::normalize(plate);
+    if (normalized.empty())
+        return matches;
+
+    for (const auto &m : m_tree.find(normalized, std::max(0, maxDistance)))
+        matches.push_back({ *m.key, *m.value, m.distance });
+
+    return matches;
+}
+
+std::optional<KnownPlateMatch> KnownPlatesIndex::bestMatch(const std::string &plate, int maxDistance) const
+{
+    auto matches = match(plate, maxDistance);
+    if (matches.empty())
+        return std::nullopt;
+
+    return matches.front();
+}
+
+size_t KnownPlatesIndex::size() const
+{
+    return m_tree.size();
+}
+
+KnownPlates::KnownPlates(QObject *parent)
+    : QObject{parent}
+    , m_state(std::make_shared<State>())
+{
+    m_state->index.store(std::make_shared<const KnownPlatesIndex>());
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &KnownPlates::onFileChanged);
+}
+
+void KnownPlates::load(const LicensePlateConfig &config)
+{
+    m_configPlates = config.known_plates.value_or(std::map<std::string, std::vector<std::string>>());
+    m_filePath = config.known_plates_file ? QString::fromStdString(config.known_plates_file.value()) : QString();
+
+    if (!m_watcher.files().isEmpty())
+        m_watcher.removePaths(m_watcher.files());
+
+    // The first one is built right away, detection shouldn't start with an empty watchlist.
+    m_state->index.store(build(m_configPlates, m_filePath));
+
+    if (!m_filePath.isEmpty())
+        m_watcher.addPath(m_filePath);
+}
+
+std::shared_ptr<const KnownPlatesIndex> KnownPlates::index() const
+{
+    return m_state->index.load();
+}
+
+void KnownPlates::onFileChanged(const QString &path)
+{
+    // Editors usually replace the file instead of writing to it, which drops the watch.
+    if (!m_watcher.files().contains(path) && QFileInfo::exists(path))
+        m_watcher.addPath(path);
+
+    // Bursts of changes are coalesced into a single rebuild
+    if (m_state->rebuildPending.exchange(true))
+        return;
+
+    QThreadPool::globalInstance()->start([state = m_state, config_plates = m_configPlates, file_path = m_filePath]() {
+        state->rebuildPending = false;
+        state->index.store(build(config_plates, file_path));
+    });
+}
+
+std::shared_ptr<const KnownPlatesIndex> KnownPlates::build(const std::map<std::string, std::vector<std::string>> &configPlates,
+                                                           const QString &filePath)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    auto index = std::make_shared<KnownPlatesIndex>();
+    index->add(configPlates);
+    if (!filePath.isEmpty())
+        index->addCsv(filePath);
+
+    qCInfo(logger) << "Indexed" << index->size() << "known plates in" << timer.elapsed() << "ms";
+    return index;
+}
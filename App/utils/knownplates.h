@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QString>
+
+#include <config/licenseplateconfig.h>
+#include <utils/bktree.h>
+
+struct KnownPlateMatch {
+    std::string plate;
+    std::string label;
+    int distance = 0;
+};
+
+/**
+ * @brief Immutable fuzzy index over a watchlist. Built once, then shared read-only by the
+ * LPR workers until a newer one replaces it.
+ */
+class KnownPlatesIndex
+{
+public:
+    explicit KnownPlatesIndex();
+    // label -> plates, as in LicensePlateConfig::known_plates
+    void add(const std::map<std::string, std::vector<std::string>> &knownPlates);
+    // One "plate,label" per line, lines starting with # are ignored. Returns the plates read.
+    size_t addCsv(const QString &path);
+    void add(const std::string &plate, const std::string &label);
+    // Closest first, empty if nothing is within maxDistance.
+    std::vector<KnownPlateMatch> match(const std::string &plate, int maxDistance) const;
+    std::optional<KnownPlateMatch> bestMatch(const std::string &plate, int maxDistance) const;
+    size_t size() const;
+
+private:
+    BKTree<std::string> m_tree;
+};
+
+/**
+ * @brief Holds the current KnownPlatesIndex and rebuilds it in the background whenever
+ * known_plates_file changes on disk. Readers never wait on a rebuild.
+ */
+class KnownPlates : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KnownPlates(QObject *parent = nullptr);
+    void load(const LicensePlateConfig &config);
+    std::shared_ptr<const KnownPlatesIndex> index() const;
+
+private slots:
+    void onFileChanged(const QString &path);
+
+private:
+    // Shared with the background rebuilds, so they may safely outlive this object.
+    struct State {
+        std::atomic<std::shared_ptr<const KnownPlatesIndex>> index;
+        std::atomic_bool rebuildPending = false;
+    };
+
+    static std::shared_ptr<const KnownPlatesIndex> build(const std::map<std::string, std::vector<std::string>> &configPlates,
+                                                         const QString &filePath);
+
+private:
+    std::map<std::string, std::vector<std::string>> m_configPlates;
+    QString m_filePath;
+    QFileSystemWatcher m_watcher;
+    std::shared_ptr<State> m_state;
+};
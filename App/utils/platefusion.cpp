@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <map>
+#include <numeric>
+
+#include <QMutexLocker>
+
+#include <opencv2/imgproc.hpp>
+
+#include "platefusion.h"
+
+namespace {
+
+constexpr float SHARPNESS_REFERENCE = 100.0f;  // Laplacian variance at which sharpness is 0.5
+constexpr int   SHARPNESS_MAX_WIDTH = 128;      // Plates are downscaled to this width before measuring
+
+float edgeRatio(float a, float b)
+{
+    const float longest = std::max(a, b);
+    return longest > 0.0f ? std::min(a, b) / longest : 0.0f;
+}
+
+}
+
+float PlateFusion::geometryQuality(const std::vector<cv::Point3f> &points, int area, int minArea)
+{
+    if (area < minArea || area <= 0)
+        return 0.0f;
+
+    // A plate about 4x min_area is considered big enough to read reliably.
+    const float size = std::min(1.0f, static_cast<float>(area) / (4.0f * std::max(1, minArea)));
+
+    // tl, tr, br, bl as per the pose model
+    if (points.size() != 4)
+        return size * 0.5f;
+
+    const auto dist = [](const cv::Point3f &a, const cv::Point3f &b) {
+        return std::hypot(a.x - b.x, a.y - b.y);
+    };
+
+    const float w_top = dist(points[0], points[1]);
+    const float w_bot = dist(points[3], points[2]);
+    const float h_left = dist(points[0], points[3]);
+    const float h_right = dist(points[1], points[2]);
+    const float geometry = edgeRatio(w_top, w_bot) * edgeRatio(h_left, h_right);
+
+    float keypoints_conf = 0.0f;
+    for (const auto &p : points)
+        keypoints_conf += p.z;
+    keypoints_conf /= points.size();
+
+    return size * geometry * std::clamp(keypoints_conf, 0.0f, 1.0f);
+}
+
+float PlateFusion::quality(const cv::Mat &plate, const std::vector<cv::Point3f> &points, int minArea)
+{
+    if (plate.empty())
+        return 0.0f;
+
+    const float geometry = geometryQuality(points, plate.cols * plate.rows, minArea);
+    if (geometry <= 0.0f)
+        return 0.0f;
+
+    return geometry * sharpness(plate);
+}
+
+float PlateFusion::sharpness(const cv::Mat &plate)
+{
+    if (plate.empty())
+        return 0.0f;
+
+    cv::Mat gray;
+    if (plate.channels() == 1)
+        gray = plate;
+    else
+        cv::cvtColor(plate, gray, cv::COLOR_BGR2GRAY);
+
+    if (gray.cols > SHARPNESS_MAX_WIDTH) {
+        const double scale = static_cast<double>(SHARPNESS_MAX_WIDTH) / gray.cols;
+        cv::resize(gray, gray, cv::Size(), scale, scale, cv::INTER_AREA);
+    }
+
+    cv::Mat laplacian;
+    cv::Laplacian(gray, laplacian, CV_32F);
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(laplacian, mean, stddev);
+    const float variance = static_cast<float>(stddev[0] * stddev[0]);
+    return variance / (variance + SHARPNESS_REFERENCE);
+}
+
+std::string PlateFusion::normalize(const std::string &text)
+{
+    std::string normalized;
+    normalized.reserve(text.size());
+    for (unsigned char c : text) {
+        if (std::isalnum(c))
+            normalized.push_back(static_cast<char>(std::toupper(c)));
+    }
+
+    return normalized;
+}
+
+int PlateFusion::editDistance(const std::string &a, const std::string &b)
+{
+    std::vector<int> prev(b.size() + 1), curr(b.size() + 1);
+    std::iota(prev.begin(), prev.end(), 0);
+
+    for (size_t i = 1; i <= a.size(); ++i) {
+        curr[0] = static_cast<int>(i);
+        for (size_t j = 1; j <= b.size(); ++j) {
+            const int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+            curr[j] = std::min({ prev[j] + 1, curr[j - 1] + 1, prev[j - 1] + cost });
+        }
+        std::swap(prev, curr);
+    }
+
+    return prev[b.size()];
+}
+
+FusedPlate PlateFusion::fuse(const std::vector<PlateReading> &readings, int matchDistance)
+{
+    FusedPlate fused;
+    fused.readings = readings;
+
+    if (readings.empty())
+        return fused;
+
+    // Anchor, the reading most others agree with
+    size_t anchor = 0;
+    float anchor_support = -1.0f;
+    for (size_t i = 0; i < readings.size(); ++i) {
+        float support = 0.0f;
+        for (const auto &other : readings) {
+            if (editDistance(readings[i].text, other.text) <= matchDistance)
+                support += other.score;
+        }
+
+        if (support > anchor_support
+            || (support == anchor_support && readings[i].score > readings[anchor].score)) {
+            anchor = i;
+            anchor_support = support;
+        }
+    }
+
+    std::vector<const PlateReading *> cluster;
+    for (const auto &reading : readings) {
+        if (editDistance(readings[anchor].text, reading.text) <= matchDistance)
+            cluster.emplace_back(&reading);
+    }
+
+    // Length
+    std::map<size_t, float> length_votes;
+    for (const auto *reading : cluster)
+        length_votes[reading->text.size()] += reading->score;
+
+    const size_t length = std::max_element(length_votes.begin(), length_votes.end(), [](const auto &a, const auto &b) {
+        return a.second < b.second;
+    })->first;
+
+    // Characters, only the readings of the voted length can be aligned position by position
+    fused.text.resize(length);
+    fused.score = length > 0 ? 1.0f : 0.0f;
+    for (size_t p = 0; p < length; ++p) {
+        std::map<char, float> votes;
+        float total = 0.0f;
+        for (const auto *reading : cluster) {
+            if (reading->text.size() != length)
+                continue;
+
+            votes[reading->text[p]] += reading->score;
+            total += reading->score;
+        }
+
+        const auto best = std::max_element(votes.begin(), votes.end(), [](const auto &a, const auto &b) {
+            return a.second < b.second;
+        });
+        fused.text[p] = best->first;
+
+        // Agreeing readings are taken as independent evidence
+        float miss = 1.0f;
+        for (const auto *reading : cluster) {
+            if (reading->text.size() == length && reading->text[p] == best->first)
+                miss *= 1.0f - std::clamp(reading->score, 0.0f, 1.0f);
+        }
+
+        const float agreement = total > 0.0f ? best->second / total : 0.0f;
+        fused.score = std::min(fused.score, agreement * (1.0f - miss));
+    }
+
+    fused.reads = static_cast<int>(cluster.size());
+    return fused;
+}
+
+void PlateFusionStore::configure(const LicensePlateConfig &config)
+{
+    QMutexLocker lock(&m_mtx);
+    m_matchDistance = std::max(0, config.match_distance);
+    m_minPlateLength = std::max(1, config.min_plate_length);
+    m_convergenceThreshold = config.recognition_threshold;
+}
+
+void PlateFusionStore::submitted(size_t eventId)
+{
+    QMutexLocker lock(&m_mtx);
+    m_entries[eventId].pending++;
+}
+
+void PlateFusionStore::skipped(size_t eventId)
+{
+    QMutexLocker lock(&m_mtx);
+    auto it = m_entries.find(eventId);
+    if (it == m_entries.end())
+        return;
+
+    it->pending = std::max(0, it->pending - 1);
+    releaseIfDone(eventId);
+}
+
+FusedPlate PlateFusionStore::addReading(size_t eventId, PlateReading reading)
+{
+    QMutexLocker lock(&m_mtx);
+    auto &entry = m_entries[eventId];
+    entry.pending = std::max(0, entry.pending - 1);
+
+    reading.text = PlateFusion::normalize(reading.text);
+    if (static_cast<int>(reading.text.size()) >= m_minPlateLength) {
+        entry.readings.emplace_back(std::move(reading));
+        entry.fused = PlateFusion::fuse(entry.readings, m_matchDistance);
+    }
+
+    const FusedPlate fused = entry.fused;
+    releaseIfDone(eventId);
+    return fused;
+}
+
+bool PlateFusionStore::hasConverged(size_t eventId) const
+{
+    QMutexLocker lock(&m_mtx);
+    const auto it = m_entries.constFind(eventId);
+    return it != m_entries.cend()
+           && !it->fused.text.empty()
+           && it->fused.score >= m_convergenceThreshold;
+}
+
+std::optional<FusedPlate> PlateFusionStore::fused(size_t eventId) const
+{
+    QMutexLocker lock(&m_mtx);
+    const auto it = m_entries.constFind(eventId);
+    if (it == m_entries.cend())
+        return std::nullopt;
+
+    return it->fused;
+}
+
+void PlateFusionStore::close(size_t eventId)
+{
+    QMutexLocker lock(&m_mtx);
+    auto it = m_entries.find(eventId);
+    if (it == m_entries.end())
+        return;
+
+    it->closed = true;
+    releaseIfDone(eventId);
+}
+
+void PlateFusionStore::releaseIfDone(size_t eventId)
+{
+    const auto it = m_entries.find(eventId);
+    if (it != m_entries.end() && it->closed && it->pending == 0)
+        m_entries.erase(it);
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <QHash>
+#include <QMutex>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+
+#include <config/licenseplateconfig.h>
+
+/**
+ * @brief A single OCR reading of one plate crop.
+ */
+struct PlateReading {
+    std::string text;
+    float score = 0.0f;     // Recognizer confidence
+    float quality = 0.0f;   // Quality of the crop it was read from
+};
+
+/**
+ * @brief The result of voting over all the readings of a track. This is what ends up in
+ * Event::licensePlateResults.
+ */
+struct FusedPlate {
+    std::string text;
+    float score = 0.0f;
+    int reads = 0;          // Readings that agreed with the result (within match_distance)
+    std::vector<PlateReading> readings;
+};
+
+namespace PlateFusion {
+
+/**
+ * @brief Cheap [0, 1] score of how readable a rectified plate crop is.
+ *
+ * The product of the sharpness (variance of the Laplacian), the keypoint geometry (opposite
+ * edges of a frontal plate have about the same length) and the size relative to minArea.
+ * Crops smaller than minArea always score 0.
+ */
+float quality(const cv::Mat &plate, const std::vector<cv::Point3f> &points, int minArea);
+// The parts of quality(), it's their product. sharpness() is below 1, so the geometry of an
+// area bounds the quality scored on that same area.
+float geometryQuality(const std::vector<cv::Point3f> &points, int area, int minArea);
+float sharpness(const cv::Mat &plate);
+// Upper-case alphanumerics only, i.e. what a plate could actually contain.
+std::string normalize(const std::string &text);
+int editDistance(const std::string &a, const std::string &b);
+/**
+ * @brief Character-level voting over the readings.
+ *
+ * Readings are clustered around the one with the most support within matchDistance, the
+ * length is voted on and then every position on its own. A position's confidence grows with
+ * agreeing readings and shrinks with disagreeing ones, the weakest position is the score.
+ */
+FusedPlate fuse(const std::vector<PlateReading> &readings, int matchDistance);
+
+}
+
+/**
+ * @brief Readings of the tracks that are currently being recognized, shared by the
+ * TrackedObjectProcessor (which decides what to send) and the LPR workers (which read them).
+ *
+ * An entry is dropped once its track is closed and none of its plates are still queued.
+ */
+class PlateFusionStore
+{
+public:
+    explicit PlateFusionStore() = default;
+    void configure(const LicensePlateConfig &config);
+    // A plate of the event has been queued for recognition.
+    void submitted(size_t eventId);
+    // A queued plate wasn't read, i.e. the event had already converged.
+    void skipped(size_t eventId);
+    FusedPlate addReading(size_t eventId, PlateReading reading);
+    bool hasConverged(size_t eventId) const;
+    std::optional<FusedPlate> fused(size_t eventId) const;
+    // The track is gone, no more plates will be submitted for it.
+    void close(size_t eventId);
+
+private:
+    struct Entry {
+        std::vector<PlateReading> readings;
+        FusedPlate fused;
+        int pending = 0;
+        bool closed = false;
+    };
+
+    void releaseIfDone(size_t eventId);
+
+private:
+    mutable QMutex m_mtx;
+    QHash<size_t, Entry> m_entries;
+    int m_matchDistance = 1;
+    int m_minPlateLength = 4;
+    float m_convergenceThreshold = 0.9f;
+};
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include <QMutexLocker>
+
+#include <opencv2/imgproc.hpp>
+
+#include "recentplatecache.h"
+
+namespace {
+
+constexpr float MAX_CENTER_SHIFT = 0.5f;    // Of the plate's width
+constexpr float MAX_AREA_RATIO = 2.0f;
+constexpr double HIT_RATE_ALPHA = 0.05;
+
+}
+
+RecentPlateCache::RecentPlateCache(int ttlMs, int maxHammingDistance, size_t maxPerCamera)
+    : m_ttlMs(ttlMs)
+    , m_maxHammingDistance(maxHammingDistance)
+    , m_maxPerCamera(std::max<size_t>(1, maxPerCamera))
+{}
+
+uint64_t RecentPlateCache::dHash(const cv::Mat &plate)
+{
+    if (plate.empty())
+        return 0;
+
+    cv::Mat gray, small;
+    if (plate.channels() == 1)
+        gray = plate;
+    else
+        cv::cvtColor(plate, gray, cv::COLOR_BGR2GRAY);
+
+    cv::resize(gray, small, cv::Size(9, 8), 0, 0, cv::INTER_AREA);
+
+    uint64_t hash = 0;
+    for (int y = 0; y < 8; ++y) {
+        const uchar *row = small.ptr<uchar>(y);
+        for (int x = 0; x < 8; ++x)
+            hash = (hash << 1) | (row[x] < row[x + 1] ? 1 : 0);
+    }
+
+    return hash;
+}
+
+int RecentPlateCache::hammingDistance(uint64_t a, uint64_t b)
+{
+    return std::popcount(a ^ b);
+}
+
+std::optional<FusedPlate> RecentPlateCache::find(const QString &camera, size_t eventId, uint64_t hash, const cv::Rect &box, qint64 nowMs)
+{
+    QMutexLocker lock(&m_mtx);
+    std::optional<FusedPlate> plate;
+
+    auto it = m_entries.find(camera);
+    if (it != m_entries.end()) {
+        expire(*it, nowMs);
+        for (const auto &entry : std::as_const(*it)) {
+            if (entry.eventId != eventId && matches(entry, hash, box)) {
+                plate = entry.plate;
+                break;
+            }
+        }
+    }
+
+    // Exponential moving average over the plates looked up for this camera
+    double &rate = m_hitRates[camera];
+    rate = (1.0 - HIT_RATE_ALPHA) * rate + HIT_RATE_ALPHA * (plate ? 1.0 : 0.0);
+
+    return plate;
+}
+
+double RecentPlateCache::hitRate(const QString &camera) const
+{
+    QMutexLocker lock(&m_mtx);
+    return m_hitRates.value(camera, 0.0);
+}
+
+void RecentPlateCache::insert(const QString &camera, size_t eventId, uint64_t hash, const cv::Rect &box, const FusedPlate &plate, qint64 nowMs)
+{
+    if (plate.text.empty())
+        return;
+
+    QMutexLocker lock(&m_mtx);
+    auto &entries = m_entries[camera];
+    expire(entries, nowMs);
+
+    auto entry = std::find_if(entries.begin(), entries.end(), [&](const Entry &e) {
+        return matches(e, hash, box);
+    });
+
+    if (entry != entries.end()) {
+        // Keep the better result, but the latest look of the plate
+        if (plate.score >= entry->plate.score)
+            entry->plate = plate;
+        entry->eventId = eventId;
+        entry->hash = hash;
+        entry->box = box;
+        entry->expiresAt = nowMs + m_ttlMs;
+        return;
+    }
+
+    entries.push_back({ eventId, hash, box, plate, nowMs + m_ttlMs });
+    if (entries.size() > m_maxPerCamera)
+        entries.pop_front();
+}
+
+bool RecentPlateCache::matches(const Entry &entry, uint64_t hash, const cv::Rect &box) const
+{
+    if (hammingDistance(entry.hash, hash) > m_maxHammingDistance)
+        return false;
+
+    const cv::Point2f a = (entry.box.tl() + entry.box.br()) * 0.5;
+    const cv::Point2f b = (box.tl() + box.br()) * 0.5;
+    const float max_shift = MAX_CENTER_SHIFT * std::max(entry.box.width, box.width);
+    if (std::hypot(a.x - b.x, a.y - b.y) > max_shift)
+        return false;
+
+    const float area_a = std::max(1, entry.box.area());
+    const float area_b = std::max(1, box.area());
+    return std::max(area_a, area_b) / std::min(area_a, area_b) <= MAX_AREA_RATIO;
+}
+
+void RecentPlateCache::expire(std::deque<Entry> &entries, qint64 nowMs)
+{
+    std::erase_if(entries, [nowMs](const Entry &entry) {
+        return entry.expiresAt <= nowMs;
+    });
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+
+#include <utils/platefusion.h>
+
+/**
+ * @brief Short-lived, per-camera memory of recently recognized plates.
+ *
+ * A vehicle idling at a gate keeps getting new tracker ids after occlusions. Its plate looks
+ * the same and sits at the same spot, so a crop whose perceptual hash and location match a
+ * recent one reuses that reading instead of going through OCR again.
+ */
+class RecentPlateCache
+{
+public:
+    explicit RecentPlateCache(int ttlMs = 30000, int maxHammingDistance = 6, size_t maxPerCamera = 32);
+    // 64-bit difference hash of the crop, robust to small changes in exposure and scale.
+    static uint64_t dHash(const cv::Mat &plate);
+    static int hammingDistance(uint64_t a, uint64_t b);
+
+    // Only plates of other events are returned, a track's own readings are already in its fusion.
+    std::optional<FusedPlate> find(const QString &camera, size_t eventId, uint64_t hash, const cv::Rect &box, qint64 nowMs);
+    // Moving average of find() hits for the camera
+    double hitRate(const QString &camera) const;
+    // Adds or refreshes the entry matching hash and box.
+    void insert(const QString &camera, size_t eventId, uint64_t hash, const cv::Rect &box, const FusedPlate &plate, qint64 nowMs);
+
+private:
+    struct Entry {
+        size_t eventId = 0;
+        uint64_t hash = 0;
+        cv::Rect box;
+        FusedPlate plate;
+        qint64 expiresAt = 0;
+    };
+
+    bool matches(const Entry &entry, uint64_t hash, const cv::Rect &box) const;
+    void expire(std::deque<Entry> &entries, qint64 nowMs);
+
+private:
+    mutable QMutex m_mtx;
+    QHash<QString, std::deque<Entry>> m_entries;
+    QHash<QString, double> m_hitRates;
+    int m_ttlMs;
+    int m_maxHammingDistance;
+    size_t m_maxPerCamera;
+};
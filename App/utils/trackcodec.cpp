@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#include "trackcodec.h"
+
+namespace {
+
+constexpr char MAGIC[4] = { 'A', 'T', 'R', 'K' };
+constexpr uint8_t VERSION = 1;
+constexpr float POINT_SCALE = 4.0f;     // Keypoints at 1/4 px
+
+enum SampleFlags : uint8_t {
+    HasPoints           = 1 << 0,
+    HasSubPredictions   = 1 << 1,
+    HasDeltas           = 1 << 2
+};
+
+class Writer
+{
+public:
+    explicit Writer(std::vector<uint8_t> &out)
+        : m_out(out)
+    {}
+
+    void byte(uint8_t value) {
+        m_out.push_back(value);
+    }
+
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            m_out.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        m_out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void svarint(int64_t value) {
+        varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    void bytes(const void *data, size_t size) {
+        const auto *begin = static_cast<const uint8_t *>(data);
+        m_out.insert(m_out.end(), begin, begin + size);
+    }
+
+    void conf(float value) {
+        byte(static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f)));
+    }
+
+private:
+    std::vector<uint8_t> &m_out;
+};
+
+class Reader
+{
+public:
+    Reader(const uint8_t *data, size_t size)
+        : m_data(data)
+        , m_end(data + size)
+    {}
+
+    bool ok() const {
+        return m_ok;
+    }
+
+    size_t remaining() const {
+        return static_cast<size_t>(m_end - m_data);
+    }
+
+    uint8_t byte() {
+        if (m_data >= m_end) {
+            m_ok = false;
+            return 0;
+        }
+        return *m_data++;
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const uint8_t b = byte();
+            value |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return value;
+        }
+        m_ok = false;
+        return 0;
+    }
+
+    int64_t svarint() {
+        const uint64_t value = varint();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    bool bytes(void *out, size_t size) {
+        if (static_cast<size_t>(m_end - m_data) < size) {
+            m_ok = false;
+            return false;
+        }
+        std::memcpy(out, m_data, size);
+        m_data += size;
+        return true;
+    }
+
+    float conf() {
+        return byte() / 255.0f;
+    }
+
+private:
+    const uint8_t *m_data;
+    const uint8_t *m_end;
+    bool m_ok = true;
+};
+
+struct ClassTable {
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> indxs;
+
+    void add(const Prediction &prediction) {
+        if (indxs.try_emplace(prediction.className, static_cast<uint32_t>(names.size())).second)
+            names.push_back(prediction.className);
+
+        if (prediction.subPredictions) {
+            for (const auto &sub : prediction.subPredictions.value())
+                add(sub);
+        }
+    }
+};
+
+void writePoints(Writer &w, const std::vector<cv::Point3f> &points, const cv::Rect &box)
+{
+    w.varint(points.size());
+    for (const auto &point : points) {
+        w.svarint(std::lround((point.x - box.x) * POINT_SCALE));
+        w.svarint(std::lround((point.y - box.y) * POINT_SCALE));
+        w.conf(point.z);
+    }
+}
+
+void readPoints(Reader &r, std::vector<cv::Point3f> &points, const cv::Rect &box)
+{
+    const uint64_t count = r.varint();
+    for (uint64_t i = 0; i < count && r.ok(); ++i) {
+        const float x = box.x + r.svarint() / POINT_SCALE;
+        const float y = box.y + r.svarint() / POINT_SCALE;
+        points.emplace_back(x, y, r.conf());
+    }
+}
+
+void writeSub(Writer &w, const Prediction &sub, const Prediction &parent, const ClassTable &classes)
+{
+    w.varint(classes.indxs.at(sub.className));
+    w.svarint(sub.classId);
+    w.svarint(sub.trackerId);
+    w.svarint(sub.box.x - parent.box.x);
+    w.svarint(sub.box.y - parent.box.y);
+    w.svarint(sub.box.width);
+    w.svarint(sub.box.height);
+    w.conf(sub.conf);
+    writePoints(w, sub.points, sub.box);
+}
+
+bool readSub(Reader &r, Prediction &sub, const Prediction &parent, const std::vector<std::string> &classes)
+{
+    const uint64_t class_indx = r.varint();
+    if (class_indx >= classes.size())
+        return false;
+
+    sub.className = classes[class_indx];
+    sub.classId = static_cast<int>(r.svarint());
+    sub.trackerId = r.svarint();
+    sub.box.x = parent.box.x + static_cast<int>(r.svarint());
+    sub.box.y = parent.box.y + static_cast<int>(r.svarint());
+    sub.box.width = static_cast<int>(r.svarint());
+    sub.box.height = static_cast<int>(r.svarint());
+    sub.conf = r.conf();
+    readPoints(r, sub.points, sub.box);
+    return r.ok();
+}
+
+}
+
+std::vector<uint8_t> TrackCodec::encode(const std::vector<TrackSample> &samples)
+{
+    std::vector<uint8_t> out;
+    out.reserve(16 + samples.size() * 12);
+    Writer w(out);
+
+    ClassTable classes;
+    for (const auto &sample : samples)
+        classes.add(sample.prediction);
+
+    w.bytes(MAGIC, sizeof(MAGIC));
+    w.byte(VERSION);
+    w.varint(classes.names.size());
+    for (const auto &name : classes.names) {
+        w.varint(name.size());
+        w.bytes(name.data(), name.size());
+    }
+
+    w.varint(samples.size());
+    if (samples.empty())
+        return out;
+
+    w.svarint(samples.front().timestamp);
+
+    // Everything is relative to the previous sample, starting from nothing
+    TrackSample prev;
+    prev.timestamp = samples.front().timestamp;
+    prev.prediction.box = cv::Rect();
+    prev.prediction.trackerId = 0;
+    prev.prediction.classId = 0;
+
+    for (const auto &sample : samples) {
+        const Prediction &p = sample.prediction;
+        const bool has_subs = p.subPredictions && !p.subPredictions->empty();
+
+        uint8_t flags = 0;
+        flags |= p.points.empty() ? 0 : HasPoints;
+        flags |= has_subs ? HasSubPredictions : 0;
+        flags |= p.hasDeltas ? HasDeltas : 0;
+
+        w.svarint(sample.timestamp - prev.timestamp);
+        w.byte(flags);
+        w.varint(classes.indxs.at(p.className));
+        w.svarint(static_cast<int64_t>(p.classId) - prev.prediction.classId);
+        w.svarint(p.trackerId - prev.prediction.trackerId);
+        w.svarint(p.box.x - prev.prediction.box.x);
+        w.svarint(p.box.y - prev.prediction.box.y);
+        w.svarint(p.box.width - prev.prediction.box.width);
+        w.svarint(p.box.height - prev.prediction.box.height);
+        w.conf(p.conf);
+
+        if (flags & HasPoints)
+            writePoints(w, p.points, p.box);
+
+        if (has_subs) {
+            w.varint(p.subPredictions->size());
+            for (const auto &sub : p.subPredictions.value())
+                writeSub(w, sub, p, classes);
+        }
+
+        prev.timestamp = sample.timestamp;
+        prev.prediction.box = p.box;
+        prev.prediction.trackerId = p.trackerId;
+        prev.prediction.classId = p.classId;
+    }
+
+    return out;
+}
+
+std::optional<std::vector<TrackSample>> TrackCodec::decode(const uint8_t *data, size_t size)
+{
+    Reader r(data, size);
+
+    char magic[sizeof(MAGIC)];
+    if (!r.bytes(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+        return std::nullopt;
+
+    if (r.byte() != VERSION)
+        return std::nullopt;
+
+    // Nothing is allocated for counts the data can't hold, a name takes a byte at least
+    const uint64_t class_count = r.varint();
+    if (!r.ok() || class_count > r.remaining())
+        return std::nullopt;
+
+    std::vector<std::string> classes(class_count);
+    for (auto &name : classes) {
+        const uint64_t length = r.varint();
+        if (!r.ok() || length > r.remaining())
+            return std::nullopt;
+
+        name.resize(length);
+        if (!r.bytes(name.data(), name.size()))
+            return std::nullopt;
+    }
+
+    const uint64_t count = r.varint();
+    if (!r.ok())
+        return std::nullopt;
+
+    std::vector<TrackSample> samples;
+    if (count == 0)
+        return samples;
+
+    // Every sample takes several bytes, don't trust a count the data can't hold
+    samples.reserve(std::min<uint64_t>(count, size));
+
+    TrackSample prev;
+    prev.timestamp = r.svarint();
+    prev.prediction.box = cv::Rect();
+    prev.prediction.trackerId = 0;
+    prev.prediction.classId = 0;
+
+    for (uint64_t i = 0; i < count && r.ok(); ++i) {
+        TrackSample sample;
+        Prediction &p = sample.prediction;
+
+        sample.timestamp = prev.timestamp + r.svarint();
+        const uint8_t flags = r.byte();
+        const uint64_t class_indx = r.varint();
+        if (class_indx >= classes.size())
+            return std::nullopt;
+
+        p.className = classes[class_indx];
+        p.classId = static_cast<int>(prev.prediction.classId + r.svarint());
+        p.trackerId = prev.prediction.trackerId + r.svarint();
+        p.box.x = prev.prediction.box.x + static_cast<int>(r.svarint());
+        p.box.y = prev.prediction.box.y + static_cast<int>(r.svarint());
+        p.box.width = prev.prediction.box.width + static_cast<int>(r.svarint());
+        p.box.height = prev.prediction.box.height + static_cast<int>(r.svarint());
+        p.conf = r.conf();
+        p.hasDeltas = flags & HasDeltas;
+
+        if (flags & HasPoints)
+            readPoints(r, p.points, p.box);
+
+        if (flags & HasSubPredictions) {
+            const uint64_t sub_count = r.varint();
+            std::vector<Prediction> subs;
+            for (uint64_t s = 0; s < sub_count && r.ok(); ++s) {
+                Prediction sub;
+                if (!readSub(r, sub, p, classes))
+                    return std::nullopt;
+                subs.emplace_back(std::move(sub));
+            }
+            p.subPredictions = std::move(subs);
+        }
+
+        prev.timestamp = sample.timestamp;
+        prev.prediction.box = p.box;
+        prev.prediction.trackerId = p.trackerId;
+        prev.prediction.classId = p.classId;
+        samples.emplace_back(std::move(sample));
+    }
+
+    if (!r.ok() || samples.size() != count)
+        return std::nullopt;
+
+    return samples;
+}
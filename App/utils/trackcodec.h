@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <utils/prediction.h>
+
+/**
+ * @brief One prediction of a track, as stored in the event's history.
+ */
+struct TrackSample {
+    int64_t timestamp = 0;      // Milliseconds since epoch
+    Prediction prediction;
+};
+
+/**
+ * @brief Compact, binary encoding of a track's history, one self-contained chunk at a time.
+ *
+ * Samples are delta-encoded against the previous one of the chunk, as zigzag varints: time,
+ * box and tracker id. Keypoints are stored relative to their box at 1/4 px, confidences as a
+ * byte, and class names once per chunk. Sub-predictions are stored relative to their parent.
+ *
+ * Lossy only in the confidences and keypoint coordinates, boxes are kept to the pixel.
+ */
+namespace TrackCodec {
+
+std::vector<uint8_t> encode(const std::vector<TrackSample> &samples);
+// Empty if the data isn't a chunk, or is truncated.
+std::optional<std::vector<TrackSample>> decode(const uint8_t *data, size_t size);
+
+}
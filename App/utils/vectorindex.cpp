@@ -0,0 +1,402 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <random>
+
+#include <Eigen/Dense>
+
+#include "vectorindex.h"
+
+namespace {
+
+using RowMatrix = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+using ConstMatrixMap = Eigen::Map<const RowMatrix>;
+using ConstVectorMap = Eigen::Map<const Eigen::VectorXf>;
+
+constexpr char     INDEX_MAGIC[8] = { 'A', 'P', 'S', 'S', 'V', 'I', 'X', '1' };
+constexpr uint32_t INDEX_VERSION = 1;
+constexpr size_t   ASSIGN_BLOCK_ROWS = 4096;
+
+void normalizeInto(const float *src, float *dst, int dims)
+{
+    Eigen::Map<Eigen::VectorXf> out(dst, dims);
+    out = ConstVectorMap(src, dims);
+    const float norm = out.norm();
+    if (norm > 0.0f)
+        out /= norm;
+}
+
+std::vector<VectorIndex::Hit> topK(std::vector<VectorIndex::Hit> &candidates, size_t k)
+{
+    const auto better = [](const VectorIndex::Hit &a, const VectorIndex::Hit &b) {
+        return a.score > b.score;
+    };
+
+    if (candidates.size() > k) {
+        std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(), better);
+        candidates.resize(k);
+    } else {
+        std::sort(candidates.begin(), candidates.end(), better);
+    }
+
+    return std::move(candidates);
+}
+
+template <typename T>
+void writeRaw(std::ofstream &out, const T *data, size_t count)
+{
+    out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(sizeof(T) * count));
+}
+
+template <typename T>
+bool readRaw(std::ifstream &in, T *data, size_t count)
+{
+    in.read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(sizeof(T) * count));
+    return static_cast<bool>(in);
+}
+
+}
+
+VectorIndex::VectorIndex(int dims)
+    : m_dims(dims)
+{}
+
+int VectorIndex::dims() const
+{
+    std::shared_lock lock(m_mtx);
+    return m_dims;
+}
+
+size_t VectorIndex::size() const
+{
+    std::shared_lock lock(m_mtx);
+    return m_ids.size();
+}
+
+bool VectorIndex::isTrained() const
+{
+    std::shared_lock lock(m_mtx);
+    return m_lists > 0;
+}
+
+void VectorIndex::add(uint64_t id, uint32_t group, const float *vector)
+{
+    std::unique_lock lock(m_mtx);
+    if (m_dims <= 0)
+        return;
+
+    uint32_t row;
+    const auto existing = m_rows.find(id);
+    if (existing != m_rows.end()) {
+        row = existing->second;
+        m_groups[row] = group;
+
+        if (m_lists > 0) {
+            auto &bucket = m_buckets[m_assignments[row]];
+            bucket.erase(std::remove(bucket.begin(), bucket.end(), row), bucket.end());
+        }
+    } else {
+        row = static_cast<uint32_t>(m_ids.size());
+        m_ids.push_back(id);
+        m_groups.push_back(group);
+        m_vectors.resize(m_vectors.size() + m_dims);
+        m_assignments.push_back(0);
+        m_rows.emplace(id, row);
+    }
+
+    normalizeInto(vector, m_vectors.data() + static_cast<size_t>(row) * m_dims, m_dims);
+
+    if (m_lists > 0)
+        assignToList(row);
+}
+
+bool VectorIndex::contains(uint64_t id) const
+{
+    std::shared_lock lock(m_mtx);
+    return m_rows.contains(id);
+}
+
+std::vector<float> VectorIndex::vector(uint64_t id) const
+{
+    std::shared_lock lock(m_mtx);
+    const auto it = m_rows.find(id);
+    if (it == m_rows.end())
+        return {};
+
+    const float *begin = m_vectors.data() + static_cast<size_t>(it->second) * m_dims;
+    return std::vector<float>(begin, begin + m_dims);
+}
+
+uint32_t VectorIndex::group(uint64_t id) const
+{
+    std::shared_lock lock(m_mtx);
+    const auto it = m_rows.find(id);
+    return it == m_rows.end() ? 0 : m_groups[it->second];
+}
+
+std::vector<VectorIndex::Hit> VectorIndex::search(const float *query, size_t k, int probes,
+                                                  std::optional<uint32_t> excludeGroup, float minScore) const
+{
+    std::shared_lock lock(m_mtx);
+    std::vector<Hit> candidates;
+    if (m_ids.empty() || m_dims <= 0 || k == 0)
+        return candidates;
+
+    Eigen::VectorXf q(m_dims);
+    normalizeInto(query, q.data(), m_dims);
+
+    const ConstMatrixMap vectors(m_vectors.data(), static_cast<Eigen::Index>(m_ids.size()), m_dims);
+    const auto consider = [&](uint32_t row, float score) {
+        if (score < minScore || (excludeGroup && m_groups[row] == excludeGroup.value()))
+            return;
+        candidates.push_back({ m_ids[row], score });
+    };
+
+    if (m_lists <= 0) {
+        // Flat, a single GEMV over everything
+        const Eigen::VectorXf scores = vectors * q;
+        candidates.reserve(std::min<size_t>(m_ids.size(), k * 4));
+        for (Eigen::Index r = 0; r < scores.size(); ++r)
+            consider(static_cast<uint32_t>(r), scores[r]);
+
+        return topK(candidates, k);
+    }
+
+    // IVF, only the buckets of the closest centroids
+    const ConstMatrixMap centroids(m_centroids.data(), m_lists, m_dims);
+    const Eigen::VectorXf centroid_scores = centroids * q;
+
+    std::vector<int> order(m_lists);
+    std::iota(order.begin(), order.end(), 0);
+    const int n_probes = std::clamp(probes, 1, m_lists);
+    std::partial_sort(order.begin(), order.begin() + n_probes, order.end(), [&](int a, int b) {
+        return centroid_scores[a] > centroid_scores[b];
+    });
+
+    for (int p = 0; p < n_probes; ++p) {
+        for (uint32_t row : m_buckets[order[p]])
+            consider(row, vectors.row(row).dot(q));
+    }
+
+    return topK(candidates, k);
+}
+
+void VectorIndex::train(int lists, int iterations, size_t maxSamples)
+{
+    // Sample under the shared lock, searches and adds carry on while k-means runs.
+    RowMatrix samples;
+    int dims;
+    {
+        std::shared_lock lock(m_mtx);
+        dims = m_dims;
+        const size_t n = m_ids.size();
+        if (n == 0 || dims <= 0 || lists <= 0)
+            return;
+
+        const size_t n_samples = maxSamples > 0 ? std::min(n, maxSamples) : n;
+        const double stride = static_cast<double>(n) / n_samples;
+        samples.resize(static_cast<Eigen::Index>(n_samples), dims);
+        for (size_t s = 0; s < n_samples; ++s) {
+            const size_t row = static_cast<size_t>(s * stride);
+            samples.row(s) = ConstVectorMap(m_vectors.data() + row * dims, dims).transpose();
+        }
+    }
+
+    // Spherical k-means, the vectors are normalized so the closest centroid is the highest dot product.
+    const int n_lists = std::min<int>(lists, static_cast<int>(samples.rows()));
+    std::mt19937 rng(42);
+    std::vector<Eigen::Index> seeds(samples.rows());
+    std::iota(seeds.begin(), seeds.end(), 0);
+    std::shuffle(seeds.begin(), seeds.end(), rng);
+
+    RowMatrix centroids(n_lists, dims);
+    for (int c = 0; c < n_lists; ++c)
+        centroids.row(c) = samples.row(seeds[c]);
+
+    std::vector<int> labels(samples.rows(), 0);
+    for (int it = 0; it < std::max(1, iterations); ++it) {
+        const RowMatrix scores = samples * centroids.transpose();
+        for (Eigen::Index s = 0; s < samples.rows(); ++s)
+            scores.row(s).maxCoeff(&labels[s]);
+
+        RowMatrix sums = RowMatrix::Zero(n_lists, dims);
+        std::vector<int> counts(n_lists, 0);
+        for (Eigen::Index s = 0; s < samples.rows(); ++s) {
+            sums.row(labels[s]) += samples.row(s);
+            counts[labels[s]]++;
+        }
+
+        for (int c = 0; c < n_lists; ++c) {
+            if (counts[c] == 0) {
+                centroids.row(c) = samples.row(seeds[rng() % seeds.size()]);
+                continue;
+            }
+
+            const float norm = sums.row(c).norm();
+            if (norm > 0.0f)
+                centroids.row(c) = sums.row(c) / norm;
+        }
+    }
+
+    std::unique_lock lock(m_mtx);
+    m_lists = n_lists;
+    m_centroids.assign(centroids.data(), centroids.data() + centroids.size());
+    m_buckets.assign(m_lists, {});
+    m_assignments.assign(m_ids.size(), 0);
+
+    // Bucket everything, a block of rows at a time
+    const ConstMatrixMap centroids_map(m_centroids.data(), m_lists, m_dims);
+    const ConstMatrixMap vectors(m_vectors.data(), static_cast<Eigen::Index>(m_ids.size()), m_dims);
+    for (size_t begin = 0; begin < m_ids.size(); begin += ASSIGN_BLOCK_ROWS) {
+        const Eigen::Index rows = static_cast<Eigen::Index>(std::min(ASSIGN_BLOCK_ROWS, m_ids.size() - begin));
+        const RowMatrix scores = vectors.middleRows(begin, rows) * centroids_map.transpose();
+        for (Eigen::Index r = 0; r < rows; ++r) {
+            int label = 0;
+            scores.row(r).maxCoeff(&label);
+            const uint32_t row = static_cast<uint32_t>(begin + r);
+            m_assignments[row] = static_cast<uint32_t>(label);
+            m_buckets[label].push_back(row);
+        }
+    }
+}
+
+void VectorIndex::reset(int dims)
+{
+    std::unique_lock lock(m_mtx);
+    m_dims = std::max(0, dims);
+    m_ids.clear();
+    m_groups.clear();
+    m_vectors.clear();
+    m_rows.clear();
+    m_lists = 0;
+    m_centroids.clear();
+    m_assignments.clear();
+    m_buckets.clear();
+}
+
+bool VectorIndex::save(const std::string &path) const
+{
+    std::shared_lock lock(m_mtx);
+
+    // Written aside and swapped in, a crash mid-write never leaves a broken index behind.
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+
+        const int32_t dims = m_dims;
+        const uint64_t count = m_ids.size();
+        const int32_t lists = m_lists;
+
+        writeRaw(out, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        writeRaw(out, &INDEX_VERSION, 1);
+        writeRaw(out, &dims, 1);
+        writeRaw(out, &count, 1);
+        writeRaw(out, &lists, 1);
+        writeRaw(out, m_ids.data(), m_ids.size());
+        writeRaw(out, m_groups.data(), m_groups.size());
+        writeRaw(out, m_vectors.data(), m_vectors.size());
+        if (m_lists > 0) {
+            writeRaw(out, m_centroids.data(), m_centroids.size());
+            writeRaw(out, m_assignments.data(), m_assignments.size());
+        }
+
+        if (!out)
+            return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    return !ec;
+}
+
+bool VectorIndex::load(const std::string &path, int expectedDims)
+{
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+        return false;
+    const std::streamoff file_size = in.tellg();
+    in.seekg(0);
+
+    char magic[sizeof(INDEX_MAGIC)];
+    uint32_t version = 0;
+    int32_t dims = 0, lists = 0;
+    uint64_t count = 0;
+    if (!readRaw(in, magic, sizeof(magic)) || std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0
+        || !readRaw(in, &version, 1) || version != INDEX_VERSION
+        || !readRaw(in, &dims, 1) || !readRaw(in, &count, 1) || !readRaw(in, &lists, 1)
+        || dims <= 0 || lists < 0 || (expectedDims > 0 && dims != expectedDims)) {
+        return false;
+    }
+
+    // Checked before anything is allocated, a corrupt count would otherwise ask for gigabytes.
+    // Divided rather than multiplied, so a huge one can't overflow past the check.
+    const uint64_t remaining = static_cast<uint64_t>(file_size - in.tellg());
+    const uint64_t vector_bytes = static_cast<uint64_t>(dims) * sizeof(float);
+    const uint64_t row_bytes = sizeof(uint64_t) + sizeof(uint32_t) + vector_bytes + (lists > 0 ? sizeof(uint32_t) : 0);
+    if (static_cast<uint64_t>(lists) > remaining / vector_bytes)
+        return false;
+    const uint64_t rows_bytes = remaining - static_cast<uint64_t>(lists) * vector_bytes;
+    if (count > rows_bytes / row_bytes || count * row_bytes != rows_bytes
+        || count > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+
+    std::vector<uint64_t> ids(count);
+    std::vector<uint32_t> groups(count);
+    std::vector<float> vectors(count * dims);
+    std::vector<float> centroids(static_cast<size_t>(lists) * dims);
+    std::vector<uint32_t> assignments(lists > 0 ? count : 0);
+    if (!readRaw(in, ids.data(), ids.size())
+        || !readRaw(in, groups.data(), groups.size())
+        || !readRaw(in, vectors.data(), vectors.size())
+        || !readRaw(in, centroids.data(), centroids.size())
+        || !readRaw(in, assignments.data(), assignments.size())) {
+        return false;
+    }
+
+    std::unique_lock lock(m_mtx);
+    m_dims = dims;
+    m_ids = std::move(ids);
+    m_groups = std::move(groups);
+    m_vectors = std::move(vectors);
+    m_lists = lists;
+    m_centroids = std::move(centroids);
+    m_assignments = lists > 0 ? std::move(assignments) : std::vector<uint32_t>(m_ids.size(), 0);
+
+    m_rows.clear();
+    m_rows.reserve(m_ids.size());
+    for (uint32_t row = 0; row < m_ids.size(); ++row)
+        m_rows[m_ids[row]] = row;
+
+    m_buckets.assign(m_lists, {});
+    if (m_lists > 0) {
+        for (uint32_t row = 0; row < m_ids.size(); ++row) {
+            if (m_assignments[row] >= static_cast<uint32_t>(m_lists))
+                m_assignments[row] = 0;
+            m_buckets[m_assignments[row]].push_back(row);
+        }
+    }
+
+    return true;
+}
+
+void VectorIndex::assignToList(uint32_t row)
+{
+    const int list = nearestCentroid(m_vectors.data() + static_cast<size_t>(row) * m_dims);
+    m_assignments[row] = static_cast<uint32_t>(list);
+    m_buckets[list].push_back(row);
+}
+
+int VectorIndex::nearestCentroid(const float *vector) const
+{
+    const ConstMatrixMap centroids(m_centroids.data(), m_lists, m_dims);
+    int list = 0;
+    (centroids * ConstVectorMap(vector, m_dims)).maxCoeff(&list);
+    return list;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief In-process index of L2-normalized embeddings, searched by cosine similarity.
+ *
+ * Flat by default, i.e. every query is a single matrix-vector product over all the vectors,
+ * which Eigen vectorizes. Once trained, it becomes an IVF index: vectors are bucketed under
+ * their nearest k-means centroid and a query only scans the buckets of its closest centroids.
+ *
+ * Every vector carries a group (i.e. the camera), so queries can skip their own group.
+ * Safe to search from any thread while another one adds.
+ */
+class VectorIndex
+{
+public:
+    struct Hit {
+        uint64_t id;
+        float score;
+    };
+
+    explicit VectorIndex(int dims = 0);
+
+    int dims() const;
+    size_t size() const;
+    bool isTrained() const;
+
+    // The vector is normalized on the way in. Re-adding an id replaces its vector.
+    void add(uint64_t id, uint32_t group, const float *vector);
+    bool contains(uint64_t id) const;
+    std::vector<float> vector(uint64_t id) const;
+    uint32_t group(uint64_t id) const;
+
+    // Best first. probes is the number of IVF buckets to scan, ignored while flat.
+    std::vector<Hit> search(const float *query, size_t k, int probes = 8,
+                            std::optional<uint32_t> excludeGroup = std::nullopt, float minScore = -1.0f) const;
+
+    // k-means over (a sample of) the vectors, then every vector is bucketed. Can be called again to re-train.
+    void train(int lists, int iterations = 8, size_t maxSamples = 0);
+
+    // Empties it, for vectors of dims floats
+    void reset(int dims);
+
+    bool save(const std::string &path) const;
+    // Rejects a file shorter than its header says, or with vectors that aren't expectedDims long
+    // when it's given. The index is left as it was.
+    bool load(const std::string &path, int expectedDims = 0);
+
+private:
+    void assignToList(uint32_t row);
+    int nearestCentroid(const float *vector) const;
+
+private:
+    mutable std::shared_mutex m_mtx;
+    int m_dims = 0;
+    std::vector<uint64_t> m_ids;
+    std::vector<uint32_t> m_groups;
+    std::vector<float> m_vectors;       // Row-major, size() x dims
+    std::unordered_map<uint64_t, uint32_t> m_rows;
+
+    // IVF
+    int m_lists = 0;
+    std::vector<float> m_centroids;     // Row-major, m_lists x dims
+    std::vector<std::vector<uint32_t>> m_buckets;
+    std::vector<uint32_t> m_assignments;    // Bucket of each row
+};
@@ -0,0 +1,307 @@
+#include <filesystem>
+#include <gtest/gtest.h>
+
+#include <odb/database.hxx>
+#include <odb/query.hxx>
+#include <odb/schema-catalog.hxx>
+#include <odb/transaction.hxx>
+#include <odb/sqlite/database.hxx>
+
+#include <QtCore/QDateTime>
+#include <QtCore/QString>
+#include <QtCore/QThread>
+
+#include <sqlite3.h>
+#include <odb/sqlite/connection.hxx>
+
+#include "output/eventwriter.h"
+#include "utils/trackcodec.h"
+
+class TestEventWriter : public ::testing::Test
+{
+protected:
+    std::string m_pathPrefix = "test/db";
+    std::shared_ptr<odb::database> db;
+
+    void SetUp() override
+    {
+        std::filesystem::create_directories(m_pathPrefix);
+        const std::string path = m_pathPrefix + "/test_event_writer.db";
+        std::filesystem::remove(path);
+
+        db = std::make_shared<odb::sqlite::database>(path, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+
+        odb::transaction t(db->begin());
+        odb::schema_catalog::create_schema(*db);
+        t.commit();
+
+        EventWriter::createSchema(*db);
+    }
+
+    void TearDown() override
+    {}
+
+    static APSS::ODB::Event sampleEvent(const QString &camera)
+    {
+        APSS::ODB::Event event;
+        event.label = "car";
+        event.camera = camera;
+        event.startTime = QDateTime::currentDateTime();
+        event.trackerId = 7;
+        event.topScore = 0.5f;
+        return event;
+    }
+
+    static EventWriter::PredictionRows samplePredictions(size_t n)
+    {
+        EventWriter::PredictionRows rows(n);
+        for (size_t i = 0; i < n; ++i) {
+            rows[i].first.frameId = QString("frame_%1").arg(i);
+            rows[i].first.streamTimestamp = QDateTime::currentDateTime();
+            rows[i].first.hasSubPredictions = false;
+            rows[i].second.className = "car";
+            rows[i].second.box = cv::Rect(static_cast<int>(i), 10, 50, 40);
+        }
+        return rows;
+    }
+};
+
+TEST_F(TestEventWriter, CommitsEventsAndPredictions)
+{
+    DatabaseConfig config;
+    config.commit_interval = 5;
+    config.prediction_rows = true;
+    EventWriter writer(db, config);
+    writer.start();
+
+    APSS::ODB::Event event = sampleEvent("cam_a");
+    EventWriter::Ticket ticket = writer.insertEvent(event);
+    ASSERT_TRUE(ticket.isValid());
+
+    // Finished before its id is known, and more rows than a single multi-row insert takes
+    event.endTime = QDateTime::currentDateTime();
+    event.topScore = 0.9f;
+    writer.finishEvent(ticket, event, samplePredictions(130));
+    writer.stop();
+
+    ASSERT_TRUE(ticket.isReady());
+    const size_t id = ticket.id();
+    EXPECT_GT(id, 0u);
+
+    odb::transaction t(db->begin());
+    std::unique_ptr<APSS::ODB::Event> stored(db->load<APSS::ODB::Event>(id));
+    EXPECT_EQ(stored->camera, QString("cam_a"));
+    EXPECT_FLOAT_EQ(stored->topScore, 0.9f);
+    EXPECT_TRUE(stored->endTime.isValid());
+
+    using query = odb::query<APSS::ODB::Prediction>;
+    odb::result<APSS::ODB::Prediction> predictions(db->query<APSS::ODB::Prediction>(query::eventId == id));
+    size_t count = 0;
+    for (const auto &p : predictions) {
+        EXPECT_TRUE(p.frameId.startsWith("frame_"));
+        EXPECT_TRUE(p.streamTimestamp.isValid());
+        ++count;
+    }
+    EXPECT_EQ(count, 130u);
+    t.commit();
+}
+
+TEST_F(TestEventWriter, ResolvesTicketsInOrder)
+{
+    EventWriter writer(db, DatabaseConfig());
+    writer.start();
+
+    EventWriter::Ticket first = writer.insertEvent(sampleEvent("cam_a"));
+    EventWriter::Ticket second = writer.insertEvent(sampleEvent("cam_b"));
+    writer.stop();
+
+    ASSERT_TRUE(first.isReady());
+    ASSERT_TRUE(second.isReady());
+    EXPECT_LT(first.id(), second.id());
+}
+
+TEST_F(TestEventWriter, UpdatesOnlyThePlateColumns)
+{
+    DatabaseConfig config;
+    config.commit_interval = 5;
+    EventWriter writer(db, config);
+    writer.start();
+
+    APSS::ODB::Event event = sampleEvent("cam_a");
+    event.subLabel = "known";
+    EventWriter::Ticket ticket = writer.insertEvent(event);
+    while (!ticket.isReady())
+        QThread::msleep(1);
+
+    // The plate is read while the track is still being finished
+    event.topScore = 0.8f;
+    writer.finishEvent(ticket, event, samplePredictions(3));
+    EXPECT_TRUE(writer.updatePlate(ticket.id(), "{\"text\":\"ABC123\"}", std::nullopt));
+    writer.stop();
+
+    odb::transaction t(db->begin());
+    std::unique_ptr<APSS::ODB::Event> stored(db->load<APSS::ODB::Event>(ticket.id()));
+    EXPECT_EQ(stored->licensePlateResults, QString("{\"text\":\"ABC123\"}"));
+    // Not matched against a watchlist, left as is
+    EXPECT_EQ(stored->subLabel, QString("known"));
+    EXPECT_FLOAT_EQ(stored->topScore, 0.8f);
+    t.commit();
+}
+
+TEST_F(TestEventWriter, DropsInsteadOfBlocking)
+{
+    DatabaseConfig config;
+    config.queue_size = 1;
+    EventWriter writer(db, config);
+
+    // Not started, nothing drains the queue
+    EventWriter::Ticket first = writer.insertEvent(sampleEvent("cam_a"));
+    EventWriter::Ticket second = writer.insertEvent(sampleEvent("cam_b"));
+    EXPECT_TRUE(first.isValid());
+    EXPECT_FALSE(second.isValid());
+    EXPECT_FALSE(writer.updatePlate(1, "{}", std::nullopt));
+    EXPECT_EQ(writer.dropped(), 2u);
+
+    writer.start();
+    writer.stop();
+    ASSERT_TRUE(first.isReady());
+    EXPECT_GT(first.id(), 0u);
+}
+
+TEST_F(TestEventWriter, StoresTrackAsChunks)
+{
+    DatabaseConfig config;
+    config.track_chunk_size = 50;
+    EventWriter writer(db, config);
+    writer.start();
+
+    APSS::ODB::Event event = sampleEvent("cam_a");
+    EventWriter::Ticket ticket = writer.insertEvent(event);
+    writer.finishEvent(ticket, event, samplePredictions(130));
+    writer.stop();
+
+    ASSERT_TRUE(ticket.isReady());
+    const size_t id = ticket.id();
+
+    odb::transaction t(db->begin());
+    // No JSON rows unless asked for
+    using query = odb::query<APSS::ODB::Prediction>;
+    odb::result<APSS::ODB::Prediction> predictions(db->query<APSS::ODB::Prediction>(query::eventId == id));
+    EXPECT_EQ(predictions.begin(), predictions.end());
+
+    sqlite3 *handle = static_cast<odb::sqlite::connection &>(t.connection()).handle();
+    sqlite3_stmt *stmt = nullptr;
+    ASSERT_EQ(sqlite3_prepare_v2(handle, "SELECT \"samples\", \"data\" FROM \"TrackChunk\" WHERE \"eventId\" = ? ORDER BY \"seq\"", -1, &stmt, nullptr), SQLITE_OK);
+    sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(id));
+
+    std::vector<TrackSample> track;
+    size_t chunks = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const auto *data = static_cast<const uint8_t *>(sqlite3_column_blob(stmt, 1));
+        const auto chunk = TrackCodec::decode(data, static_cast<size_t>(sqlite3_column_bytes(stmt, 1)));
+        ASSERT_TRUE(chunk.has_value());
+        EXPECT_EQ(chunk->size(), static_cast<size_t>(sqlite3_column_int(stmt, 0)));
+        track.insert(track.end(), chunk->begin(), chunk->end());
+        ++chunks;
+    }
+    sqlite3_finalize(stmt);
+    t.commit();
+
+    EXPECT_EQ(chunks, 3u);
+    ASSERT_EQ(track.size(), 130u);
+    EXPECT_EQ(track[129].prediction.box.x, 129);
+    EXPECT_EQ(track[0].prediction.className, "car");
+}
+
+TEST_F(TestEventWriter, AppendsChunksOfLiveTracks)
+{
+    DatabaseConfig config;
+    config.track_chunk_size = 50;
+    EventWriter writer(db, config);
+    writer.start();
+
+    APSS::ODB::Event event = sampleEvent("cam_a");
+    EventWriter::Ticket ticket = writer.insertEvent(event);
+
+    EventWriter::PredictionRows rows = samplePredictions(130);
+    EventWriter::PredictionRows first(rows.begin(), rows.begin() + 50);
+    EventWriter::PredictionRows second(rows.begin() + 50, rows.begin() + 100);
+    EventWriter::PredictionRows rest(rows.begin() + 100, rows.end());
+    writer.appendTrack(ticket, std::move(first));
+    writer.appendTrack(ticket, std::move(second));
+    writer.finishEvent(ticket, event, std::move(rest));
+    writer.stop();
+
+    ASSERT_TRUE(ticket.isReady());
+
+    odb::transaction t(db->begin());
+    sqlite3 *handle = static_cast<odb::sqlite::connection &>(t.connection()).handle();
+    sqlite3_stmt *stmt = nullptr;
+    ASSERT_EQ(sqlite3_prepare_v2(handle, "SELECT \"seq\", \"data\" FROM \"TrackChunk\" WHERE \"eventId\" = ? ORDER BY \"seq\"", -1, &stmt, nullptr), SQLITE_OK);
+    sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(ticket.id()));
+
+    std::vector<TrackSample> track;
+    int seq = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        EXPECT_EQ(sqlite3_column_int(stmt, 0), seq++);
+        const auto *data = static_cast<const uint8_t *>(sqlite3_column_blob(stmt, 1));
+        const auto chunk = TrackCodec::decode(data, static_cast<size_t>(sqlite3_column_bytes(stmt, 1)));
+        ASSERT_TRUE(chunk.has_value());
+        track.insert(track.end(), chunk->begin(), chunk->end());
+    }
+    sqlite3_finalize(stmt);
+    t.commit();
+
+    EXPECT_EQ(seq, 3);
+    ASSERT_EQ(track.size(), 130u);
+    for (size_t i = 0; i < track.size(); ++i)
+        EXPECT_EQ(track[i].prediction.box.x, static_cast<int>(i));
+}
+
+TEST_F(TestEventWriter, RetriesTheRestOfAFailedGroup)
+{
+    {
+        // Rejects the 3-sample chunk of the second event
+        odb::transaction t(db->begin());
+        db->execute("CREATE TRIGGER \"reject_chunk\" BEFORE INSERT ON \"TrackChunk\" WHEN NEW.\"samples\" = 3 "
+                    "BEGIN SELECT RAISE(ABORT, 'rejected'); END");
+        t.commit();
+    }
+
+    DatabaseConfig config;
+    config.track_chunk_size = 50;
+    EventWriter writer(db, config);
+
+    // Queued before it starts, so they're all in one group
+    APSS::ODB::Event first_event = sampleEvent("cam_a");
+    EventWriter::Ticket first = writer.insertEvent(first_event);
+    writer.appendTrack(first, samplePredictions(50));
+    APSS::ODB::Event second_event = sampleEvent("cam_b");
+    EventWriter::Ticket second = writer.insertEvent(second_event);
+    writer.finishEvent(second, second_event, samplePredictions(3));
+    writer.finishEvent(first, first_event, samplePredictions(10));
+
+    writer.start();
+    writer.stop();
+
+    // Only the failing mutation is lost
+    ASSERT_TRUE(first.isReady());
+    ASSERT_TRUE(second.isReady());
+    EXPECT_GT(first.id(), 0u);
+    EXPECT_GT(second.id(), 0u);
+
+    odb::transaction t(db->begin());
+    sqlite3 *handle = static_cast<odb::sqlite::connection &>(t.connection()).handle();
+    sqlite3_stmt *stmt = nullptr;
+    ASSERT_EQ(sqlite3_prepare_v2(handle, "SELECT \"eventId\", \"seq\" FROM \"TrackChunk\" ORDER BY \"eventId\", \"seq\"", -1, &stmt, nullptr), SQLITE_OK);
+
+    // No gap left by the rolled back attempt
+    std::vector<std::pair<size_t, int>> chunks;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+        chunks.emplace_back(static_cast<size_t>(sqlite3_column_int64(stmt, 0)), sqlite3_column_int(stmt, 1));
+    sqlite3_finalize(stmt);
+    t.commit();
+
+    const std::vector<std::pair<size_t, int>> expected = { { first.id(), 0 }, { first.id(), 1 } };
+    EXPECT_EQ(chunks, expected);
+}
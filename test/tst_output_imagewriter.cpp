@@ -0,0 +1,77 @@
+#include <QDir>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "output/imagewriter.h"
+
+class TestImageWriter : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(m_dir.isValid());
+    }
+    void TearDown() override {}
+
+    QString path(const QString &name) const {
+        return QDir(m_dir.path()).filePath(name);
+    }
+
+    static cv::Mat solid(uchar value) {
+        return cv::Mat(16, 16, CV_8UC3, cv::Scalar(value, value, value));
+    }
+
+    QTemporaryDir m_dir;
+};
+
+TEST_F(TestImageWriter, CoalescesWritesToTheSamePath) {
+    ImageWriter writer(SnapshotsConfig{});
+    const QString thumb = path("cam_1.jpg");
+
+    // Not started yet, so everything stays queued
+    EXPECT_TRUE(writer.write(thumb, solid(10)));
+    EXPECT_TRUE(writer.write(thumb, solid(200)));
+    EXPECT_TRUE(writer.write(path("cam_2.jpg"), solid(10)));
+    EXPECT_EQ(writer.pending(), 2u);
+
+    writer.start();
+    writer.stop();
+    EXPECT_EQ(writer.pending(), 0u);
+
+    // The newest image won
+    const cv::Mat written = cv::imread(thumb.toStdString());
+    ASSERT_FALSE(written.empty());
+    EXPECT_GT(cv::mean(written)[0], 150.0);
+    EXPECT_TRUE(QFileInfo::exists(path("cam_2.jpg")));
+}
+
+TEST_F(TestImageWriter, DropsWhenFull) {
+    SnapshotsConfig config;
+    config.queue_size = 2;
+    EngineMetrics metrics;
+    ImageWriter writer(config, &metrics);
+
+    EXPECT_TRUE(writer.write(path("a.jpg"), solid(10)));
+    EXPECT_TRUE(writer.write(path("b.jpg"), solid(10)));
+    EXPECT_FALSE(writer.write(path("c.jpg"), solid(10)));
+    // Replacing a pending image never needs room
+    EXPECT_TRUE(writer.write(path("a.jpg"), solid(20)));
+
+    EXPECT_EQ(metrics.imageWriterQueueDepth(), 2);
+    EXPECT_EQ(metrics.imageWriterDropped(), 1);
+
+    writer.start();
+    writer.stop();
+    EXPECT_EQ(metrics.imageWriterQueueDepth(), 0);
+    EXPECT_FALSE(QFileInfo::exists(path("c.jpg")));
+}
+
+TEST_F(TestImageWriter, ExtensionFollowsFormat) {
+    SnapshotsConfig config;
+    EXPECT_EQ(ImageWriter(config).extension(), ".jpg");
+
+    config.format = ImageFormatEnum::WebP;
+    EXPECT_EQ(ImageWriter(config).extension(), ".webp");
+}
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include "output/keyframeindex.h"
+
+TEST(TestKeyframeIndex, SeeksToTheKeyframeAtOrBefore)
+{
+    KeyframeIndex index;
+    // A keyframe every second, 4KB apart
+    for (int i = 0; i < 10; ++i)
+        index.append(i * 1000, 100 + i * 4096);
+
+    EXPECT_EQ(index.seek(-500)->time, 0);
+    EXPECT_EQ(index.seek(0)->offset, 100);
+    EXPECT_EQ(index.seek(2999)->time, 2000);
+    EXPECT_EQ(index.seek(3000)->time, 3000);
+    EXPECT_EQ(index.seek(3000)->offset, 100 + 3 * 4096);
+    EXPECT_EQ(index.seek(60000)->time, 9000);
+
+    EXPECT_FALSE(KeyframeIndex().seek(0).has_value());
+}
+
+TEST(TestKeyframeIndex, RoundTripsThroughBytes)
+{
+    KeyframeIndex index;
+    index.append(0, 0);
+    index.append(1000, 5000000000LL);
+    index.append(1000, 42);    // Not after the last one
+    index.append(2040, 5000123456LL);
+    ASSERT_EQ(index.size(), 3u);
+
+    const QByteArray data = index.toByteArray();
+    EXPECT_EQ(data.size(), 3 * 16);
+
+    const KeyframeIndex decoded = KeyframeIndex::fromByteArray(data);
+    ASSERT_EQ(decoded.size(), index.size());
+    for (size_t i = 0; i < index.size(); ++i) {
+        EXPECT_EQ(decoded.keyframes()[i].time, index.keyframes()[i].time);
+        EXPECT_EQ(decoded.keyframes()[i].offset, index.keyframes()[i].offset);
+    }
+
+    // Truncated
+    EXPECT_TRUE(KeyframeIndex::fromByteArray(data.left(20)).isEmpty());
+}
@@ -0,0 +1,146 @@
+#include <atomic>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <vector>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QThread>
+
+#include "output/muxingexecutor.h"
+
+class TestMuxingExecutor : public ::testing::Test
+{
+protected:
+    static SharedPacket packet(int64_t pts)
+    {
+        SharedPacket pkt(av_packet_alloc(), [](AVPacket *p) { av_packet_free(&p); });
+        pkt->pts = pkt->dts = pts;
+        return pkt;
+    }
+};
+
+TEST_F(TestMuxingExecutor, WritesEveryOutputInOrder)
+{
+    // Far more outputs than workers
+    constexpr int OUTPUTS = 50;
+    constexpr int PACKETS = 200;
+
+    MuxingExecutor executor(2, PACKETS);
+    executor.start();
+
+    std::vector<std::vector<int64_t>> written(OUTPUTS);
+    std::vector<std::atomic<int>> closed(OUTPUTS);
+    std::vector<MuxingExecutor::OutputPtr> outputs;
+    for (int o = 0; o < OUTPUTS; ++o) {
+        outputs.push_back(executor.addOutput(QString("out_%1").arg(o),
+            [&written, o](const SharedPacket &pkt, AVRational) { written[o].push_back(pkt->pts); },
+            [&closed, o]() { closed[o]++; }));
+    }
+
+    for (int i = 0; i < PACKETS; ++i) {
+        for (const auto &output : outputs)
+            ASSERT_TRUE(executor.push(output, packet(i), { 1, 10 }));
+    }
+    executor.stop();
+
+    for (int o = 0; o < OUTPUTS; ++o) {
+        ASSERT_EQ(written[o].size(), static_cast<size_t>(PACKETS));
+        for (int i = 0; i < PACKETS; ++i)
+            EXPECT_EQ(written[o][i], i);
+        EXPECT_EQ(closed[o].load(), 1);
+    }
+}
+
+TEST_F(TestMuxingExecutor, DropsWhenAnOutputFallsBehind)
+{
+    // Not started, nothing is written
+    MuxingExecutor executor(1, 4);
+    auto output = executor.addOutput("slow", [](const SharedPacket &, AVRational) {});
+
+    for (int i = 0; i < 6; ++i)
+        executor.push(output, packet(i), { 1, 10 });
+
+    EXPECT_EQ(executor.pending(output), 4u);
+    EXPECT_EQ(executor.dropped(output), 2u);
+}
+
+TEST_F(TestMuxingExecutor, ClosesRemovedOutputsAfterTheirPackets)
+{
+    MuxingExecutor executor(2, 64);
+    executor.start();
+
+    std::mutex mtx;
+    std::vector<int64_t> events;    // -1 is the close
+    auto output = executor.addOutput("cam",
+        [&](const SharedPacket &pkt, AVRational) {
+            QThread::msleep(1);
+            std::lock_guard lock(mtx);
+            events.push_back(pkt->pts);
+        },
+        [&]() {
+            std::lock_guard lock(mtx);
+            events.push_back(-1);
+        });
+
+    for (int i = 0; i < 10; ++i)
+        executor.push(output, packet(i), { 1, 10 });
+    executor.removeOutput(output);
+    EXPECT_FALSE(executor.push(output, packet(10), { 1, 10 }));
+    executor.stop();
+
+    ASSERT_EQ(events.size(), 11u);
+    EXPECT_EQ(events.back(), -1);
+    EXPECT_EQ(events[9], 9);
+}
+
+TEST_F(TestMuxingExecutor, FollowsADistributor)
+{
+    MuxingExecutor executor(2, 4);
+    executor.start();
+
+    auto distributor = QSharedPointer<PacketDistributor>::create(256);
+    std::vector<int64_t> written;
+    bool closed = false;
+    auto output = executor.addOutput("cam", distributor,
+        [&](const SharedPacket &pkt, AVRational) { written.push_back(pkt->pts); },
+        [&]() { closed = true; });
+
+    // Well past its own queue size, the packets are read off the distributor instead
+    for (int i = 0; i < 100; ++i) {
+        SharedPacket pkt = packet(i);
+        if (i % 10 == 0)
+            pkt->flags |= AV_PKT_FLAG_KEY;
+        distributor->publish(pkt, { 1, 10 });
+    }
+    executor.stop();
+
+    ASSERT_EQ(written.size(), 100u);
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(written[i], i);
+    EXPECT_TRUE(closed);
+    EXPECT_EQ(executor.dropped(output), 0u);
+    EXPECT_TRUE(distributor->readers().isEmpty());
+}
+
+TEST_F(TestMuxingExecutor, DropsWhatsLeftPastTheStopDeadline)
+{
+    MuxingExecutor executor(1, 64);
+    executor.start();
+
+    // A stalled disk
+    std::atomic<int> written = 0;
+    std::atomic<int> closed = 0;
+    auto output = executor.addOutput("stalled",
+        [&written](const SharedPacket &, AVRational) { QThread::msleep(100); written++; },
+        [&closed]() { closed++; });
+    for (int i = 0; i < 50; ++i)
+        ASSERT_TRUE(executor.push(output, packet(i), { 1, 10 }));
+
+    QElapsedTimer timer;
+    timer.start();
+    executor.stop(200);
+
+    EXPECT_LT(timer.elapsed(), 2000);
+    EXPECT_LT(written.load(), 50);
+    EXPECT_EQ(closed.load(), 1);
+}
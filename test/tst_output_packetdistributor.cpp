@@ -0,0 +1,147 @@
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "output/packetdistributor.h"
+
+class TestPacketDistributor : public ::testing::Test
+{
+protected:
+    static constexpr AVRational TIME_BASE = { 1, 10 };
+
+    static SharedPacket packet(int64_t ts, bool key)
+    {
+        SharedPacket pkt(av_packet_alloc(), [](AVPacket *p) { av_packet_free(&p); });
+        av_new_packet(pkt.get(), 16);
+        pkt->pts = pkt->dts = ts;
+        if (key)
+            pkt->flags |= AV_PKT_FLAG_KEY;
+        return pkt;
+    }
+};
+
+TEST_F(TestPacketDistributor, ReadersShareThePublishedPackets)
+{
+    PacketDistributor distributor(16);
+    auto recorder = distributor.addReader("recorder");
+    auto other = distributor.addReader("other");
+
+    std::vector<SharedPacket> published;
+    for (int i = 0; i < 8; ++i) {
+        published.push_back(packet(i, i % 4 == 0));
+        distributor.publish(published.back(), TIME_BASE);
+    }
+
+    for (const auto &reader : { recorder, other }) {
+        EXPECT_EQ(reader->lag(), 8u);
+
+        PacketDistributor::Entry entry;
+        for (int i = 0; i < 8; ++i) {
+            ASSERT_TRUE(reader->read(entry));
+            // The same packet, not a copy of it
+            EXPECT_EQ(entry.pkt.get(), published[i].get());
+        }
+        EXPECT_FALSE(reader->read(entry));
+        EXPECT_EQ(reader->lag(), 0u);
+        EXPECT_EQ(reader->dropped(), 0u);
+    }
+}
+
+TEST_F(TestPacketDistributor, StartsAtTheNextKeyframe)
+{
+    PacketDistributor distributor(16);
+    distributor.publish(packet(0, true), TIME_BASE);
+    distributor.publish(packet(1, false), TIME_BASE);
+
+    auto reader = distributor.addReader("late");
+    distributor.publish(packet(2, false), TIME_BASE);
+    distributor.publish(packet(3, true), TIME_BASE);
+
+    PacketDistributor::Entry entry;
+    ASSERT_TRUE(reader->read(entry));
+    EXPECT_EQ(entry.pkt->pts, 3);
+    EXPECT_EQ(reader->dropped(), 0u);
+}
+
+TEST_F(TestPacketDistributor, LappedReaderResumesAtAKeyframe)
+{
+    // A keyframe every 4 packets, the reader falls more than a ring behind
+    PacketDistributor distributor(8);
+    auto reader = distributor.addReader("slow");
+    for (int i = 0; i < 14; ++i)
+        distributor.publish(packet(i, i % 4 == 0), TIME_BASE);
+
+    // 0-5 are overwritten, 6 and 7 aren't decodable without 4
+    PacketDistributor::Entry entry;
+    ASSERT_TRUE(reader->read(entry));
+    EXPECT_EQ(entry.pkt->pts, 8);
+    EXPECT_EQ(reader->dropped(), 8u);
+    EXPECT_EQ(reader->lag(), 5u);
+}
+
+TEST_F(TestPacketDistributor, NotifiesReadersOnPublish)
+{
+    PacketDistributor distributor(4);
+    std::vector<int64_t> seen;
+    auto reader = distributor.addReader("sync", [&seen](PacketDistributor::Reader &reader) {
+        PacketDistributor::Entry entry;
+        while (reader.read(entry))
+            seen.push_back(entry.pkt->pts);
+    });
+
+    for (int i = 0; i < 10; ++i)
+        distributor.publish(packet(i, i == 0), TIME_BASE);
+    EXPECT_EQ(seen.size(), 10u);
+    EXPECT_EQ(reader->dropped(), 0u);
+
+    distributor.removeReader(reader);
+    distributor.publish(packet(10, true), TIME_BASE);
+    EXPECT_EQ(seen.size(), 10u);
+}
+
+TEST_F(TestPacketDistributor, KeepsACopyOfTheCodecParameters)
+{
+    PacketDistributor distributor(16);
+    EXPECT_EQ(distributor.codecParameters(), nullptr);
+
+    AVCodecParameters *codecpar = avcodec_parameters_alloc();
+    codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
+    codecpar->codec_id = AV_CODEC_ID_H264;
+    codecpar->width = 640;
+    distributor.setCodecParameters(codecpar);
+    // As the capture's input is, when it exits
+    avcodec_parameters_free(&codecpar);
+
+    const auto copy = distributor.codecParameters();
+    ASSERT_NE(copy, nullptr);
+    EXPECT_EQ(copy->codec_id, AV_CODEC_ID_H264);
+    EXPECT_EQ(copy->width, 640);
+}
+
+TEST_F(TestPacketDistributor, ReadsInOrderWhilePublished)
+{
+    PacketDistributor distributor(16);
+    auto reader = distributor.addReader("recorder");
+
+    std::vector<SharedPacket> packets;
+    for (int i = 0; i < 5000; ++i)
+        packets.push_back(packet(i, i % 4 == 0));
+
+    std::thread capture([&]() {
+        for (const auto &pkt : packets)
+            distributor.publish(pkt, TIME_BASE);
+    });
+
+    // Lapped now and then, but never out of order or torn
+    int64_t last = -1;
+    PacketDistributor::Entry entry;
+    while (last < 4999) {
+        if (!reader->read(entry))
+            continue;
+        EXPECT_GT(entry.pkt->pts, last);
+        last = entry.pkt->pts;
+    }
+    capture.join();
+
+    EXPECT_EQ(reader->lag(), 0u);
+}
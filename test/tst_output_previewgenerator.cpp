@@ -0,0 +1,164 @@
+#include <filesystem>
+#include <gtest/gtest.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+#include <QtCore/QDir>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "output/previewgenerator.h"
+#include "output/segmentwriter.h"
+
+class TestPreviewGenerator : public ::testing::Test
+{
+protected:
+    // 10 fps, a keyframe every second
+    static constexpr AVRational TIME_BASE = { 1, 10 };
+    static constexpr int GOP = 10;
+
+    std::string m_pathPrefix = "test/previews";
+    AVCodecContext *m_encoder = nullptr;
+    APSSConfig config;
+
+    void SetUp() override
+    {
+        std::filesystem::remove_all(m_pathPrefix);
+        std::filesystem::create_directories(m_pathPrefix + "/recordings");
+
+        const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+        ASSERT_NE(codec, nullptr);
+        m_encoder = avcodec_alloc_context3(codec);
+        m_encoder->width = 64;
+        m_encoder->height = 48;
+        m_encoder->pix_fmt = AV_PIX_FMT_YUV420P;
+        m_encoder->time_base = TIME_BASE;
+        m_encoder->gop_size = GOP;
+        m_encoder->max_b_frames = 0;
+        m_encoder->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+        ASSERT_EQ(avcodec_open2(m_encoder, codec, nullptr), 0);
+
+        // The default record and preview config
+        CameraConfig camera;
+        camera.record = RecordConfig{};
+        config.cameras["cam_a"] = camera;
+    }
+
+    void TearDown() override
+    {
+        avcodec_free_context(&m_encoder);
+    }
+
+    std::vector<SharedPacket> encode(int frames)
+    {
+        std::vector<SharedPacket> packets;
+        AVFrame *frame = av_frame_alloc();
+        frame->format = m_encoder->pix_fmt;
+        frame->width = m_encoder->width;
+        frame->height = m_encoder->height;
+        av_frame_get_buffer(frame, 0);
+
+        AVPacket *pkt = av_packet_alloc();
+        auto drain = [&]() {
+            while (avcodec_receive_packet(m_encoder, pkt) == 0) {
+                packets.emplace_back(av_packet_clone(pkt), [](AVPacket *p) { av_packet_free(&p); });
+                av_packet_unref(pkt);
+            }
+        };
+
+        for (int i = 0; i < frames; ++i) {
+            av_frame_make_writable(frame);
+            for (int p = 0; p < 3; ++p)
+                memset(frame->data[p], (i * 7 + p * 40) % 255, frame->linesize[p] * (p ? frame->height / 2 : frame->height));
+            frame->pts = i;
+            avcodec_send_frame(m_encoder, frame);
+            drain();
+        }
+        avcodec_send_frame(m_encoder, nullptr);
+        drain();
+
+        av_packet_free(&pkt);
+        av_frame_free(&frame);
+        return packets;
+    }
+
+    static int countPackets(const QString &path)
+    {
+        AVFormatContext *ctx = nullptr;
+        const std::string file = path.toStdString();
+        if (avformat_open_input(&ctx, file.c_str(), nullptr, nullptr) < 0)
+            return -1;
+
+        int count = 0;
+        AVPacket *pkt = av_packet_alloc();
+        while (av_read_frame(ctx, pkt) >= 0) {
+            ++count;
+            av_packet_unref(pkt);
+        }
+        av_packet_free(&pkt);
+        avformat_close_input(&ctx);
+        return count;
+    }
+};
+
+TEST_F(TestPreviewGenerator, PreviewsKeyframesOnly)
+{
+    AVCodecParameters *codecpar = avcodec_parameters_alloc();
+    avcodec_parameters_from_context(codecpar, m_encoder);
+
+    SegmentWriter writer("cam_a", 2, QDir(QString::fromStdString(m_pathPrefix + "/recordings")));
+    writer.setStream(codecpar, TIME_BASE);
+    avcodec_parameters_free(&codecpar);
+
+    const QDir dir(QString::fromStdString(m_pathPrefix));
+    PreviewGenerator generator(config, nullptr, dir);
+    generator.start();
+
+    // 7s of video, 7 keyframes
+    for (const auto &pkt : encode(70)) {
+        if (auto closed = writer.write(pkt))
+            generator.addSegment(closed.value());
+    }
+    generator.addSegment(writer.close().value());
+    generator.stop();
+
+    // The hour can turn while it's recorded
+    const QDir camera_dir = dir.filePath("cam_a");
+    const QStringList previews = camera_dir.entryList({ "*.mkv" }, QDir::Files);
+    const QStringList sprites = camera_dir.entryList({ "*.jpg" }, QDir::Files);
+    ASSERT_FALSE(previews.isEmpty());
+    ASSERT_EQ(previews.size(), sprites.size());
+
+    int total = 0;
+    for (const QString &preview : previews)
+        total += countPackets(camera_dir.filePath(preview));
+    EXPECT_EQ(total, 7);
+
+    for (const QString &sprite : sprites) {
+        const cv::Mat sheet = cv::imread(camera_dir.filePath(sprite).toStdString());
+        ASSERT_FALSE(sheet.empty());
+        EXPECT_EQ(sheet.cols % PreviewGenerator::SPRITE_COLUMNS, 0);
+        // Never upscaled, half the 64x48 frames
+        EXPECT_EQ(sheet.cols, 32 * PreviewGenerator::SPRITE_COLUMNS);
+    }
+}
+
+TEST_F(TestPreviewGenerator, SkipsCamerasWithoutPreviews)
+{
+    config.cameras["cam_a"].record->preview = std::nullopt;
+
+    const QDir dir(QString::fromStdString(m_pathPrefix));
+    PreviewGenerator generator(config, nullptr, dir);
+    generator.start();
+
+    RecordingSegment segment;
+    segment.camera = "cam_a";
+    segment.path = dir.filePath("missing.mkv");
+    generator.addSegment(segment);
+    generator.stop();
+
+    EXPECT_FALSE(dir.exists("cam_a"));
+}
@@ -0,0 +1,212 @@
+#include <filesystem>
+#include <gtest/gtest.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+
+#include "output/clipexporter.h"
+#include "output/segmentwriter.h"
+
+class TestSegmentWriter : public ::testing::Test
+{
+protected:
+    // 10 fps, a keyframe every second
+    static constexpr AVRational TIME_BASE = { 1, 10 };
+    static constexpr int GOP = 10;
+
+    std::string m_pathPrefix = "test/recordings";
+    AVCodecContext *m_encoder = nullptr;
+
+    void SetUp() override
+    {
+        std::filesystem::remove_all(m_pathPrefix);
+        std::filesystem::create_directories(m_pathPrefix);
+
+        const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+        ASSERT_NE(codec, nullptr);
+        m_encoder = avcodec_alloc_context3(codec);
+        m_encoder->width = 64;
+        m_encoder->height = 48;
+        m_encoder->pix_fmt = AV_PIX_FMT_YUV420P;
+        m_encoder->time_base = TIME_BASE;
+        m_encoder->gop_size = GOP;
+        m_encoder->max_b_frames = 0;
+        m_encoder->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+        ASSERT_EQ(avcodec_open2(m_encoder, codec, nullptr), 0);
+    }
+
+    void TearDown() override
+    {
+        avcodec_free_context(&m_encoder);
+    }
+
+    std::vector<SharedPacket> encode(int frames)
+    {
+        std::vector<SharedPacket> packets;
+        AVFrame *frame = av_frame_alloc();
+        frame->format = m_encoder->pix_fmt;
+        frame->width = m_encoder->width;
+        frame->height = m_encoder->height;
+        av_frame_get_buffer(frame, 0);
+
+        AVPacket *pkt = av_packet_alloc();
+        auto drain = [&]() {
+            while (avcodec_receive_packet(m_encoder, pkt) == 0) {
+                packets.emplace_back(av_packet_clone(pkt), [](AVPacket *p) { av_packet_free(&p); });
+                av_packet_unref(pkt);
+            }
+        };
+
+        for (int i = 0; i < frames; ++i) {
+            av_frame_make_writable(frame);
+            for (int p = 0; p < 3; ++p)
+                memset(frame->data[p], (i * 7 + p * 40) % 255, frame->linesize[p] * (p ? frame->height / 2 : frame->height));
+            frame->pts = i;
+            avcodec_send_frame(m_encoder, frame);
+            drain();
+        }
+        avcodec_send_frame(m_encoder, nullptr);
+        drain();
+
+        av_packet_free(&pkt);
+        av_frame_free(&frame);
+        return packets;
+    }
+
+    static int countPackets(const QString &path, bool &startsWithKey)
+    {
+        AVFormatContext *ctx = nullptr;
+        const std::string file = path.toStdString();
+        if (avformat_open_input(&ctx, file.c_str(), nullptr, nullptr) < 0)
+            return -1;
+
+        int count = 0;
+        AVPacket *pkt = av_packet_alloc();
+        while (av_read_frame(ctx, pkt) >= 0) {
+            if (count == 0)
+                startsWithKey = pkt->flags & AV_PKT_FLAG_KEY;
+            ++count;
+            av_packet_unref(pkt);
+        }
+        av_packet_free(&pkt);
+        avformat_close_input(&ctx);
+        return count;
+    }
+};
+
+TEST_F(TestSegmentWriter, SplitsAtKeyframesPastTheDuration)
+{
+    AVCodecParameters *codecpar = avcodec_parameters_alloc();
+    avcodec_parameters_from_context(codecpar, m_encoder);
+
+    SegmentWriter writer("cam_a", 2, QDir(QString::fromStdString(m_pathPrefix)));
+    writer.setStream(codecpar, TIME_BASE);
+    avcodec_parameters_free(&codecpar);
+
+    // 7s of video
+    std::vector<RecordingSegment> segments;
+    for (const auto &pkt : encode(70)) {
+        if (auto closed = writer.write(pkt))
+            segments.push_back(closed.value());
+    }
+    ASSERT_TRUE(writer.current().has_value());
+    segments.push_back(writer.close().value());
+
+    ASSERT_EQ(segments.size(), 4u);
+    int total = 0;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const auto &segment = segments[i];
+        EXPECT_EQ(segment.camera, QString("cam_a"));
+        EXPECT_GT(segment.size, 0);
+        if (i > 0)
+            EXPECT_EQ(segment.startTime, segments[i - 1].endTime);
+
+        bool starts_with_key = false;
+        const int packets = countPackets(segment.path, starts_with_key);
+        EXPECT_TRUE(starts_with_key);
+        total += packets;
+
+        // A keyframe a second, the first one at the start
+        ASSERT_FALSE(segment.keyframes.isEmpty());
+        EXPECT_EQ(segment.keyframes.keyframes().front().time, 0);
+        EXPECT_EQ(static_cast<int>(segment.keyframes.size()), (packets + GOP - 1) / GOP);
+        for (const auto &keyframe : segment.keyframes.keyframes())
+            EXPECT_LT(keyframe.offset, segment.size);
+    }
+
+    // Every packet once
+    EXPECT_EQ(total, 70);
+    EXPECT_EQ(segments.front().startTime.msecsTo(segments.back().endTime), 7000);
+}
+
+TEST_F(TestSegmentWriter, CutsClipsAcrossSegments)
+{
+    AVCodecParameters *codecpar = avcodec_parameters_alloc();
+    avcodec_parameters_from_context(codecpar, m_encoder);
+
+    SegmentWriter writer("cam_a", 2, QDir(QString::fromStdString(m_pathPrefix)));
+    writer.setStream(codecpar, TIME_BASE);
+    avcodec_parameters_free(&codecpar);
+
+    QList<RecordingSegment> segments;
+    for (const auto &pkt : encode(70)) {
+        if (auto closed = writer.write(pkt))
+            segments.append(closed.value());
+    }
+    segments.append(writer.close().value());
+
+    // 2.5s to 5.5s, rewound to the keyframe at 2s, through the end of the second at 5s
+    const QDateTime origin = segments.front().startTime;
+    const QString clip = QString::fromStdString(m_pathPrefix + "/clip.mkv");
+    ASSERT_TRUE(ClipExporter::cut(segments, origin.addMSecs(2500), origin.addMSecs(5500), clip));
+
+    bool starts_with_key = false;
+    EXPECT_EQ(countPackets(clip, starts_with_key), 36);
+    EXPECT_TRUE(starts_with_key);
+}
+
+TEST_F(TestSegmentWriter, FlushesFragmentsWhileWriting)
+{
+    AVCodecParameters *codecpar = avcodec_parameters_alloc();
+    avcodec_parameters_from_context(codecpar, m_encoder);
+
+    // Fragments of half a GOP
+    SegmentWriter writer("cam_a", 10, QDir(QString::fromStdString(m_pathPrefix)), 500);
+    writer.setStream(codecpar, TIME_BASE);
+    avcodec_parameters_free(&codecpar);
+
+    std::vector<RecordingSegment> fragments;
+    for (const auto &pkt : encode(15)) {
+        ASSERT_FALSE(writer.write(pkt).has_value());
+        if (auto fragment = writer.takeFragment())
+            fragments.push_back(fragment.value());
+    }
+
+    // Every 5 frames, whatever the keyframes
+    ASSERT_EQ(fragments.size(), 3u);
+    EXPECT_FALSE(writer.takeFragment().has_value());
+    for (size_t i = 1; i < fragments.size(); ++i) {
+        EXPECT_EQ(fragments[i].path, fragments[0].path);
+        EXPECT_GT(fragments[i].endTime, fragments[i - 1].endTime);
+        EXPECT_GT(fragments[i].size, fragments[i - 1].size);
+    }
+
+    // Plays from disk before it's closed, from any of its keyframes
+    const RecordingSegment &last = fragments.back();
+    EXPECT_EQ(last.keyframes.size(), 2u);
+    for (const auto &keyframe : last.keyframes.keyframes())
+        EXPECT_LT(keyframe.offset, last.size);
+    EXPECT_EQ(last.startTime.msecsTo(last.endTime), 1500);
+    EXPECT_EQ(last.size, QFileInfo(last.path).size());
+    bool starts_with_key = false;
+    EXPECT_EQ(countPackets(last.path, starts_with_key), 15);
+    EXPECT_TRUE(starts_with_key);
+
+    ASSERT_TRUE(writer.close().has_value());
+    EXPECT_FALSE(writer.takeFragment().has_value());
+}
@@ -0,0 +1,172 @@
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <gtest/gtest.h>
+
+#include <odb/database.hxx>
+#include <odb/schema-catalog.hxx>
+#include <odb/transaction.hxx>
+#include <odb/sqlite/connection.hxx>
+#include <odb/sqlite/database.hxx>
+
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QThread>
+
+#include <sqlite3.h>
+
+#include "db/db.h"
+#include "db/event-odb.hxx"
+#include "output/eventwriter.h"
+#include "output/storagemaintainer.h"
+
+class TestStorageMaintainer : public ::testing::Test
+{
+protected:
+    std::string m_pathPrefix = "test/storage";
+    std::shared_ptr<odb::database> db;
+    APSSConfig config;
+
+    void SetUp() override
+    {
+        std::filesystem::remove_all(m_pathPrefix);
+        std::filesystem::create_directories(m_pathPrefix);
+        const std::string path = m_pathPrefix + "/test_storage_maintainer.db";
+
+        db = std::make_shared<odb::sqlite::database>(path, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+
+        odb::transaction t(db->begin());
+        odb::schema_catalog::create_schema(*db);
+        t.commit();
+
+        EventWriter::createSchema(*db);
+        StorageMaintainer::createSchema(*db);
+
+        // Nothing but the segments of events, kept for a day
+        RecordConfig record;
+        record.retain = RecordRetainConfig{ 0, RetainModeEnum::All };
+        record.detections = EventsConfig{ 5, 5, ReviewRetainConfig{ 1, RetainModeEnum::Motion } };
+        record.alerts = std::nullopt;
+
+        CameraConfig camera;
+        camera.record = record;
+        config.cameras["cam_a"] = camera;
+
+        // Whatever the disk is at, only retention deletes
+        StorageConfig storage;
+        storage.high_water = 100.0f;
+        storage.low_water = 100.0f;
+        storage.delete_interval = 0;
+        config.storage = storage;
+    }
+
+    QString touch(const QString &name)
+    {
+        const std::string path = m_pathPrefix + "/" + name.toStdString();
+        std::ofstream(path) << "data";
+        return QString::fromStdString(path);
+    }
+
+    static bool waitUntil(const std::function<bool()> &condition)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        while (!condition() && !timer.hasExpired(5000))
+            QThread::msleep(10);
+        return condition();
+    }
+};
+
+TEST_F(TestStorageMaintainer, ExpiresByRetention)
+{
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    const QString expired = touch("expired.mkv");
+    const QString of_event = touch("of_event.mkv");
+    const QString recent = touch("recent.mkv");
+    const QString old_clip = touch("old_clip.mkv");
+
+    // An event over the second segment, ended hours ago
+    APSS::ODB::Event event;
+    event.label = "car";
+    event.camera = "cam_a";
+    event.startTime = now.addSecs(-3 * 3600 + 2);
+    event.endTime = now.addSecs(-3 * 3600 + 6);
+    {
+        odb::transaction t(db->begin());
+        db->persist(event);
+        t.commit();
+    }
+
+    StorageMaintainer maintainer(db, config);
+    maintainer.addFile(StorageMaintainer::Kind::Segment, "cam_a", expired, now.addSecs(-2 * 3600), now.addSecs(-2 * 3600 + 10), 4);
+    maintainer.addFile(StorageMaintainer::Kind::Segment, "cam_a", of_event, now.addSecs(-3 * 3600), now.addSecs(-3 * 3600 + 10), 4);
+    maintainer.addFile(StorageMaintainer::Kind::Segment, "cam_a", recent, now.addSecs(-60), now.addSecs(-50), 4);
+    maintainer.addFile(StorageMaintainer::Kind::Clip, "cam_a", old_clip, now.addDays(-2), now.addDays(-2).addSecs(20), 4);
+
+    QStringList deleted;
+    QObject::connect(&maintainer, &StorageMaintainer::filesDeleted, [&deleted](const QStringList &paths) {
+        deleted.append(paths);
+    });
+
+    maintainer.start();
+    EXPECT_TRUE(waitUntil([&]() { return !QFile::exists(expired) && !QFile::exists(old_clip); }));
+    maintainer.stop();
+
+    EXPECT_TRUE(QFile::exists(of_event));
+    EXPECT_TRUE(QFile::exists(recent));
+    EXPECT_EQ(deleted.size(), 2);
+
+    // Only the ones left are indexed, the kept segment until the event's retention ends
+    odb::transaction t(db->begin());
+    sqlite3 *handle = static_cast<odb::sqlite::connection &>(t.connection()).handle();
+    sqlite3_stmt *stmt = nullptr;
+    ASSERT_EQ(sqlite3_prepare_v2(handle, "SELECT \"path\", \"retainUntil\" FROM \"StorageFile\" ORDER BY \"startTime\"", -1, &stmt, nullptr), SQLITE_OK);
+
+    QStringList indexed;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const QString path = QString::fromUtf8(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)));
+        indexed.append(path);
+        if (path == of_event)
+            EXPECT_GT(sqlite3_column_int64(stmt, 1), now.addSecs(12 * 3600).toMSecsSinceEpoch());
+    }
+    sqlite3_finalize(stmt);
+    t.commit();
+
+    EXPECT_EQ(indexed, QStringList({ of_event, recent }));
+}
+
+TEST_F(TestStorageMaintainer, ClosesEventsLeftOpen)
+{
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    const QString of_event = touch("of_dangling_event.mkv");
+
+    // Never finished by a previous run, its last chunk 30 s in
+    APSS::ODB::Event event;
+    event.label = "car";
+    event.camera = "cam_a";
+    event.startTime = now.addDays(-2);
+    {
+        odb::transaction t(db->begin());
+        db->persist(event);
+        db->execute(QString("INSERT INTO \"TrackChunk\" (\"eventId\", \"seq\", \"startTime\", \"endTime\", \"samples\", \"data\") "
+                            "VALUES (%1, 0, %2, %3, 1, x'00')")
+                        .arg(event.id)
+                        .arg(event.startTime.toMSecsSinceEpoch())
+                        .arg(event.startTime.addSecs(30).toMSecsSinceEpoch())
+                        .toStdString());
+        t.commit();
+    }
+
+    StorageMaintainer maintainer(db, config);
+    maintainer.addFile(StorageMaintainer::Kind::Segment, "cam_a", of_event, now.addDays(-2), now.addDays(-2).addSecs(10), 4);
+    maintainer.start();
+    // Past the review retention once it has an end
+    EXPECT_TRUE(waitUntil([&]() { return !QFile::exists(of_event); }));
+    maintainer.stop();
+
+    odb::transaction t(db->begin());
+    const std::unique_ptr<APSS::ODB::Event> closed(db->load<APSS::ODB::Event>(event.id));
+    t.commit();
+    EXPECT_EQ(forceToUTC(closed->endTime).toString(Qt::ISODateWithMs), event.startTime.addSecs(30).toString(Qt::ISODateWithMs));
+}
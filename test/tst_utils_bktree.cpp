@@ -0,0 +1,107 @@
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "utils/bktree.h"
+
+namespace {
+
+int levenshtein(const std::string &a, const std::string &b)
+{
+    std::vector<int> prev(b.size() + 1), curr(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); ++j)
+        prev[j] = static_cast<int>(j);
+
+    for (size_t i = 1; i <= a.size(); ++i) {
+        curr[0] = static_cast<int>(i);
+        for (size_t j = 1; j <= b.size(); ++j)
+            curr[j] = std::min({ prev[j] + 1, curr[j - 1] + 1, prev[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1) });
+        std::swap(prev, curr);
+    }
+
+    return prev[b.size()];
+}
+
+std::string randomPlate(std::mt19937 &rng)
+{
+    static const std::string chars = "ABCDEFGHJKLMNPRSTUVWXYZ0123456789";
+    std::uniform_int_distribution<size_t> len(5, 7), ch(0, chars.size() - 1);
+    std::string plate(len(rng), ' ');
+    for (auto &c : plate)
+        c = chars[ch(rng)];
+    return plate;
+}
+
+}
+
+class TestBKTree : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+TEST_F(TestBKTree, EmptyTreeFindsNothing) {
+    BKTree<int> tree(&levenshtein);
+    EXPECT_TRUE(tree.empty());
+    EXPECT_TRUE(tree.find("ABC123", 2).empty());
+}
+
+TEST_F(TestBKTree, FindsWithinDistanceClosestFirst) {
+    BKTree<std::string> tree(&levenshtein);
+    tree.insert("ABC123", "alice");
+    tree.insert("ABC124", "bob");
+    tree.insert("XYZ789", "carol");
+    tree.insert("ABC12", "dave");
+
+    const auto exact = tree.find("ABC123", 0);
+    ASSERT_EQ(exact.size(), 1);
+    EXPECT_EQ(*exact[0].value, "alice");
+
+    const auto close = tree.find("ABC123", 1);
+    ASSERT_EQ(close.size(), 3);
+    EXPECT_EQ(close[0].distance, 0);
+    EXPECT_EQ(*close[0].value, "alice");
+    EXPECT_EQ(close[1].distance, 1);
+    EXPECT_EQ(close[2].distance, 1);
+}
+
+TEST_F(TestBKTree, DuplicateKeysKeepAllValues) {
+    BKTree<std::string> tree(&levenshtein);
+    tree.insert("ABC123", "fleet");
+    tree.insert("ABC123", "stolen");
+
+    EXPECT_EQ(tree.size(), 2);
+    EXPECT_EQ(tree.find("ABC123", 0).size(), 2);
+}
+
+TEST_F(TestBKTree, MatchesBruteForce) {
+    std::mt19937 rng(42);
+    std::vector<std::string> plates;
+    BKTree<size_t> tree(&levenshtein);
+    for (size_t i = 0; i < 5000; ++i) {
+        plates.emplace_back(randomPlate(rng));
+        tree.insert(plates.back(), i);
+    }
+
+    for (int q = 0; q < 50; ++q) {
+        std::string query = plates[rng() % plates.size()];
+        query[rng() % query.size()] = 'Q';
+
+        for (int k = 0; k <= 2; ++k) {
+            std::set<size_t> expected;
+            for (size_t i = 0; i < plates.size(); ++i) {
+                if (levenshtein(query, plates[i]) <= k)
+                    expected.insert(i);
+            }
+
+            std::set<size_t> found;
+            for (const auto &match : tree.find(query, k))
+                found.insert(*match.value);
+
+            EXPECT_EQ(found, expected) << query << " k=" << k;
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "utils/platefusion.h"
+
+class TestPlateFusion : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    static std::vector<cv::Point3f> rectPoints(float w, float h, float conf = 1.0f) {
+        return { {0, 0, conf}, {w, 0, conf}, {w, h, conf}, {0, h, conf} };
+    }
+
+    static cv::Mat texturedPlate(int w, int h) {
+        cv::Mat plate(h, w, CV_8UC3, cv::Scalar(255, 255, 255));
+        for (int x = 4; x < w - 8; x += 12)
+            cv::rectangle(plate, cv::Rect(x, 4, 6, h - 8), cv::Scalar(0, 0, 0), cv::FILLED);
+        return plate;
+    }
+};
+
+TEST_F(TestPlateFusion, NormalizeKeepsUpperAlnum) {
+    EXPECT_EQ(PlateFusion::normalize("abc-123 x"), "ABC123X");
+    EXPECT_EQ(PlateFusion::normalize(" .- "), "");
+}
+
+TEST_F(TestPlateFusion, EditDistance) {
+    EXPECT_EQ(PlateFusion::editDistance("ABC123", "ABC123"), 0);
+    EXPECT_EQ(PlateFusion::editDistance("ABC123", "A8C123"), 1);
+    EXPECT_EQ(PlateFusion::editDistance("ABC123", "ABC12"), 1);
+    EXPECT_EQ(PlateFusion::editDistance("", "ABC"), 3);
+}
+
+TEST_F(TestPlateFusion, SingleReadingKeepsItsScore) {
+    const FusedPlate fused = PlateFusion::fuse({ {"ABC123", 0.8f, 0.5f} }, 1);
+    EXPECT_EQ(fused.text, "ABC123");
+    EXPECT_NEAR(fused.score, 0.8f, 1e-5f);
+    EXPECT_EQ(fused.reads, 1);
+}
+
+TEST_F(TestPlateFusion, VotesPerCharacter) {
+    // Every reading has a different mistake, the vote still gets it right.
+    const FusedPlate fused = PlateFusion::fuse({
+        {"A8C123", 0.7f, 0.5f},
+        {"ABC128", 0.7f, 0.5f},
+        {"ABC123", 0.7f, 0.5f},
+        {"ABO123", 0.7f, 0.5f},
+    }, 1);
+
+    EXPECT_EQ(fused.text, "ABC123");
+    EXPECT_EQ(fused.reads, 4);
+}
+
+TEST_F(TestPlateFusion, IgnoresReadingsBeyondMatchDistance) {
+    const FusedPlate fused = PlateFusion::fuse({
+        {"ABC123", 0.7f, 0.5f},
+        {"ABC123", 0.6f, 0.5f},
+        {"XYZ789", 0.95f, 0.5f},
+    }, 1);
+
+    EXPECT_EQ(fused.text, "ABC123");
+    EXPECT_EQ(fused.reads, 2);
+}
+
+TEST_F(TestPlateFusion, AgreementRaisesScore) {
+    const FusedPlate one = PlateFusion::fuse({ {"ABC123", 0.8f, 0.5f} }, 1);
+    const FusedPlate two = PlateFusion::fuse({ {"ABC123", 0.8f, 0.5f}, {"ABC123", 0.8f, 0.5f} }, 1);
+    const FusedPlate split = PlateFusion::fuse({ {"ABC123", 0.8f, 0.5f}, {"A8C123", 0.8f, 0.5f} }, 1);
+
+    EXPECT_GT(two.score, one.score);
+    EXPECT_LT(split.score, one.score);
+}
+
+TEST_F(TestPlateFusion, StoreConvergesAndReleases) {
+    LicensePlateConfig config;
+    config.recognition_threshold = 0.9f;
+    config.min_plate_length = 4;
+    config.match_distance = 1;
+
+    PlateFusionStore store;
+    store.configure(config);
+
+    store.submitted(1);
+    store.submitted(1);
+    store.addReading(1, {"abc-123", 0.8f, 0.5f});
+    EXPECT_FALSE(store.hasConverged(1));
+
+    const FusedPlate fused = store.addReading(1, {"ABC123", 0.8f, 0.6f});
+    EXPECT_EQ(fused.text, "ABC123");
+    EXPECT_TRUE(store.hasConverged(1));
+
+    store.close(1);
+    EXPECT_FALSE(store.fused(1).has_value());
+}
+
+TEST_F(TestPlateFusion, StoreIgnoresShortReadings) {
+    LicensePlateConfig config;
+    config.min_plate_length = 4;
+
+    PlateFusionStore store;
+    store.configure(config);
+
+    store.submitted(2);
+    const FusedPlate fused = store.addReading(2, {"AB", 0.99f, 0.5f});
+    EXPECT_TRUE(fused.text.empty());
+    EXPECT_FALSE(store.hasConverged(2));
+}
+
+TEST_F(TestPlateFusion, StoreKeepsEntryWhileReadsArePending) {
+    PlateFusionStore store;
+    store.submitted(3);
+    store.close(3);
+    ASSERT_TRUE(store.fused(3).has_value());
+
+    store.addReading(3, {"ABC123", 0.9f, 0.5f});
+    EXPECT_FALSE(store.fused(3).has_value());
+}
+
+TEST_F(TestPlateFusion, QualityPrefersSharpFrontalPlates) {
+    const cv::Mat sharp = texturedPlate(200, 50);
+    cv::Mat blurred;
+    cv::GaussianBlur(sharp, blurred, cv::Size(15, 15), 5.0);
+
+    const auto frontal = rectPoints(200, 50);
+    const std::vector<cv::Point3f> skewed = { {0, 0, 1}, {200, 20, 1}, {200, 40, 1}, {0, 50, 1} };
+
+    const float sharp_q = PlateFusion::quality(sharp, frontal, 1000);
+    EXPECT_GT(sharp_q, PlateFusion::quality(blurred, frontal, 1000));
+    EXPECT_GT(sharp_q, PlateFusion::quality(sharp, skewed, 1000));
+    EXPECT_FLOAT_EQ(PlateFusion::quality(sharp, frontal, 20000), 0.0f);
+    EXPECT_LE(sharp_q, PlateFusion::geometryQuality(frontal, sharp.cols * sharp.rows, 1000));
+}
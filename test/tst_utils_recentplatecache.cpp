@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "utils/recentplatecache.h"
+
+class TestRecentPlateCache : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    static cv::Mat texturedPlate(int w, int h) {
+        cv::Mat plate(h, w, CV_8UC3, cv::Scalar(255, 255, 255));
+        for (int x = 4; x < w - 8; x += 12)
+            cv::rectangle(plate, cv::Rect(x, 4, 6, h - 8), cv::Scalar(0, 0, 0), cv::FILLED);
+        return plate;
+    }
+
+    static FusedPlate fused(const std::string &text, float score) {
+        FusedPlate plate;
+        plate.text = text;
+        plate.score = score;
+        plate.reads = 1;
+        return plate;
+    }
+
+    const cv::Rect box = cv::Rect(100, 200, 120, 30);
+};
+
+TEST_F(TestRecentPlateCache, HitsTheSamePlateOfAnotherEvent) {
+    RecentPlateCache cache(30000);
+    const uint64_t hash = RecentPlateCache::dHash(texturedPlate(120, 30));
+    EXPECT_NE(hash, 0u);
+    cache.insert("cam_a", 1, hash, box, fused("ABC123", 0.9f), 0);
+
+    // The same vehicle under a new tracker id, slightly shifted
+    const auto hit = cache.find("cam_a", 2, hash, box + cv::Point(5, 2), 1000);
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_EQ(hit->text, "ABC123");
+    EXPECT_FLOAT_EQ(hit->score, 0.9f);
+
+    // A track's own readings are already in its fusion
+    EXPECT_FALSE(cache.find("cam_a", 1, hash, box, 1000).has_value());
+}
+
+TEST_F(TestRecentPlateCache, MissesOtherPlatesAndSpots) {
+    RecentPlateCache cache(30000);
+    const uint64_t hash = RecentPlateCache::dHash(texturedPlate(120, 30));
+    cache.insert("cam_a", 1, hash, box, fused("ABC123", 0.9f), 0);
+
+    EXPECT_FALSE(cache.find("cam_a", 2, ~hash, box, 1000).has_value());
+    EXPECT_FALSE(cache.find("cam_a", 2, hash, box + cv::Point(400, 0), 1000).has_value());
+    EXPECT_FALSE(cache.find("cam_a", 2, hash, cv::Rect(100, 200, 300, 75), 1000).has_value());
+
+    // Empty readings aren't remembered
+    cache.insert("cam_a", 3, ~hash, box + cv::Point(400, 0), fused("", 0.0f), 0);
+    EXPECT_FALSE(cache.find("cam_a", 2, ~hash, box + cv::Point(400, 0), 1000).has_value());
+}
+
+TEST_F(TestRecentPlateCache, ExpiresAfterTheTtl) {
+    RecentPlateCache cache(1000);
+    const uint64_t hash = RecentPlateCache::dHash(texturedPlate(120, 30));
+    cache.insert("cam_a", 1, hash, box, fused("ABC123", 0.9f), 0);
+
+    EXPECT_TRUE(cache.find("cam_a", 2, hash, box, 999).has_value());
+    EXPECT_FALSE(cache.find("cam_a", 2, hash, box, 1000).has_value());
+
+    // Refreshed by a new reading of the same plate
+    cache.insert("cam_a", 1, hash, box, fused("ABC123", 0.5f), 2000);
+    cache.insert("cam_a", 1, hash, box, fused("ABC128", 0.4f), 2500);
+    const auto hit = cache.find("cam_a", 2, hash, box, 3400);
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_EQ(hit->text, "ABC123");
+}
+
+TEST_F(TestRecentPlateCache, KeepsCamerasApart) {
+    RecentPlateCache cache(30000);
+    const uint64_t hash = RecentPlateCache::dHash(texturedPlate(120, 30));
+    cache.insert("cam_a", 1, hash, box, fused("ABC123", 0.9f), 0);
+
+    EXPECT_FALSE(cache.find("cam_b", 2, hash, box, 1000).has_value());
+    EXPECT_TRUE(cache.find("cam_a", 2, hash, box, 1000).has_value());
+
+    EXPECT_GT(cache.hitRate("cam_a"), 0.0);
+    EXPECT_DOUBLE_EQ(cache.hitRate("cam_b"), 0.0);
+    EXPECT_DOUBLE_EQ(cache.hitRate("cam_c"), 0.0);
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include "utils/trackcodec.h"
+
+class TestTrackCodec : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+
+    static std::vector<TrackSample> walkingTrack(size_t n) {
+        std::vector<TrackSample> samples(n);
+        for (size_t i = 0; i < n; ++i) {
+            auto &s = samples[i];
+            s.timestamp = 1700000000000 + static_cast<int64_t>(i) * 40;
+            s.prediction.className = "car";
+            s.prediction.classId = 2;
+            s.prediction.trackerId = 17;
+            s.prediction.conf = 0.5f + (i % 10) * 0.05f;
+            s.prediction.box = cv::Rect(100 + static_cast<int>(i) * 3, 200 - static_cast<int>(i), 120, 80 + static_cast<int>(i % 3));
+        }
+        return samples;
+    }
+};
+
+TEST_F(TestTrackCodec, RoundTripsBoxesAndTimestamps) {
+    const auto samples = walkingTrack(300);
+    const std::vector<uint8_t> data = TrackCodec::encode(samples);
+    const auto decoded = TrackCodec::decode(data.data(), data.size());
+
+    ASSERT_TRUE(decoded.has_value());
+    ASSERT_EQ(decoded->size(), samples.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const auto &a = samples[i];
+        const auto &b = decoded->at(i);
+        EXPECT_EQ(a.timestamp, b.timestamp);
+        EXPECT_EQ(a.prediction.box, b.prediction.box);
+        EXPECT_EQ(a.prediction.className, b.prediction.className);
+        EXPECT_EQ(a.prediction.classId, b.prediction.classId);
+        EXPECT_EQ(a.prediction.trackerId, b.prediction.trackerId);
+        EXPECT_NEAR(a.prediction.conf, b.prediction.conf, 1.0f / 255);
+    }
+}
+
+TEST_F(TestTrackCodec, SmallerThanJsonRows) {
+    // A few bytes a sample, against a hundred or so as JSON
+    const auto samples = walkingTrack(1000);
+    EXPECT_LT(TrackCodec::encode(samples).size(), samples.size() * 16);
+}
+
+TEST_F(TestTrackCodec, KeepsPointsAndSubPredictions) {
+    std::vector<TrackSample> samples = walkingTrack(2);
+
+    Prediction plate;
+    plate.className = "license_plate";
+    plate.classId = 0;
+    plate.conf = 0.8f;
+    plate.box = cv::Rect(130, 250, 40, 12);
+    plate.points = { {130.25f, 250.5f, 0.9f}, {170.0f, 250.0f, 0.9f}, {170.0f, 262.0f, 0.8f}, {130.0f, 262.0f, 0.7f} };
+    samples[1].prediction.subPredictions = std::vector<Prediction>{ plate };
+    samples[1].prediction.points = { {110.0f, 210.75f, 1.0f} };
+    samples[1].prediction.hasDeltas = true;
+
+    const std::vector<uint8_t> data = TrackCodec::encode(samples);
+    const auto decoded = TrackCodec::decode(data.data(), data.size());
+    ASSERT_TRUE(decoded.has_value());
+
+    const Prediction &p = decoded->at(1).prediction;
+    EXPECT_TRUE(p.hasDeltas);
+    ASSERT_EQ(p.points.size(), 1u);
+    EXPECT_NEAR(p.points[0].y, 210.75f, 0.25f);
+
+    ASSERT_TRUE(p.subPredictions.has_value());
+    ASSERT_EQ(p.subPredictions->size(), 1u);
+    const Prediction &sub = p.subPredictions->front();
+    EXPECT_EQ(sub.className, "license_plate");
+    EXPECT_EQ(sub.box, plate.box);
+    ASSERT_EQ(sub.points.size(), 4u);
+    EXPECT_NEAR(sub.points[0].x, 130.25f, 0.25f);
+    EXPECT_NEAR(sub.points[3].z, 0.7f, 1.0f / 255);
+    EXPECT_FALSE(decoded->at(0).prediction.subPredictions.has_value());
+}
+
+TEST_F(TestTrackCodec, RejectsTruncatedAndForeignData) {
+    const std::vector<uint8_t> data = TrackCodec::encode(walkingTrack(10));
+    EXPECT_FALSE(TrackCodec::decode(data.data(), data.size() - 3).has_value());
+
+    const std::vector<uint8_t> json = { '{', '"', 'b', 'o', 'x', '"', '}' };
+    EXPECT_FALSE(TrackCodec::decode(json.data(), json.size()).has_value());
+
+    // A class count, then a class name length, no chunk could hold
+    const std::vector<uint8_t> huge = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F };
+    std::vector<uint8_t> corrupt(data.begin(), data.begin() + 5);
+    corrupt.insert(corrupt.end(), huge.begin(), huge.end());
+    corrupt.insert(corrupt.end(), data.begin() + 6, data.end());
+    EXPECT_FALSE(TrackCodec::decode(corrupt.data(), corrupt.size()).has_value());
+
+    corrupt.assign(data.begin(), data.begin() + 6);
+    corrupt.insert(corrupt.end(), huge.begin(), huge.end());
+    corrupt.insert(corrupt.end(), data.begin() + 7, data.end());
+    EXPECT_FALSE(TrackCodec::decode(corrupt.data(), corrupt.size()).has_value());
+
+    const std::vector<uint8_t> empty = TrackCodec::encode({});
+    const auto decoded = TrackCodec::decode(empty.data(), empty.size());
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_TRUE(decoded->empty());
+}
@@ -0,0 +1,187 @@
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "utils/vectorindex.h"
+
+class TestVectorIndex : public ::testing::Test {
+protected:
+    static constexpr int dims = 32;
+
+    static void SetUpTestSuite() {
+        std::filesystem::create_directories("test/results");
+    }
+
+    void SetUp() override {}
+    void TearDown() override {}
+
+    // Clustered random vectors, so IVF has something to find
+    static std::vector<std::vector<float>> makeVectors(size_t count, int clusters, unsigned seed = 7) {
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> noise(0.0f, 0.1f);
+        std::normal_distribution<float> center(0.0f, 1.0f);
+
+        std::vector<std::vector<float>> centers(clusters, std::vector<float>(dims));
+        for (auto &c : centers)
+            for (auto &v : c)
+                v = center(rng);
+
+        std::vector<std::vector<float>> vectors(count, std::vector<float>(dims));
+        for (size_t i = 0; i < count; ++i)
+            for (int d = 0; d < dims; ++d)
+                vectors[i][d] = centers[i % clusters][d] + noise(rng);
+
+        return vectors;
+    }
+};
+
+TEST_F(TestVectorIndex, EmptyIndexFindsNothing) {
+    VectorIndex index(dims);
+    const std::vector<float> query(dims, 1.0f);
+    EXPECT_TRUE(index.search(query.data(), 5).empty());
+}
+
+TEST_F(TestVectorIndex, FlatFindsItself) {
+    const auto vectors = makeVectors(500, 10);
+    VectorIndex index(dims);
+    for (size_t i = 0; i < vectors.size(); ++i)
+        index.add(i, 0, vectors[i].data());
+
+    ASSERT_EQ(index.size(), vectors.size());
+    for (size_t i = 0; i < vectors.size(); i += 37) {
+        const auto hits = index.search(vectors[i].data(), 3);
+        ASSERT_FALSE(hits.empty());
+        EXPECT_EQ(hits.front().id, i);
+        EXPECT_NEAR(hits.front().score, 1.0f, 1e-4f);
+    }
+}
+
+TEST_F(TestVectorIndex, ResultsAreSortedAndLimited) {
+    const auto vectors = makeVectors(200, 4);
+    VectorIndex index(dims);
+    for (size_t i = 0; i < vectors.size(); ++i)
+        index.add(i, 0, vectors[i].data());
+
+    const auto hits = index.search(vectors[0].data(), 10);
+    ASSERT_EQ(hits.size(), 10);
+    for (size_t h = 1; h < hits.size(); ++h)
+        EXPECT_GE(hits[h - 1].score, hits[h].score);
+}
+
+TEST_F(TestVectorIndex, ExcludesGroup) {
+    const auto vectors = makeVectors(100, 2);
+    VectorIndex index(dims);
+    for (size_t i = 0; i < vectors.size(); ++i)
+        index.add(i, i % 2 == 0 ? 1 : 2, vectors[i].data());
+
+    for (const auto &hit : index.search(vectors[0].data(), 20, 8, 1u))
+        EXPECT_EQ(index.group(hit.id), 2u);
+}
+
+TEST_F(TestVectorIndex, ReAddReplacesVector) {
+    const auto vectors = makeVectors(10, 10);
+    VectorIndex index(dims);
+    index.add(1, 0, vectors[0].data());
+    index.add(1, 0, vectors[5].data());
+
+    EXPECT_EQ(index.size(), 1);
+    EXPECT_EQ(index.search(vectors[5].data(), 1).front().id, 1);
+    EXPECT_NEAR(index.search(vectors[5].data(), 1).front().score, 1.0f, 1e-4f);
+}
+
+TEST_F(TestVectorIndex, IVFAgreesWithFlat) {
+    const auto vectors = makeVectors(4000, 20);
+    VectorIndex flat(dims), ivf(dims);
+    for (size_t i = 0; i < vectors.size(); ++i) {
+        flat.add(i, 0, vectors[i].data());
+        ivf.add(i, 0, vectors[i].data());
+    }
+
+    ivf.train(32, 8, 2000);
+    ASSERT_TRUE(ivf.isTrained());
+
+    // Added after training, these go straight into their bucket
+    const auto late = makeVectors(100, 20, 11);
+    for (size_t i = 0; i < late.size(); ++i) {
+        flat.add(10000 + i, 0, late[i].data());
+        ivf.add(10000 + i, 0, late[i].data());
+    }
+
+    int agree = 0, total = 0;
+    for (size_t i = 0; i < vectors.size(); i += 97, ++total) {
+        const auto a = flat.search(vectors[i].data(), 1);
+        const auto b = ivf.search(vectors[i].data(), 1, 4);
+        agree += (!b.empty() && a.front().id == b.front().id);
+    }
+    EXPECT_GE(agree, total * 9 / 10);
+    EXPECT_EQ(ivf.search(late[3].data(), 1, 4).front().id, 10003);
+}
+
+TEST_F(TestVectorIndex, SaveAndLoad) {
+    const auto vectors = makeVectors(300, 6);
+    VectorIndex index(dims);
+    for (size_t i = 0; i < vectors.size(); ++i)
+        index.add(100 + i, static_cast<uint32_t>(i % 3), vectors[i].data());
+    index.train(8);
+
+    const std::string path = "test/results/vectorindex.bin";
+    ASSERT_TRUE(index.save(path));
+
+    VectorIndex loaded;
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_EQ(loaded.dims(), dims);
+    EXPECT_EQ(loaded.size(), index.size());
+    EXPECT_TRUE(loaded.isTrained());
+    EXPECT_EQ(loaded.group(105), 2u);
+
+    const auto a = index.search(vectors[42].data(), 5, 8);
+    const auto b = loaded.search(vectors[42].data(), 5, 8);
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t h = 0; h < a.size(); ++h)
+        EXPECT_EQ(a[h].id, b[h].id);
+}
+
+TEST_F(TestVectorIndex, LoadRejectsGarbage) {
+    const std::string path = "test/results/vectorindex_garbage.bin";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "definitely not an index";
+    }
+
+    VectorIndex index;
+    EXPECT_FALSE(index.load(path));
+    EXPECT_FALSE(index.load("test/results/does_not_exist.bin"));
+}
+
+TEST_F(TestVectorIndex, LoadRejectsCorruptCountsAndDims) {
+    const auto vectors = makeVectors(20, 2);
+    VectorIndex index(dims);
+    for (size_t i = 0; i < vectors.size(); ++i)
+        index.add(i, 0, vectors[i].data());
+
+    const std::string path = "test/results/vectorindex_corrupt.bin";
+    ASSERT_TRUE(index.save(path));
+
+    VectorIndex loaded;
+    EXPECT_FALSE(loaded.load(path, dims * 2));
+    EXPECT_TRUE(loaded.load(path, dims));
+
+    // The count, after the magic, version and dims, claiming far more than the file holds
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(8 + 4 + 4);
+        const uint64_t count = uint64_t(1) << 40;
+        file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    }
+    EXPECT_FALSE(loaded.load(path));
+    // Left as it was
+    EXPECT_EQ(loaded.size(), 20u);
+
+    // Truncated
+    ASSERT_TRUE(index.save(path));
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+    EXPECT_FALSE(loaded.load(path));
+}